@@ -0,0 +1,55 @@
+#ifndef _h_onewire_port
+#define _h_onewire_port
+
+/*
+ * Compile-time port binding for the NUCLEO-F103RB example. To use it, define
+ * ONEWIRE_PORT_HEADER as "onewire_port.h" in onewire.h. Every pin and timer
+ * operation then compiles down to a single register access on GPIOA pin 9 and TIM4,
+ * instead of a callback calling HAL_GPIO_Init.
+ */
+
+#include "main.h"
+
+#define ONEWIRE_PORT_GPIO sensor_GPIO_Port
+#define ONEWIRE_PORT_PIN sensor_Pin
+#define ONEWIRE_PORT_PIN_NUMBER 9
+#define ONEWIRE_PORT_TIMER TIM4
+
+// Pin 9 is configured in CRH register, 4 bits per pin
+#define ONEWIRE_PORT_CR_SHIFT ((ONEWIRE_PORT_PIN_NUMBER - 8) * 4)
+#define ONEWIRE_PORT_CR_MASK (0x0FUL << ONEWIRE_PORT_CR_SHIFT)
+#define ONEWIRE_PORT_CR_OUTPUT (0x05UL << ONEWIRE_PORT_CR_SHIFT) // Open-drain output, 10 MHz
+#define ONEWIRE_PORT_CR_INPUT (0x04UL << ONEWIRE_PORT_CR_SHIFT) // Floating input
+
+static inline void onewirePortSetPinDir(const OneWire *ow, OneWire_PinDirection dir)
+{
+	(void)ow;
+	ONEWIRE_PORT_GPIO->CRH = (ONEWIRE_PORT_GPIO->CRH & ~ONEWIRE_PORT_CR_MASK) |
+			(dir == OneWire_PinDir_Output ? ONEWIRE_PORT_CR_OUTPUT : ONEWIRE_PORT_CR_INPUT);
+}
+
+static inline void onewirePortSetPinState(const OneWire *ow, OneWire_PinState state)
+{
+	(void)ow;
+	ONEWIRE_PORT_GPIO->BSRR = state == OneWire_PinState_High ? ONEWIRE_PORT_PIN : (uint32_t)ONEWIRE_PORT_PIN << 16;
+}
+
+static inline OneWire_PinState onewirePortReadPin(const OneWire *ow)
+{
+	(void)ow;
+	return (ONEWIRE_PORT_GPIO->IDR & ONEWIRE_PORT_PIN) ? OneWire_PinState_High : OneWire_PinState_Low;
+}
+
+static inline void onewirePortStartTimer(const OneWire *ow)
+{
+	(void)ow;
+	ONEWIRE_PORT_TIMER->CNT = 0;
+}
+
+static inline OneWire_Counter onewirePortReadTimer(const OneWire *ow)
+{
+	(void)ow;
+	return ONEWIRE_PORT_TIMER->CNT;
+}
+
+#endif
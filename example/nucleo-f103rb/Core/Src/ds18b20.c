@@ -1,12 +1,34 @@
 #include "ds18b20.h"
 
-// Private functions
+// Private data
+
+/** @def DS18B20_RX_READ_MODE operation reads number of bytes given by `readMode` */
+#define DS18B20_RX_READ_MODE 0xFF
 
-static inline void clearbuffer(DS18B20 *ds)
+/**
+ * @brief Bus transaction of a single operation - command preceded by ROM selection, and what follows it
+ */
+typedef struct DS18B20_Operation
 {
-	for (DS18B20_Size i = 0; i < sizeof(ds->buffer); ++i)
-		ds->buffer[i] = 0;
-}
+	DS18B20_Byte command;			/**< Function command, DS18B20_READ_ROM is sent without ROM selection */
+	DS18B20_Size rxLength;			/**< Number of bytes read after the command, or DS18B20_RX_READ_MODE */
+	OneWire_Counter pullup;			/**< Strong pullup hold after the command [us] */
+	OneWire_Byte stop;				/**< Additional transaction stop rules */
+} DS18B20_Operation;
+
+static const DS18B20_Operation ds18b20_operations[] = {
+	[DS18b20_State_Convert] =			{ DS18B20_CONVERT, 0, 0, 0 },
+	[DS18b20_State_ReadScratchpad] =	{ DS18B20_READ_SCRATCHPAD, DS18B20_RX_READ_MODE, 0, 0 },
+	[DS18b20_State_ReadRom] =			{ DS18B20_READ_ROM, sizeof(DS18B20_Address), 0, 0 },
+	[DS18b20_State_WriteScratchpad] =	{ DS18B20_WRITE_SCRATCHPAD, 0, 0, 0 },
+	[DS18b20_State_CopyScratchpad] =	{ DS18B20_COPY_SCRATCHPAD, 0, DS18B20_COPY_TIME, 0 },
+	// Sensor answers read slots with zeros until EEPROM is recalled
+	[DS18b20_State_RecallEeprom] =		{ DS18B20_RECALL_EEPROM, DS18B20_BUFFER_SIZE, 0, ONEWIRE_STOP_NONZERO },
+	// Answer is a single read slot after the transaction, parasite powered sensors pull it low
+	[DS18b20_State_ReadPowersupply] =	{ DS18B20_READ_POWER_SUPPLY, 0, 0, 0 }
+};
+
+// Private functions
 
 static inline DS18B20_Size cpy(DS18B20_Byte *target, const DS18B20_Byte *source, DS18B20_Size length)
 {
@@ -15,37 +37,36 @@ static inline DS18B20_Size cpy(DS18B20_Byte *target, const DS18B20_Byte *source,
 	return length;
 }
 
-static inline DS18B20_Bool ds_timerPassed(DS18B20 *ds, unsigned int threshold)
+static inline DS18B20_Time ds_timerPeek(const DS18B20 *ds)
 {
-	static unsigned int passedMillis;
-	unsigned int t = ds->oneWire->readTimer(ds->oneWire);
+	return ds->timerElapsed + (OneWire_Counter)(onewireReadTimer(ds->oneWire) - ds->timerLast);
+}
 
-	if (t >= 1000)
-	{
-		ds->oneWire->startTimer(ds->oneWire);
-		++passedMillis;
-	}
+static inline void ds_timerRestart(DS18B20 *ds)
+{
+	ds->timerElapsed = 0;
+	ds->timerLast = onewireReadTimer(ds->oneWire);
+}
+
+static inline DS18B20_Bool ds_timerPassed(DS18B20 *ds, DS18B20_Time threshold)
+{
+	// Counter is never restarted by the driver - its difference is folded into the instance's own accumulator. Without
+	// ONEWIRE_FREE_RUNNING_TIMER the bus restarts the counter for its own slots, so drivers sharing a bus must not wait concurrently
+	OneWire_Counter now = onewireReadTimer(ds->oneWire);
+	ds->timerElapsed += (OneWire_Counter)(now - ds->timerLast);
+	ds->timerLast = now;
 
-	unsigned int mil = threshold / 1000;
-	unsigned int mic = threshold - mil * 1000;
-	if (passedMillis >= mil && t >= mic)
+	if (ds_timerPeek(ds) < threshold)
 	{
-		passedMillis = 0;
-		return DS18B20_True;
+		ds->waitTime = threshold;
+		return DS18B20_False;
 	}
 
-	return DS18B20_False;
-}
-
-static inline void ds18b20write(DS18B20 *ds, const DS18B20_Byte *data, DS18B20_Size length)
-{
-	DS18B20_Size len = length > sizeof(ds->buffer) ? sizeof(ds->buffer) : length;
-	for (DS18B20_Size i = 0; i < len; ++i)
-		ds->buffer[i] = data[i];
-	onewireWrite(ds->oneWire, ds->buffer, len);
+	ds->waitTime = 0;
+	return DS18B20_True;
 }
 
-static inline DS18B20_Size ds18b20prepareBuffer(DS18B20 *ds, DS18B20_Byte dsCmd, DS18B20_Address romAddress, DS18B20_Size paramCount, DS18B20_Byte *params)
+static inline DS18B20_Size ds18b20prepareBuffer(DS18B20 *ds, DS18B20_Byte dsCmd, DS18B20_Address romAddress, DS18B20_Size paramCount, const DS18B20_Byte *params)
 {
 	DS18B20_Size i = 0;
 	ds->buffer[i++] = romAddress ? DS18B20_MATCH_ROM : DS18B20_SKIP_ROM;
@@ -58,380 +79,237 @@ static inline DS18B20_Size ds18b20prepareBuffer(DS18B20 *ds, DS18B20_Byte dsCmd,
 	return i;
 }
 
-static inline void ds18b20writeCommand(DS18B20 *ds, DS18B20_Byte dsCmd, DS18B20_Address romAddress, DS18B20_Size paramCount, DS18B20_Byte *params)
+static void ds18b20prepare(DS18B20 *ds, DS18b20State operation, DS18B20_Address address, DS18B20_Size paramCount, const DS18B20_Byte *params)
 {
-	DS18B20_Size size = ds18b20prepareBuffer(ds, dsCmd, romAddress, paramCount, params);
-	onewireWrite(ds->oneWire, ds->buffer, size);
-}
+	const DS18B20_Operation *op = &ds18b20_operations[operation];
+	OneWire_Transaction *t = &ds->transaction;
 
-static inline DS18B20_Time ds18b20conversionTime(const DS18B20 *ds)
-{
-	switch(ds->resolution)
+	if (op->command == DS18B20_READ_ROM)
 	{
-	case DS18B20_Resolution_9: return DS18B20_WAIT_RES9;
-	case DS18B20_Resolution_10: return DS18B20_WAIT_RES10;
-	case DS18B20_Resolution_11: return DS18B20_WAIT_RES11;
-	case DS18B20_Resolution_12: return DS18B20_WAIT_RES12;
+		ds->buffer[0] = DS18B20_READ_ROM;
+		t->txLength = 1;
 	}
-
-	return 0;
+	else
+		t->txLength = ds18b20prepareBuffer(ds, op->command, address, paramCount, params);
+
+	// Read bytes replace the command in the buffer, it has been sent by then
+	t->reset = OneWire_True;
+	t->tx = ds->buffer;
+	t->rx = ds->buffer;
+	t->rxLength = op->rxLength == DS18B20_RX_READ_MODE ? ds->readMode : op->rxLength;
+	t->pullup = op->pullup;
+	t->stop = ONEWIRE_STOP_NO_PRESENCE | op->stop;
+
+	ds->currentAddress = address;
+	ds->transactionState = DS18b20_Transaction_Begin;
+	ds->convertState = DS18b20_Convert_Command;
+	ds->error = DS18b20_Success;
+	ds->waitTime = 0;
 }
 
-// CONVERT
-
-static void processConvert(DS18B20 *ds)
+static OneWire_Result ds18b20transact(DS18B20 *ds)
 {
-	switch(ds->substate.convertState)
+	if (ds->transactionState == DS18b20_Transaction_Begin)
 	{
-	case DS18b20_Convert_Begin:
-		onewireStart(ds->oneWire);
-		ds->substate.convertState = DS18b20_Convert_Start;
-		break;
-
-	case DS18b20_Convert_Start:
-	{
-		OneWire_Result res = onewireProcess(ds->oneWire);
-		if (res == OneWire_Success)
-		{
-			ds->substate.convertState = DS18b20_Convert_Write;
-			ds->oneWire->startTimer(ds->oneWire);
-		}
-		else if (res == OneWire_Failed)
-		{
-			ds->substate.convertState = DS18b20_Convert_Begin;
-		}
+		onewireTransact(ds->oneWire, &ds->transaction);
+		ds->transactionState = DS18b20_Transaction_Running;
 	}
-		break;
 
-	case DS18b20_Convert_Write:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20writeCommand(ds, DS18B20_CONVERT, ds->currentAddress, 0, 0);
+	OneWire_Result res = onewireProcess(ds->oneWire);
+	if (res == OneWire_Success || res == OneWire_Failed)
+		ds->transactionState = DS18b20_Transaction_Begin;
 
-			ds->substate.convertState = DS18b20_Convert_Processing;
-		}
-		break;
+	if (res == OneWire_Failed)
+		ds->error = DS18b20_Error;
 
-	case DS18b20_Convert_Processing:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.convertState = DS18b20_Convert_Delay;
-			ds->oneWire->startTimer(ds->oneWire);
-		}
-		break;
-
-	case DS18b20_Convert_Delay:
-		if (ds_timerPassed(ds, ds18b20conversionTime(ds)))
-		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.convertState = DS18b20_Convert_Begin;
-
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_Convert, DS18B20_ROM_NONE, DS18B20_Callback_Normal);
-
-			ds->currentAddress = DS18B20_ROM_NONE;
-		}
-		break;
-	}
+	return res;
 }
 
-// READ SCRATCHPAD
-
-static void processReadScratchpad(DS18B20 *ds)
+static inline DS18B20_Time ds18b20conversionTime(const DS18B20 *ds)
 {
-	switch(ds->substate.scratchpadState)
-	{
-	case DS18b20_Scratchpad_Begin:
-		onewireStart(ds->oneWire);
-		ds->substate.scratchpadState = DS18b20_Scratchpad_Start;
-		break;
-
-	case DS18b20_Scratchpad_Start:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Write;
-			ds->oneWire->startTimer(ds->oneWire);
-		}
-		break;
-
-	case DS18b20_Scratchpad_Write:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20writeCommand(ds, DS18B20_READ_SCRATCHPAD, ds->currentAddress, 0, 0);
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Processing;
-		}
-		break;
-
-	case DS18b20_Scratchpad_Processing:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Reading;
-
-			clearbuffer(ds);
-			onewireRead(ds->oneWire, ds->buffer, ds->readMode);
-		}
-		break;
+	return ds18b20GetConversionTime(ds->resolution);
+}
 
-	case DS18b20_Scratchpad_Reading:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Begin;
+static void ds18b20operationFinished(DS18B20 *ds, DS18b20State operation, DS18B20_Address address, DS18B20CallbackFlags flags)
+{
+	ds->state = DS18b20_State_Finished;
 
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_ReadScratchpad, ds->currentAddress, DS18B20_Callback_Normal);
+	if (ds->onOperationFinished)
+		ds->onOperationFinished(ds, operation, address, flags);
 
-			ds->currentAddress = DS18B20_ROM_NONE;
-		}
-		break;
-	}
+	ds->currentAddress = DS18B20_ROM_NONE;
 }
 
-// WRITE SCRATCHPAD
+// CONVERT
 
-static void processWriteScratchpad(DS18B20 *ds)
+static DS18B20_Bool stepConvert(DS18B20 *ds)
 {
-	switch(ds->substate.scratchpadState)
+	switch(ds->convertState)
 	{
-	case DS18b20_Scratchpad_Reading:
-		// Ignore
-		break;
+	case DS18b20_Convert_Command:
+	{
+		OneWire_Result res = ds18b20transact(ds);
+		if (res == OneWire_Failed)
+			return DS18B20_True;
 
-	case DS18b20_Scratchpad_Begin:
-		onewireStart(ds->oneWire);
-		ds->substate.scratchpadState = DS18b20_Scratchpad_Start;
-		break;
+		if (res != OneWire_Success)
+			break;
 
-	case DS18b20_Scratchpad_Start:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Write;
-			ds->oneWire->startTimer(ds->oneWire);
-		}
+		if (ds->convertMode == DS18b20_ConvertMode_NoWait)
+			return DS18B20_True;
+
+		ds->convertState = DS18b20_Convert_Delay;
+		ds->convertElapsed = 0;
+		ds_timerRestart(ds);
+	}
 		break;
 
-	case DS18b20_Scratchpad_Write:
-		if (ds_timerPassed(ds, 1000))
+	case DS18b20_Convert_Delay:
+		if (ds->convertMode == DS18b20_ConvertMode_Poll)
 		{
-			onewireWrite(ds->oneWire, ds->buffer, ds->datalen);
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Processing;
+			if (ds_timerPassed(ds, ds->convertPollInterval))
+			{
+				// Sensor holds read slots low until conversion is done
+				ds->convertElapsed += ds->convertPollInterval;
+				ds->temp = 0;
+				onewireReadBit(ds->oneWire, &ds->temp);
+				ds->convertState = DS18b20_Convert_Polling;
+			}
 		}
+		else if (ds_timerPassed(ds, ds18b20conversionTime(ds)))
+			return DS18B20_True;
 		break;
 
-	case DS18b20_Scratchpad_Processing:
+	case DS18b20_Convert_Polling:
 		if (onewireProcess(ds->oneWire) == OneWire_Success)
 		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.scratchpadState = DS18b20_Scratchpad_Begin;
-
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_WriteScratchpad, DS18B20_ROM_NONE, DS18B20_Callback_Normal);
+			// Worst-case conversion time is the timeout
+			if (ds->temp || ds->convertElapsed >= ds18b20conversionTime(ds))
+				return DS18B20_True;
 
-			ds->currentAddress = DS18B20_ROM_NONE;
+			ds->convertState = DS18b20_Convert_Delay;
+			ds_timerRestart(ds);
 		}
 		break;
 	}
-}
 
-// READ ROM
+	return DS18B20_False;
+}
 
-static void processReadROM(DS18B20 *ds)
+static void processConvert(DS18B20 *ds)
 {
-	switch(ds->substate.readRomState)
-	{
-	case DS18b20_ReadROM_Start:
-		{
-			OneWire_Result owres = onewireProcess(ds->oneWire);
-			if (owres == OneWire_NothingToDo)
-				onewireStart(ds->oneWire);
-			else if (owres == OneWire_Success)
-			{
-				ds->substate.readRomState = DS18b20_ReadROM_Writing;
-				ds->oneWire->startTimer(ds->oneWire);
-			}
-		}
-		break;
-
-	case DS18b20_ReadROM_Writing:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20write(ds, (DS18B20_Byte[1]){ DS18B20_READ_ROM }, 1);
-			ds->substate.readRomState = DS18b20_ReadROM_Process;
-		}
-		break;
-
-	case DS18b20_ReadROM_Process:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.readRomState = DS18b20_ReadROM_Reading;
+	if (stepConvert(ds))
+		ds18b20operationFinished(ds, DS18b20_State_Convert, ds->currentAddress, DS18B20_Callback_Normal);
+}
 
-			clearbuffer(ds);
-			onewireRead(ds->oneWire, ds->buffer, sizeof(DS18B20_Address));
-		}
-		break;
+// READ SCRATCHPAD
 
-	case DS18b20_ReadROM_Reading:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.readRomState = DS18b20_ReadROM_Start;
+static DS18B20_Bool stepReadScratchpad(DS18B20 *ds)
+{
+	OneWire_Result res = ds18b20transact(ds);
 
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_ReadRom, DS18B20_ROM_NONE, DS18B20_Callback_Normal);
+	if (res == OneWire_Success && ds->readMode == DS18b20_Read_CRC && onewireGetCrc(ds->oneWire) != 0)
+		ds->error = DS18b20_Error_CRC;
 
-			ds->currentAddress = DS18B20_ROM_NONE;
-		}
-		break;
-	}
+	return res == OneWire_Success || res == OneWire_Failed;
 }
 
-// COPY SCRATCHPAD
+// SAMPLE
 
-static void processCopyScratchpad(DS18B20 *ds)
+static void processSample(DS18B20 *ds)
 {
-	switch(ds->substate.copyScratchpadState)
+	switch(ds->sampleState)
 	{
-	case DS18b20_CopyScratchpad_Start:
-		{
-			OneWire_Result owres = onewireProcess(ds->oneWire);
-			if (owres == OneWire_NothingToDo)
-				onewireStart(ds->oneWire);
-			else if (owres == OneWire_Success)
-			{
-				ds->substate.copyScratchpadState = DS18b20_CopyScratchpad_Writing;
-				ds->oneWire->startTimer(ds->oneWire);
-			}
-		}
-		break;
+	case DS18b20_Sample_Convert:
+		// Single broadcast conversion of all sensors
+		if (!stepConvert(ds))
+			break;
 
-	case DS18b20_CopyScratchpad_Writing:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20writeCommand(ds, DS18B20_COPY_SCRATCHPAD, ds->currentAddress, 0, 0);
-			ds->substate.copyScratchpadState = DS18b20_CopyScratchpad_Process;
-		}
+		ds->sampleIndex = 0;
+		ds->sampleState = DS18b20_Sample_Read;
+		ds18b20prepare(ds, DS18b20_State_ReadScratchpad, ds->sampleTable->roms[0], 0, 0);
 		break;
 
-	case DS18b20_CopyScratchpad_Process:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->substate.copyScratchpadState = DS18b20_CopyScratchpad_Wait;
-			ds->oneWire->startTimer(ds->oneWire);
-		}
-		break;
+	case DS18b20_Sample_Read:
+		if (!stepReadScratchpad(ds))
+			break;
 
-	case DS18b20_CopyScratchpad_Wait:
-		if (ds_timerPassed(ds, 20000))
-		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.copyScratchpadState = DS18b20_CopyScratchpad_Start;
-
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_CopyScratchpad, ds->currentAddress, DS18B20_Callback_Normal);
+		ds18b20GetReading(ds, &ds->sampleReadings[ds->sampleIndex]);
 
-			ds->currentAddress = DS18B20_ROM_NONE;
+		if (++ds->sampleIndex >= ds->sampleTable->count)
+		{
+			ds18b20operationFinished(ds, DS18b20_State_Sample, DS18B20_ROM_NONE, DS18B20_Callback_Normal);
+			break;
 		}
+
+		ds18b20prepare(ds, DS18b20_State_ReadScratchpad, ds->sampleTable->roms[ds->sampleIndex], 0, 0);
 		break;
 	}
 }
 
-// RECALL EEPROM
+// READ POWER SUPPLY
 
-static void processRecallEeprom(DS18B20 *ds)
+static DS18B20_Bool stepReadPowersupply(DS18B20 *ds)
 {
-	switch(ds->substate.recallEepromState)
+	if (ds->transactionState != DS18b20_Transaction_ReadBit)
 	{
-	case DS18b20_RecallEeprom_Start:
-		{
-			OneWire_Result owres = onewireProcess(ds->oneWire);
-			if (owres == OneWire_NothingToDo)
-				onewireStart(ds->oneWire);
-			else if (owres == OneWire_Success)
-			{
-				ds->substate.recallEepromState = DS18b20_RecallEeprom_Writing;
-				ds->oneWire->startTimer(ds->oneWire);
-			}
-		}
-		break;
+		OneWire_Result res = ds18b20transact(ds);
+		if (res == OneWire_Failed)
+			return DS18B20_True;
 
-	case DS18b20_RecallEeprom_Writing:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20writeCommand(ds, DS18B20_RECALL_EEPROM, ds->currentAddress, 0, 0);
-			ds->substate.recallEepromState = DS18b20_RecallEeprom_Process;
-			ds->temp = 0;
-		}
-		break;
+		if (res != OneWire_Success)
+			return DS18B20_False;
 
-	case DS18b20_RecallEeprom_Process:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			if (ds->temp)
-			{
-				ds->state = DS18b20_State_Finished;
-				ds->substate.recallEepromState = DS18b20_RecallEeprom_Start;
+		ds->temp = 0;
+		onewireReadBit(ds->oneWire, &ds->temp);
+		ds->transactionState = DS18b20_Transaction_ReadBit;
+	}
 
-				if (ds->onOperationFinished)
-					ds->onOperationFinished(ds, DS18b20_State_RecallEeprom, ds->currentAddress, DS18B20_Callback_Normal);
+	OneWire_Result res = onewireProcess(ds->oneWire);
+	if (res != OneWire_Success && res != OneWire_Failed)
+		return DS18B20_False;
 
-				ds->currentAddress = DS18B20_ROM_NONE;
-			}
-			else
-				onewireRead(ds->oneWire, &ds->temp, sizeof(ds->temp));
-		}
-		break;
-	}
+	ds->transactionState = DS18b20_Transaction_Begin;
+	return DS18B20_True;
 }
 
-// READ POWER SUPPLY
+// SINGLE TRANSACTION OPERATIONS
 
-static void processReadPowerSupply(DS18B20 *ds)
+static void processOperation(DS18B20 *ds)
 {
-	switch(ds->substate.powerSupplyState)
-	{
-	case DS18b20_ReadPowerSupply_Start:
-		{
-			OneWire_Result owres = onewireProcess(ds->oneWire);
-			if (owres == OneWire_NothingToDo)
-				onewireStart(ds->oneWire);
-			else if (owres == OneWire_Success)
-			{
-				ds->substate.powerSupplyState = DS18b20_ReadPowerSupply_Writing;
-				ds->oneWire->startTimer(ds->oneWire);
-			}
-		}
-		break;
+	DS18B20CallbackFlags flags = DS18B20_Callback_Normal;
 
-	case DS18b20_ReadPowerSupply_Writing:
-		if (ds_timerPassed(ds, 1000))
-		{
-			ds18b20writeCommand(ds, DS18B20_RECALL_EEPROM, ds->currentAddress, 0, 0);
-			ds->substate.powerSupplyState = DS18b20_ReadPowerSupply_Process;
-			ds->temp = 0;
-		}
-		break;
+	if (ds->state == DS18b20_State_ReadScratchpad)
+	{
+		if (!stepReadScratchpad(ds))
+			return;
+	}
+	else if (ds->state == DS18b20_State_ReadPowersupply)
+	{
+		if (!stepReadPowersupply(ds))
+			return;
 
-	case DS18b20_ReadPowerSupply_Process:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			onewireRead(ds->oneWire, &ds->temp, sizeof(ds->temp));
-			ds->substate.powerSupplyState = DS18b20_ReadPowerSupply_Read;
-		}
-		break;
+		if (ds->error == DS18b20_Success)
+			flags = ds->temp & 0x01 ? DS18B20_Callback_NoParasitic : DS18B20_Callback_Parasitic;
+	}
+	else
+	{
+		OneWire_Result res = ds18b20transact(ds);
+		if (res != OneWire_Success && res != OneWire_Failed)
+			return;
+	}
 
-	case DS18b20_ReadPowerSupply_Read:
-		if (onewireProcess(ds->oneWire) == OneWire_Success)
-		{
-			ds->state = DS18b20_State_Finished;
-			ds->substate.powerSupplyState = DS18b20_ReadPowerSupply_Start;
+	ds18b20operationFinished(ds, ds->state, ds->currentAddress, flags);
+}
 
-			if (ds->onOperationFinished)
-				ds->onOperationFinished(ds, DS18b20_State_ReadPowersupply, ds->currentAddress, ds->temp == 0 ? DS18B20_Callback_Parasitic : DS18B20_Callback_NoParasitic);
+static DS18B20Result ds18b20request(DS18B20 *ds, DS18b20State operation, DS18B20_Address address, DS18B20_Size paramCount, const DS18B20_Byte *params)
+{
+	if (ds->state != DS18b20_State_Idle && ds->state != DS18b20_State_Finished)
+		return DS18B20_Result_Busy;
 
-			ds->currentAddress = DS18B20_ROM_NONE;
-		}
-		break;
-	}
+	ds18b20prepare(ds, operation, address, paramCount, params);
+	ds->state = operation;
+	return DS18B20_Result_Ok;
 }
 
 // Functions
@@ -440,6 +318,8 @@ void ds18b20Init(DS18B20 *ds, OneWire *ow)
 {
 	ds->oneWire = ow;
 	ds->resolution = DS18B20_Resolution_12;
+	ds->convertMode = DS18b20_ConvertMode_Wait;
+	ds->convertPollInterval = DS18B20_CONVERT_POLL_INTERVAL;
 }
 
 DS18b20State ds18b20Process(DS18B20 *ds)
@@ -448,6 +328,7 @@ DS18b20State ds18b20Process(DS18B20 *ds)
 	{
 	case DS18b20_State_Finished:
 	case DS18b20_State_Idle:
+	case DS18b20_State_Searching:
 		// Ignore
 		break;
 
@@ -456,80 +337,82 @@ DS18b20State ds18b20Process(DS18B20 *ds)
 		break;
 
 	case DS18b20_State_ReadScratchpad:
-		processReadScratchpad(ds);
-		break;
-
 	case DS18b20_State_WriteScratchpad:
-		processWriteScratchpad(ds);
-		break;
-
 	case DS18b20_State_ReadRom:
-		processReadROM(ds);
-		break;
-
 	case DS18b20_State_CopyScratchpad:
-		processCopyScratchpad(ds);
-		break;
-
 	case DS18b20_State_RecallEeprom:
-		processRecallEeprom(ds);
+	case DS18b20_State_ReadPowersupply:
+		processOperation(ds);
 		break;
 
-	case DS18b20_State_ReadPowersupply:
-		processReadPowerSupply(ds);
+	case DS18b20_State_Sample:
+		processSample(ds);
 		break;
 	}
 
 	return ds->state;
 }
 
-DS18B20Result ds18b20BeginConversion(DS18B20 *ds, DS18B20_Address address)
+DS18B20_Time ds18b20TimeToService(const DS18B20 *ds)
 {
 	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->currentAddress = address;
-		ds->state = DS18b20_State_Convert;
-		return DS18B20_Result_Ok;
-	}
+		return DS18B20_SERVICE_NONE;
 
-	return DS18B20_Result_Busy;
+	if (ds->oneWire->state != OneWire_Idle)
+		return onewireTimeToService(ds->oneWire);
+
+	// State about to issue next bus operation, or waiting state not yet entered
+	if (!ds->waitTime)
+		return 0;
+
+	DS18B20_Time elapsed = ds_timerPeek(ds);
+	if (elapsed >= ds->waitTime)
+		return 0;
+
+	// Timer has to be read again before its counter wraps
+	DS18B20_Time remaining = ds->waitTime - elapsed;
+	return remaining < DS18B20_SERVICE_MAX_SLEEP ? remaining : DS18B20_SERVICE_MAX_SLEEP;
 }
 
-DS18B20Result ds18b20ReadScratchpad(DS18B20 *ds, DS18B20_Address address)
+DS18B20Result ds18b20BeginConversion(DS18B20 *ds, DS18B20_Address address)
 {
-	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->currentAddress = address;
-		ds->state = DS18b20_State_ReadScratchpad;
-		return DS18B20_Result_Ok;
-	}
-
-	return DS18B20_Result_Busy;
+	return ds18b20request(ds, DS18b20_State_Convert, address, 0, 0);
 }
 
-DS18B20Result ds18b20RequestReadRom(DS18B20 *ds)
+DS18B20Result ds18b20Sample(DS18B20 *ds, const OneWire_RomTable *table, DS18B20_Reading *readings)
 {
 	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
 	{
-		ds->state = DS18b20_State_ReadRom;
+		if (!table->count)
+		{
+			ds18b20operationFinished(ds, DS18b20_State_Sample, DS18B20_ROM_NONE, DS18B20_Callback_Normal);
+			return DS18B20_Result_Ok;
+		}
+
+		ds18b20prepare(ds, DS18b20_State_Convert, DS18B20_ROM_NONE, 0, 0);
+		ds->sampleTable = table;
+		ds->sampleReadings = readings;
+		ds->sampleState = DS18b20_Sample_Convert;
+		ds->state = DS18b20_State_Sample;
 		return DS18B20_Result_Ok;
 	}
 
 	return DS18B20_Result_Busy;
 }
 
-DS18B20Result ds18b20WriteScratchpad(DS18B20 *ds, DS18B20_Byte *bytes, DS18B20_Size count, DS18B20_Address address)
+DS18B20Result ds18b20ReadScratchpad(DS18B20 *ds, DS18B20_Address address)
 {
-	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->currentAddress = address;
-		ds->datalen = ds18b20prepareBuffer(ds, DS18B20_WRITE_SCRATCHPAD, address, count, bytes);
+	return ds18b20request(ds, DS18b20_State_ReadScratchpad, address, 0, 0);
+}
 
-		ds->state = DS18b20_State_WriteScratchpad;
-		return DS18B20_Result_Ok;
-	}
+DS18B20Result ds18b20RequestReadRom(DS18B20 *ds)
+{
+	return ds18b20request(ds, DS18b20_State_ReadRom, DS18B20_ROM_NONE, 0, 0);
+}
 
-	return DS18B20_Result_Busy;
+DS18B20Result ds18b20WriteScratchpad(DS18B20 *ds, DS18B20_Byte *bytes, DS18B20_Size count, DS18B20_Address address)
+{
+	return ds18b20request(ds, DS18b20_State_WriteScratchpad, address, count, bytes);
 }
 
 DS18B20Result ds18b20SetResolution(DS18B20 *ds, DS18B20Resolution resolution, DS18B20_Byte *userbytes, DS18B20_Address address)
@@ -547,35 +430,17 @@ DS18B20Result ds18b20SetResolution(DS18B20 *ds, DS18B20Resolution resolution, DS
 
 DS18B20Result ds18b20CopyScratchpad(DS18B20 *ds, DS18B20_Address address)
 {
-	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->state = DS18b20_State_CopyScratchpad;
-		return DS18B20_Result_Ok;
-	}
-
-	return DS18B20_Result_Busy;
+	return ds18b20request(ds, DS18b20_State_CopyScratchpad, address, 0, 0);
 }
 
 DS18B20Result ds18b20RecallEeprom(DS18B20 *ds, DS18B20_Address address)
 {
-	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->state = DS18b20_State_RecallEeprom;
-		return DS18B20_Result_Ok;
-	}
-
-	return DS18B20_Result_Busy;
+	return ds18b20request(ds, DS18b20_State_RecallEeprom, address, 0, 0);
 }
 
 DS18B20Result ds18b20ReadPowerSupply(DS18B20 *ds)
 {
-	if (ds->state == DS18b20_State_Idle || ds->state == DS18b20_State_Finished)
-	{
-		ds->state = DS18b20_State_ReadPowersupply;
-		return DS18B20_Result_Ok;
-	}
-
-	return DS18B20_Result_Busy;
+	return ds18b20request(ds, DS18b20_State_ReadPowersupply, DS18B20_ROM_NONE, 0, 0);
 }
 
 //DS18B20Result ds18b20Search(DS18B20 *ds);
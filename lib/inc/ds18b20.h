@@ -29,11 +29,23 @@ typedef uint64_t DS18B20_Address;
 
 #define DS18B20_FAMILY_CODE 0x28
 
+/** @def DS18B20_SERVICE_NONE time to service reported when no operation is in progress */
+#define DS18B20_SERVICE_NONE ((DS18B20_Time)~0)
+
+/** @def DS18B20_SERVICE_MAX_SLEEP longest reported time to service [us], half of timer counter range */
+#define DS18B20_SERVICE_MAX_SLEEP ((DS18B20_Time)((OneWire_Counter)~0 >> 1))
+
 #define DS18B20_WAIT_RES9 95000
 #define DS18B20_WAIT_RES10 190000
 #define DS18B20_WAIT_RES11 400000
 #define DS18B20_WAIT_RES12 800000
 
+/** @def DS18B20_CONVERT_POLL_INTERVAL default interval between conversion state polls [us] */
+#define DS18B20_CONVERT_POLL_INTERVAL 10000
+
+/** @def DS18B20_COPY_TIME time the bus is held high while scratchpad is being copied to EEPROM [us] */
+#define DS18B20_COPY_TIME 20000
+
 // DS18B20 commands
 
 #define DS18B20_SEARCH_ROM 0xF0
@@ -72,6 +84,16 @@ typedef enum DS18B20CallbackFlags
 	DS18B20_Callback_Parasitic			/**< At least one parasitic-powered device found */
 }DS18B20CallbackFlags;
 
+/**
+ * @brief Conversion completion detection modes
+ */
+typedef enum DS18b20ConvertMode
+{
+	DS18b20_ConvertMode_Wait,		/**< Wait worst-case conversion time for configured resolution */
+	DS18b20_ConvertMode_Poll,		/**< Poll read time slots until the sensor reports finished conversion - external power only */
+	DS18b20_ConvertMode_NoWait		/**< Finish once the command is sent, caller takes care of conversion time */
+} DS18b20ConvertMode;
+
 /**
  * @brief DS18B20 result enumeration
  */
@@ -114,65 +136,40 @@ typedef enum DS18b20State
 	DS18b20_State_RecallEeprom,   	/**< EEPROM is being copied to the scratchpad */
 	DS18b20_State_ReadPowersupply,  /**< Powersupply test is in progress */
 	DS18b20_State_Finished,        	/**< An operation has been finished and no job is currently running */
-	DS18b20_State_Searching			/**< Device search is in progress */
+	DS18b20_State_Searching,		/**< Device search is in progress */
+	DS18b20_State_Sample			/**< Sampling cycle over a ROM table is in progress */
 } DS18b20State;
 
 // Sub status enums
 
-typedef enum DS18b20ConvertState
+typedef enum DS18b20TransactionState
 {
-	DS18b20_Convert_Begin,
-	DS18b20_Convert_Start,
-	DS18b20_Convert_Write,
-	DS18b20_Convert_Processing,
-	DS18b20_Convert_Delay
-} DS18b20ConvertState;
+	DS18b20_Transaction_Begin,
+	DS18b20_Transaction_Running,
+	DS18b20_Transaction_ReadBit
+} DS18b20TransactionState;
 
-typedef enum DS18b20ScratchpadState
-{
-	DS18b20_Scratchpad_Begin,
-	DS18b20_Scratchpad_Start,
-	DS18b20_Scratchpad_Write,
-	DS18b20_Scratchpad_Processing,
-	DS18b20_Scratchpad_Reading
-} DS18b20ScratchpadState;
-
-typedef enum DS18b20ReadDataState
-{
-	DS18b20_ReadData_Start,
-	DS18b20_ReadData_Reading
-} DS18b20ReadDataState;
-
-typedef enum DS18b20ReadROMState
-{
-	DS18b20_ReadROM_Start,
-	DS18b20_ReadROM_Writing,
-	DS18b20_ReadROM_Process,
-	DS18b20_ReadROM_Reading
-} DS18b20ReadROMState;
-
-typedef enum DS18b20CopyScratchpadState
+typedef enum DS18b20ConvertState
 {
-	DS18b20_CopyScratchpad_Start,
-	DS18b20_CopyScratchpad_Writing,
-	DS18b20_CopyScratchpad_Process,
-	DS18b20_CopyScratchpad_Wait
-} DS18b20CopyScratchpadState;
+	DS18b20_Convert_Command,
+	DS18b20_Convert_Delay,
+	DS18b20_Convert_Polling
+} DS18b20ConvertState;
 
-typedef enum DS18b20RecallEepromState
+typedef enum DS18b20SampleState
 {
-	DS18b20_RecallEeprom_Start,
-	DS18b20_RecallEeprom_Writing,
-	DS18b20_RecallEeprom_Process
-} DS18b20RecallEepromState;
+	DS18b20_Sample_Convert,
+	DS18b20_Sample_Read
+} DS18b20SampleState;
 
-typedef enum DS18b20ReadPowerSupplyState
+/**
+ * @brief Result of a single sensor read by sampling cycle
+ */
+typedef struct DS18B20_Reading
 {
-	DS18b20_ReadPowerSupply_Start,
-	DS18b20_ReadPowerSupply_Writing,
-	DS18b20_ReadPowerSupply_Process,
-	DS18b20_ReadPowerSupply_Read
-} DS18b20ReadPowerSupplyState;
+	int16_t raw;										/**< Raw temperature register, 1/16 degree Celsius per LSB */
+	DS18b20Error error;									/**< DS18b20_Error_CRC when read with DS18b20_Read_CRC mode and CRC did not match, DS18b20_Error when sensor did not answer */
+} DS18B20_Reading;
 
 // Forward declarations
 
@@ -191,20 +188,6 @@ typedef void(*DS18B20_Callback)(DS18B20 *ds, DS18b20State operation, DS18B20_Add
 
 // Primary struct
 
-/**
- * @brief Union holding DS18B20 operation state
- */
-typedef union DS18B20SubState
-{
-	DS18b20ConvertState convertState;					/**< Status of conversion */
-	DS18b20ScratchpadState scratchpadState;				/**< Status of scratchpad read */
-	DS18b20ReadROMState readRomState;					/**< Status of ROM read */
-	DS18b20ReadDataState readState;						/**< Status of data read */
-	DS18b20CopyScratchpadState copyScratchpadState;		/**< Status of scratchpad copy */
-	DS18b20RecallEepromState recallEepromState;			/**< Status of eeprom read */
-	DS18b20ReadPowerSupplyState powerSupplyState;		/**< Status of power supply read */
-} DS18B20SubState;
-
 /**
  * @brief Primary DS18B20 structure
  */
@@ -217,13 +200,27 @@ typedef struct DS18B20
 	DS18B20_Address currentAddress;						/**< Currently used ROM address, change this value to poll different sensors, or set it to DS18B20_ROM_NONE to skip */
 	DS18B20Resolution resolution;						/**< Sensor resolution @see DS18B20Resolution */
 	DS18b20ReadMode readMode;							/**< Specifies what data will be read from the scratchpad */
+	DS18b20ConvertMode convertMode;						/**< Specifies how conversion completion is detected @see DS18b20ConvertMode */
+	DS18B20_Time convertPollInterval;					/**< Interval between conversion state polls [us] */
+	DS18B20_Time convertElapsed;						/**< Conversion time spent polling so far [us] */
 
 	DS18b20State state;									/**< Currently processing function */
-	DS18B20SubState substate;							/**< Current operation state */
+	DS18b20TransactionState transactionState;			/**< State of current bus transaction */
+	DS18b20ConvertState convertState;					/**< Phase of conversion */
+	OneWire_Transaction transaction;					/**< Bus transaction of current operation @see OneWire_Transaction */
+
+	DS18b20Error error;									/**< Result of last operation, DS18b20_Error when no sensor answered @see DS18b20Error */
+	DS18B20_Time waitTime;								/**< Delay awaited by current state [us], 0 when not waiting */
+	const OneWire_RomTable *sampleTable;				/**< Sensors read by sampling cycle */
+	DS18B20_Reading *sampleReadings;					/**< Readings written by sampling cycle, one per sensor of `sampleTable` */
+	OneWire_Count sampleIndex;							/**< Index of sensor being read by sampling cycle */
+	DS18b20SampleState sampleState;						/**< Phase of sampling cycle */
+
+	DS18B20_Time timerElapsed;							/**< Time accumulated by current delay [us] */
+	OneWire_Counter timerLast;							/**< Timer counter value last folded into `timerElapsed` */
 
-	DS18B20_Byte datalen;								/**< Number of bytes scheduled to read */
 	DS18B20_Byte buffer[DS18B20_BUFFER_SIZE];			/**< Read/write buffer */
-	DS18B20_Byte temp;									/**< Temporary byte used to track eeprom recall operation */
+	DS18B20_Byte temp;									/**< Bit read by a single read slot - conversion state or power supply mode */
 } DS18B20;
 
 // Public functions
@@ -244,6 +241,16 @@ void ds18b20Init(DS18B20 *ds, OneWire *ow);
  */
 DS18b20State ds18b20Process(DS18B20 *ds);
 
+/**
+ * @brief Get time until ds18b20Process next needs to be called. During bus operations this is the time reported by
+ * onewireTimeToService, during delays such as conversion it is the remaining part of the delay, limited so that
+ * the timer is read at least once per half of its counter range. The main loop may sleep or do other work until then.
+ *
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @return time until next service [us], or DS18B20_SERVICE_NONE when no operation is in progress
+ */
+DS18B20_Time ds18b20TimeToService(const DS18B20 *ds);
+
 /**
  * @brief Request DS18B20 conversion
  *
@@ -253,6 +260,19 @@ DS18b20State ds18b20Process(DS18B20 *ds);
  */
 DS18B20Result ds18b20BeginConversion(DS18B20 *ds, DS18B20_Address address);
 
+/**
+ * @brief Request sampling cycle of all sensors from ROM table - a single conversion is started on all sensors with Skip ROM,
+ * then scratchpad of every sensor is read with Match ROM, so a sweep costs one conversion time plus one short read per sensor.
+ * Readings are stored in the same order as ROMs in the table, once finished the state is DS18b20_State_Finished.
+ * Number of read scratchpad bytes follows `readMode`, which must be at least DS18b20_Read_Temperature.
+ *
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @param table ROM codes of sensors to read, must not change during the cycle @see OneWire_RomTable
+ * @param readings array of at least `table->count` readings @see DS18B20_Reading
+ * @return DS18B20_Result_Ok if request was accepted, or DS18B20_Result_Busy if another operation is ongoing @see DS18B20Result
+ */
+DS18B20Result ds18b20Sample(DS18B20 *ds, const OneWire_RomTable *table, DS18B20_Reading *readings);
+
 /**
  * @brief Request DS18B20 read cycle. The address is taken from DS18B20 structure field 'currentAddress'
  *
@@ -288,7 +308,8 @@ DS18B20Result ds18b20WriteScratchpad(DS18B20 *ds, DS18B20_Byte *bytes, DS18B20_S
 DS18B20Result ds18b20CopyScratchpad(DS18B20 *ds, DS18B20_Address address);
 
 /**
- * @brief Request loading of the data from EEPROM to scratchpad
+ * @brief Request loading of the data from EEPROM to scratchpad. The sensor signals completion with read slots, `error`
+ * is set to DS18b20_Error when it does not within DS18B20_BUFFER_SIZE bytes.
  *
  * @param ds ds pointer to DS18B20 structure @see DS18B20
  * @return
@@ -314,15 +335,47 @@ DS18B20Result ds18b20SetResolution(DS18B20 *ds, DS18B20Resolution resolution, DS
 DS18B20Result ds18b20ReadPowerSupply(DS18B20 *ds);
 
 /**
- * @brief Verify CRC of DS18B20 data. This only works when module's `readMode` is set to DS18b20_Read_CRC.
+ * @brief Verify CRC of last read scratchpad. CRC is only checked when module's `readMode` is set to DS18b20_Read_CRC.
+ * The CRC is calculated while the scratchpad is being read, so no additional pass over the buffer is needed.
+ * Fails also when no sensor answered, the buffer then holds sent command instead of scratchpad.
  *
- * @param buffer data buffer to verify
- * @param len complete length of data (including CRC byte)
- * @return DS18B20_True on successful verification or DS18B20_False otherwise
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @return DS18B20_True when the scratchpad was read and verified or DS18B20_False otherwise
  */
 static inline DS18B20_Bool ds18b20VerifyCrc(DS18B20 *ds)
 {
-	return ds->readMode == DS18b20_Read_CRC ? onewireCrc(ds->buffer, DS18b20_Read_CRC) == ds->buffer[DS18b20_Read_CRC - 1] : DS18B20_True;
+	return ds->error == DS18b20_Success;
+}
+
+/**
+ * @brief Get worst-case conversion time for given resolution
+ *
+ * @param resolution sensor resolution @see DS18B20Resolution
+ * @return conversion time [us]
+ */
+static inline DS18B20_Time ds18b20GetConversionTime(DS18B20Resolution resolution)
+{
+	switch(resolution)
+	{
+	case DS18B20_Resolution_9: return DS18B20_WAIT_RES9;
+	case DS18B20_Resolution_10: return DS18B20_WAIT_RES10;
+	case DS18B20_Resolution_11: return DS18B20_WAIT_RES11;
+	case DS18B20_Resolution_12: return DS18B20_WAIT_RES12;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Store temperature of last read scratchpad into a reading
+ *
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @param reading reading to fill @see DS18B20_Reading
+ */
+static inline void ds18b20GetReading(const DS18B20 *ds, DS18B20_Reading *reading)
+{
+	reading->raw = (int16_t)(ds->buffer[0] | (ds->buffer[1] << 8));
+	reading->error = ds->error;
 }
 
 /**
@@ -348,28 +401,74 @@ static inline DS18B20_Bool ds18b20CheckAuthentic(DS18B20_Address address)
  */
 static inline void ds18b20Wait(DS18B20 *ds)
 {
-  do {
+  ds18b20Process(ds);
+  while(ds->state != DS18b20_State_Finished) {
+	  ONEWIRE_WAIT_IDLE(ds18b20TimeToService(ds));
 	  ds18b20Process(ds);
-  } while(ds->state != DS18b20_State_Finished);
+  }
+}
+
+/**
+ * @brief Clear bits of raw temperature which are undefined at given resolution - 3 lowest bits at 9-bit resolution,
+ * 2 at 10-bit and 1 at 11-bit
+ *
+ * @param raw raw temperature register, Q12.4 two's complement
+ * @param resolution resolution the sensor is configured with @see DS18B20Resolution
+ * @return raw temperature with undefined bits cleared
+ */
+static inline int16_t ds18b20MaskRaw(int16_t raw, DS18B20Resolution resolution)
+{
+	// Configuration register bits 5 and 6 hold resolution - 9
+	DS18B20_Byte undefined = 3 - ((resolution >> 5) & 0x03);
+	return (int16_t)(raw & ~((1 << undefined) - 1));
+}
+
+/**
+ * @brief Convert raw temperature to milli-degrees Celsius, 62.5 per LSB, truncated toward zero
+ *
+ * @param raw raw temperature register, Q12.4 two's complement
+ * @return temperature in milli-degrees Celsius
+ */
+static inline int32_t ds18b20RawToMilli(int16_t raw)
+{
+	return (int32_t)raw * 125 / 2;
+}
+
+/**
+ * @brief Get raw temperature from last read scratchpad, undefined bits masked by module's `resolution`.
+ * This function is only valid after ds18b20Process function returns DS18b20_State_Finished status code.
+ *
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @return temperature in Q12.4 format - 1/16 degree Celsius per LSB, two's complement
+ */
+static inline int16_t ds18b20GetTemperatureRaw(const DS18B20 *ds)
+{
+	return ds18b20MaskRaw((int16_t)(ds->buffer[0] | (ds->buffer[1] << 8)), ds->resolution);
+}
+
+/**
+ * @brief Get temperature from last read scratchpad in milli-degrees Celsius, using integer arithmetic only
+ *
+ * @param ds pointer to DS18B20 structure @see DS18B20
+ * @return temperature in milli-degrees Celsius
+ */
+static inline int32_t ds18b20GetTemperatureMilli(const DS18B20 *ds)
+{
+	return ds18b20RawToMilli(ds18b20GetTemperatureRaw(ds));
 }
 
 #if DS18B20_FLOAT_ENABLED
 
 /**
  * @brief Convert DS18B20 buffer into real temperature. This function is only valid after ds18b20Process function returns DS18b20_State_Finished status code.
+ * On targets without FPU ds18b20GetTemperatureMilli is considerably cheaper.
  *
  * @param ds pointer to DS18B20 structure @see DS18B20
  * @return read temperature in Celsius degrees
  */
 static inline float ds18b20GetTemperatureFloat(const DS18B20 *ds)
 {
-	return
-			( ( ( ds->buffer[0] | (ds->buffer[1] << 8) ) & 0x07FF ) >> 4 ) +
-			0.5    * ((ds->buffer[0] & 0x08) >> 3) +
-			0.25   * ((ds->buffer[1] & 0x04) >> 2) +
-			0.125  * ((ds->buffer[2] & 0x02) >> 1) +
-			0.0625 * ((ds->buffer[3] & 0x01) >> 0);
-	//return ((float)(ds->buffer[0] | (ds->buffer[1] << 8) )) * ds18b20GetResolutionDivider(ds);
+	return ds18b20GetTemperatureRaw(ds) * 0.0625f;
 }
 #endif
 
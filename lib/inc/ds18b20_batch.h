@@ -0,0 +1,68 @@
+#ifndef _h_ds18b20_batch
+#define _h_ds18b20_batch
+
+#include "ds18b20.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Properties
+
+/** @def DS18B20_SCRATCHPAD_SIZE size of a complete scratchpad including CRC byte */
+#define DS18B20_SCRATCHPAD_SIZE 9
+
+// Definitions
+
+/**
+ * @brief Decoding kernels, vector ones are available only when built for and supported by the running CPU
+ */
+typedef enum DS18B20_BatchKernel
+{
+	DS18B20_Batch_Scalar,		/**< Portable C, always available */
+	DS18B20_Batch_SSE2,			/**< x86 SSE2, 16 scratchpads transposed into lanes per step */
+	DS18B20_Batch_AVX2,			/**< x86 AVX2, 32 scratchpads transposed into lanes per step */
+	DS18B20_Batch_NEON			/**< ARM NEON, 16 scratchpads transposed into lanes per step */
+} DS18B20_BatchKernel;
+
+/**
+ * @brief Decoded scratchpads as separate arrays (structure of arrays), element N belongs to scratchpad N.
+ * Optional arrays may be null.
+ */
+typedef struct DS18B20_BatchOutput
+{
+	int32_t *milli;						/**< Temperatures in milli-degrees Celsius, undefined bits masked by resolution of every scratchpad */
+	DS18B20_Bool *crcValid;				/**< [Optional] Set when scratchpad CRC matches, checked with onewireBatchCrc */
+	DS18B20_Byte *resolution;			/**< [Optional] Resolution [bits], 9 to 12 */
+	DS18B20_Byte *userByte1;			/**< [Optional] TH register */
+	DS18B20_Byte *userByte2;			/**< [Optional] TL register */
+} DS18B20_BatchOutput;
+
+// Public functions
+
+/**
+ * @brief Decode many scratchpads at once. Results are bit-exact with ds18b20MaskRaw and ds18b20RawToMilli, whichever kernel is used.
+ * Unless a kernel is forced by ds18b20BatchSelect, the fastest one supported by the CPU is used.
+ *
+ * @param scratchpads first byte of the first scratchpad
+ * @param stride distance between consecutive scratchpads [bytes] - DS18B20_SCRATCHPAD_SIZE for packed dumps, sizeof(DS18B20) for `buffer` of driver array
+ * @param count number of scratchpads
+ * @param out output arrays of at least `count` elements @see DS18B20_BatchOutput
+ */
+void ds18b20BatchDecode(const DS18B20_Byte *scratchpads, size_t stride, size_t count, const DS18B20_BatchOutput *out);
+
+/**
+ * @brief Select decoding kernel, not to be called while another thread decodes
+ *
+ * @param kernel kernel to use @see DS18B20_BatchKernel
+ * @return DS18B20_True if the kernel was selected, DS18B20_False when it is not available on this build or CPU
+ */
+DS18B20_Bool ds18b20BatchSelect(DS18B20_BatchKernel kernel);
+
+/**
+ * @brief Get currently used decoding kernel
+ *
+ * @return kernel @see DS18B20_BatchKernel
+ */
+DS18B20_BatchKernel ds18b20BatchKernel(void);
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef _h_ds18b20_inventory
+#define _h_ds18b20_inventory
+
+#include "ds18b20.h"
+
+#include <stdint.h>
+
+// Properties
+
+/** @def DS18B20_INVENTORY_MAGIC first two bytes of stored inventory, 'D' and 'S' */
+#define DS18B20_INVENTORY_MAGIC 0x5344
+
+/** @def DS18B20_INVENTORY_VERSION version of the stored format, inventories of other versions are rejected */
+#define DS18B20_INVENTORY_VERSION 1
+
+/** @def DS18B20_INVENTORY_HEADER_SIZE magic (2 bytes), version, reserved byte and sensor count (2 bytes) */
+#define DS18B20_INVENTORY_HEADER_SIZE 6
+
+/** @def DS18B20_INVENTORY_RECORD_SIZE ROM (8 bytes), configuration register and two user bytes */
+#define DS18B20_INVENTORY_RECORD_SIZE 11
+
+/** @def DS18B20_INVENTORY_CRC_SIZE CRC16 of header and records */
+#define DS18B20_INVENTORY_CRC_SIZE 2
+
+/** @def DS18B20_INVENTORY_SIZE(count) storage needed by inventory of given number of sensors [bytes] */
+#define DS18B20_INVENTORY_SIZE(count) (DS18B20_INVENTORY_HEADER_SIZE + (count) * DS18B20_INVENTORY_RECORD_SIZE + DS18B20_INVENTORY_CRC_SIZE)
+
+// Definitions
+
+typedef uint32_t DS18B20_StorageOffset;
+
+/**
+ * @brief Inventory operation in progress
+ */
+typedef enum DS18B20_InventoryState
+{
+	DS18B20_Inventory_Idle,			/**< No operation is in progress */
+	DS18B20_Inventory_Saving,		/**< Inventory is being written to storage */
+	DS18B20_Inventory_Loading		/**< Inventory is being read from storage */
+} DS18B20_InventoryState;
+
+/**
+ * @brief Part of stored inventory being transferred
+ */
+typedef enum DS18B20_InventoryStep
+{
+	DS18B20_Inventory_Header,
+	DS18B20_Inventory_Records,
+	DS18B20_Inventory_Crc
+} DS18B20_InventoryStep;
+
+/**
+ * @brief Settings of a single sensor, as written to its scratchpad
+ */
+typedef struct DS18B20_InventoryEntry
+{
+	DS18B20Resolution resolution;						/**< Resolution the sensor is configured with */
+	DS18B20_Byte userBytes[2];							/**< TH and TL registers */
+} DS18B20_InventoryEntry;
+
+typedef struct DS18B20_Inventory DS18B20_Inventory;
+
+/**
+ * @brief Non-blocking storage access, called repeatedly with the same arguments while it returns OneWire_Working.
+ * Must return OneWire_Success once `length` bytes at `offset` were transferred, or OneWire_Failed.
+ */
+typedef OneWire_Result(*DS18B20_InventoryTransfer)(DS18B20_Inventory *inv, DS18B20_StorageOffset offset, DS18B20_Byte *data, DS18B20_Size length);
+
+/**
+ * @brief Sensors of a bus kept across restarts - ROM table with per-sensor settings, stored in a compact versioned
+ * format protected by CRC16. Storage is provided by the user through read and write hooks (flash, EEPROM, file, ...).
+ */
+typedef struct DS18B20_Inventory
+{
+	OneWire_RomTable *table;							/**< Sorted ROMs of the sensors */
+	DS18B20_InventoryEntry *entries;					/**< Settings of the sensors, entry N belongs to ROM N of the table */
+
+	DS18B20_InventoryTransfer storageWrite;				/**< Write to storage */
+	DS18B20_InventoryTransfer storageRead;				/**< Read from storage */
+	void *storageData;									/**< [Optional] Storage specific data */
+
+	DS18B20_InventoryState state;						/**< Operation in progress */
+	DS18B20_InventoryStep step;							/**< Part being transferred */
+	OneWire_Count count;								/**< Number of records being transferred */
+	OneWire_Count index;								/**< Record being transferred */
+	DS18B20_StorageOffset offset;						/**< Storage offset of the part being transferred */
+	uint16_t crc;										/**< Running CRC16 of transferred data */
+	DS18B20_Byte chunk[DS18B20_INVENTORY_RECORD_SIZE];	/**< Part being transferred */
+	DS18B20_Size chunkLength;							/**< Length of the part being transferred */
+} DS18B20_Inventory;
+
+// Public functions
+
+/**
+ * @brief Initialize inventory
+ *
+ * @param inv pointer to DS18B20_Inventory structure @see DS18B20_Inventory
+ * @param table initialized ROM table @see OneWire_RomTable
+ * @param entries settings storage with the same capacity as the table @see DS18B20_InventoryEntry
+ * @param storageWrite hook writing to storage
+ * @param storageRead hook reading from storage
+ */
+void ds18b20InventoryInit(DS18B20_Inventory *inv, OneWire_RomTable *table, DS18B20_InventoryEntry *entries, DS18B20_InventoryTransfer storageWrite, DS18B20_InventoryTransfer storageRead);
+
+/**
+ * @brief Process inventory - this function is required to work in program's main loop while saving or loading
+ *
+ * @param inv pointer to DS18B20_Inventory structure @see DS18B20_Inventory
+ * @return OneWire_Working while in progress, OneWire_Success or OneWire_Failed once finished, OneWire_NothingToDo when idle
+ */
+OneWire_Result ds18b20InventoryProcess(DS18B20_Inventory *inv);
+
+/**
+ * @brief Begin writing inventory to storage, DS18B20_INVENTORY_SIZE(table->count) bytes from offset 0
+ *
+ * @param inv pointer to DS18B20_Inventory structure @see DS18B20_Inventory
+ */
+void ds18b20InventorySave(DS18B20_Inventory *inv);
+
+/**
+ * @brief Begin reading inventory from storage. Inventory of other version, with invalid ROM or CRC, unsorted
+ * or larger than the table is rejected with OneWire_Failed and leaves the table empty.
+ *
+ * @param inv pointer to DS18B20_Inventory structure @see DS18B20_Inventory
+ */
+void ds18b20InventoryLoad(DS18B20_Inventory *inv);
+
+/**
+ * @brief Store settings of a sensor from its scratchpad, read at least up to configuration register
+ *
+ * @param inv pointer to DS18B20_Inventory structure @see DS18B20_Inventory
+ * @param index index of the sensor's ROM in the table
+ * @param ds DS18B20 driver which has just read the scratchpad @see DS18B20
+ */
+void ds18b20InventoryStore(DS18B20_Inventory *inv, OneWire_Count index, const DS18B20 *ds);
+
+#endif
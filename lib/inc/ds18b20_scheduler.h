@@ -0,0 +1,102 @@
+#ifndef _h_ds18b20_scheduler
+#define _h_ds18b20_scheduler
+
+#include "ds18b20.h"
+
+#include <stdint.h>
+
+// Properties
+
+/** @def DS18B20_SCHEDULER_MARGIN time reserved for sending conversion command and reading scratchpad [ms], about 17ms with Match ROM on a bit-banged bus, plus slack for a job of another sensor */
+#ifndef DS18B20_SCHEDULER_MARGIN
+#define DS18B20_SCHEDULER_MARGIN 25
+#endif
+
+// Definitions
+
+/**
+ * @brief Operation currently performed by the scheduler on the bus
+ */
+typedef enum DS18B20_SchedulerJob
+{
+	DS18B20_Job_None,			/**< Bus is idle */
+	DS18B20_Job_Convert,		/**< Conversion is being started on a sensor */
+	DS18B20_Job_Read			/**< Scratchpad of a sensor is being read */
+} DS18B20_SchedulerJob;
+
+/**
+ * @brief Single scheduled sensor. `address`, `period` and `resolution` are set by the user, the rest is maintained by the scheduler.
+ */
+typedef struct DS18B20_Sensor
+{
+	DS18B20_Address address;							/**< ROM code of the sensor */
+	DS18B20_Time period;								/**< Sampling period [ms] */
+	DS18B20Resolution resolution;						/**< Resolution the sensor is configured with, determines conversion time */
+
+	DS18B20_Time deadline;								/**< Time the next reading is due [ms] */
+	DS18B20_Time convertDone;							/**< Time the running conversion completes [ms] */
+	DS18B20_Bool converting;							/**< Set while conversion is running */
+
+	DS18B20_Reading reading;							/**< Last reading @see DS18B20_Reading */
+	OneWire_Count missed;								/**< Number of readings finished after their deadline */
+} DS18B20_Sensor;
+
+typedef struct DS18B20_Scheduler DS18B20_Scheduler;
+
+/**
+ * @brief Callback fired for every new reading
+ */
+typedef void(*DS18B20_SchedulerCallback)(DS18B20_Scheduler *sched, DS18B20_Sensor *sensor);
+
+/**
+ * @brief Scheduler of many sensors with individual periods sharing a single bus. Conversions are started with Match ROM
+ * early enough to finish at sensor's deadline, and while sensors are converting the bus is used to read the ones
+ * which are already done. Jobs are picked earliest deadline first.
+ */
+typedef struct DS18B20_Scheduler
+{
+	DS18B20 *ds;										/**< DS18B20 driver of the bus, used exclusively by the scheduler */
+	DS18B20_Sensor *sensors;							/**< Scheduled sensors */
+	OneWire_Count count;								/**< Number of scheduled sensors */
+
+	DS18B20_SchedulerCallback onReading;				/**< [Optional] Callback fired for every new reading */
+
+	DS18B20_SchedulerJob job;							/**< Job in progress */
+	OneWire_Count current;								/**< Sensor the job in progress belongs to */
+
+	DS18B20_Bool started;								/**< Set once deadlines have been initialized */
+	DS18B20_Time lastTime;								/**< Time of previous process call [ms] */
+	DS18B20_Time busyTime;								/**< Time the bus has spent on jobs [ms] */
+	DS18B20_Time totalTime;								/**< Time the scheduler has been running [ms] */
+} DS18B20_Scheduler;
+
+// Public functions
+
+/**
+ * @brief Initialize scheduler. The driver's convert mode is switched to DS18b20_ConvertMode_NoWait.
+ *
+ * @param sched pointer to DS18B20_Scheduler structure @see DS18B20_Scheduler
+ * @param ds pointer to initialized DS18B20 driver @see DS18B20
+ * @param sensors sensors with `address`, `period` and `resolution` set @see DS18B20_Sensor
+ * @param count number of sensors
+ */
+void ds18b20SchedulerInit(DS18B20_Scheduler *sched, DS18B20 *ds, DS18B20_Sensor *sensors, OneWire_Count count);
+
+/**
+ * @brief Process scheduler - this function is required to work in program's main loop. First reading of sensor N
+ * is due one conversion time plus (N + 1) * DS18B20_SCHEDULER_MARGIN after the first call.
+ *
+ * @param sched pointer to DS18B20_Scheduler structure @see DS18B20_Scheduler
+ * @param now current time [ms], may wrap
+ */
+void ds18b20SchedulerProcess(DS18B20_Scheduler *sched, DS18B20_Time now);
+
+/**
+ * @brief Get share of time the bus has been busy since scheduler start, weighted towards recent time after 24.8 days of uptime
+ *
+ * @param sched pointer to DS18B20_Scheduler structure @see DS18B20_Scheduler
+ * @return bus utilisation [per mille]
+ */
+DS18B20_Time ds18b20SchedulerUtilisation(const DS18B20_Scheduler *sched);
+
+#endif
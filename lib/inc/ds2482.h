@@ -0,0 +1,170 @@
+#ifndef _h_ds2482
+#define _h_ds2482
+
+#include "onewire.h"
+
+#include <stdint.h>
+
+// Porting definitions
+
+typedef uint8_t DS2482_Byte;
+typedef uint8_t DS2482_Size;
+typedef uint8_t DS2482_Bool;
+
+#define DS2482_False 0
+#define DS2482_True 1
+
+// Properties
+
+/** @def DS2482_ADDRESS default 7-bit I2C address of the bridge with both address pins low */
+#define DS2482_ADDRESS 0x18
+
+/** @def DS2482_CHANNELS_100 number of channels of DS2482-100 */
+#define DS2482_CHANNELS_100 1
+
+/** @def DS2482_CHANNELS_800 number of channels of DS2482-800 */
+#define DS2482_CHANNELS_800 8
+
+// DS2482 commands
+
+#define DS2482_DEVICE_RESET 0xF0
+#define DS2482_SET_READ_POINTER 0xE1
+#define DS2482_WRITE_CONFIG 0xD2
+#define DS2482_CHANNEL_SELECT 0xC3
+#define DS2482_1WIRE_RESET 0xB4
+#define DS2482_1WIRE_WRITE_BYTE 0xA5
+#define DS2482_1WIRE_READ_BYTE 0x96
+#define DS2482_1WIRE_SINGLE_BIT 0x87
+#define DS2482_1WIRE_TRIPLET 0x78
+
+// DS2482 registers
+
+#define DS2482_REGISTER_STATUS 0xF0
+#define DS2482_REGISTER_DATA 0xE1
+#define DS2482_REGISTER_CONFIG 0xC3
+
+// Status register bits
+
+#define DS2482_STATUS_1WB 0x01
+#define DS2482_STATUS_PPD 0x02
+#define DS2482_STATUS_SD 0x04
+#define DS2482_STATUS_LL 0x08
+#define DS2482_STATUS_RST 0x10
+#define DS2482_STATUS_SBR 0x20
+#define DS2482_STATUS_TSB 0x40
+#define DS2482_STATUS_DIR 0x80
+
+// Configuration register bits
+
+#define DS2482_CONFIG_APU 0x01
+#define DS2482_CONFIG_SPU 0x04
+#define DS2482_CONFIG_1WS 0x08
+
+// Definitions
+
+/**
+ * @brief Progress of a single bridge command
+ */
+typedef enum DS2482CommandState
+{
+	DS2482_Command_Begin,			/**< Command is about to be sent */
+	DS2482_Command_Writing,			/**< Command is being written */
+	DS2482_Command_Status,			/**< Status register is being polled */
+	DS2482_Command_Pointer,			/**< Read pointer is being set to data register */
+	DS2482_Command_Data				/**< Data register is being read */
+} DS2482CommandState;
+
+/**
+ * @brief Progress of bridge reset sequence
+ */
+typedef enum DS2482ResetState
+{
+	DS2482_Reset_Device,			/**< Bridge device reset */
+	DS2482_Reset_Config,			/**< Configuration register write */
+	DS2482_Reset_Channel,			/**< Channel selection */
+	DS2482_Reset_Bus				/**< 1-Wire reset */
+} DS2482ResetState;
+
+typedef struct DS2482 DS2482;
+
+/**
+ * @brief Begin I2C write of given bytes to the bridge - the call must not block
+ */
+typedef void(*DS2482_I2cWrite)(const DS2482 *bridge, const DS2482_Byte *data, DS2482_Size length);
+
+/**
+ * @brief Begin I2C read of given number of bytes from the bridge - the call must not block
+ */
+typedef void(*DS2482_I2cRead)(const DS2482 *bridge, DS2482_Byte *data, DS2482_Size length);
+
+/**
+ * @brief Check state of last I2C transfer - OneWire_Working while in progress, OneWire_Success or OneWire_Failed when done
+ */
+typedef OneWire_Result(*DS2482_I2cDone)(const DS2482 *bridge);
+
+/**
+ * @brief DS2482 bridge structure, shared by all channels of the bridge
+ */
+typedef struct DS2482
+{
+	DS2482_Byte address;						/**< 7-bit I2C address */
+	DS2482_Byte channels;						/**< Number of channels, DS2482_CHANNELS_100 or DS2482_CHANNELS_800 */
+	DS2482_Byte config;							/**< Configuration written on first reset, combination of DS2482_CONFIG_* bits, SPU is only added while a transaction holds strong pullup */
+
+	DS2482_I2cWrite i2cWrite;					/**< Begin I2C write */
+	DS2482_I2cRead i2cRead;						/**< Begin I2C read */
+	DS2482_I2cDone i2cDone;						/**< Check I2C transfer state */
+
+	DS2482_Bool configured;						/**< Set once device reset and configuration has been done */
+	DS2482_Byte channel;						/**< Currently selected channel */
+
+	DS2482CommandState commandState;			/**< State of currently processed command */
+	DS2482ResetState resetState;				/**< State of reset sequence */
+	DS2482_Byte command[2];						/**< Command being sent */
+	DS2482_Size commandLength;					/**< Length of command being sent */
+	DS2482_Byte status;							/**< Last read status register */
+	DS2482_Byte data;							/**< Last read data byte */
+} DS2482;
+
+/**
+ * @brief Single bridge channel, attached to OneWire interface as its transport data
+ */
+typedef struct DS2482_Channel
+{
+	DS2482 *bridge;								/**< Bridge this channel belongs to */
+	DS2482_Byte channel;						/**< Channel number, 0 for DS2482-100 */
+} DS2482_Channel;
+
+// Transport
+
+extern const OneWire_Transport ds2482Transport;	/**< OneWire transport implemented by DS2482 bridge */
+
+// Public functions
+
+/**
+ * @brief Initialize DS2482 bridge structure
+ *
+ * @param bridge pointer to DS2482 structure @see DS2482
+ * @param address 7-bit I2C address of the bridge
+ * @param channels number of bridge channels, DS2482_CHANNELS_100 or DS2482_CHANNELS_800
+ * @param i2cWrite callback to begin I2C write
+ * @param i2cRead callback to begin I2C read
+ * @param i2cDone callback to check I2C transfer state
+ */
+void ds2482Init(DS2482 *bridge, DS2482_Byte address, DS2482_Byte channels, DS2482_I2cWrite i2cWrite, DS2482_I2cRead i2cRead, DS2482_I2cDone i2cDone);
+
+/**
+ * @brief Initialize OneWire interface working on given bridge channel. Channel is selected on every 1-Wire reset when
+ * a different channel was used last. Only one channel of a bridge may be processing an operation at a time.
+ *
+ * @param channel pointer to DS2482_Channel structure, must outlive the OneWire interface @see DS2482_Channel
+ * @param bridge pointer to initialized DS2482 structure @see DS2482
+ * @param number channel number, 0 for DS2482-100
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param id user-assigned ID used to identify which OneWire interface is being used in callbacks
+ * @param startTimer callback to restart timer counter, used by DS18B20 module for its delays
+ * @param readTimer callback to read timer counter [us], used by DS18B20 module for its delays
+ */
+void ds2482InitChannel(DS2482_Channel *channel, DS2482 *bridge, DS2482_Byte number, OneWire *ow, OneWire_Id id, OneWire_StartTimer startTimer, OneWire_ReadTimer readTimer);
+
+#endif
@@ -6,8 +6,71 @@
 /** @def ONEWIRE_SEARCH when defined, one wire search functions will be available */
 #define ONEWIRE_SEARCH
 
-/** @def DS18B20_CRC_LOOKUP_TABLE when defined, a CRC lookup table will be used for CRC calculation */
-#define ONEWIRE_CRC_LOOKUP_TABLE
+/** @def ONEWIRE_CRC_TABLE_NONE CRC is calculated bit by bit - smallest, but slowest variant */
+#define ONEWIRE_CRC_TABLE_NONE 0
+
+/** @def ONEWIRE_CRC_TABLE_FULL CRC is calculated using 256 byte lookup table placed in flash - one lookup per byte */
+#define ONEWIRE_CRC_TABLE_FULL 1
+
+/** @def ONEWIRE_CRC_TABLE_NIBBLE CRC is calculated using two 16 byte lookup tables - two lookups per byte */
+#define ONEWIRE_CRC_TABLE_NIBBLE 2
+
+/** @def ONEWIRE_CRC_LOOKUP_TABLE selects CRC calculation method, one of ONEWIRE_CRC_TABLE_NONE, ONEWIRE_CRC_TABLE_FULL or ONEWIRE_CRC_TABLE_NIBBLE */
+#ifndef ONEWIRE_CRC_LOOKUP_TABLE
+#define ONEWIRE_CRC_LOOKUP_TABLE ONEWIRE_CRC_TABLE_FULL
+#endif
+
+/**
+ * @def ONEWIRE_PORT_HEADER when defined, pin and timer primitives are taken at compile time from the given header instead of
+ * being called through OneWire callbacks. The header must provide following static inline functions:
+ * onewirePortSetPinDir, onewirePortSetPinState, onewirePortReadPin, onewirePortStartTimer and onewirePortReadTimer,
+ * with the same signatures as the corresponding callbacks.
+ */
+//#define ONEWIRE_PORT_HEADER "onewire_port.h"
+
+/**
+ * @def ONEWIRE_TIMER_INTERRUPT when defined, the state machine is driven from timer compare interrupt instead of main loop.
+ * Timer must be free-running and wrap at OneWire_Counter range, `scheduleTimer` callback must be set and
+ * onewireTimerInterrupt must be called from the compare interrupt. onewireProcess then only reports completion.
+ * Interrupt latency stretches the 10us low pulse of write 1 slots and delays sampling of read slots, both of which must
+ * end within 15us, so it must stay below 5us.
+ */
+//#define ONEWIRE_TIMER_INTERRUPT
+
+/**
+ * @def ONEWIRE_FREE_RUNNING_TIMER when defined, the timer counter is never restarted. Every delay stores the counter value
+ * it started at and elapsed time is computed with wrapping arithmetic, so the counter must wrap at OneWire_Counter range.
+ * Any number of OneWire interfaces and DS18B20 drivers may then share one timer, and `startTimer` callback may be null.
+ * Implied by ONEWIRE_TIMER_INTERRUPT.
+ */
+//#define ONEWIRE_FREE_RUNNING_TIMER
+
+#if defined(ONEWIRE_TIMER_INTERRUPT) && !defined(ONEWIRE_FREE_RUNNING_TIMER)
+#define ONEWIRE_FREE_RUNNING_TIMER
+#endif
+
+/**
+ * @def ONEWIRE_UART when defined, OneWire interfaces may be initialized with onewireInitUart to use UART transport
+ * instead of GPIO bit-banging. UART TX and RX must be connected to the bus, TX in open-drain mode.
+ */
+//#define ONEWIRE_UART
+
+/** @def ONEWIRE_STOP_NO_PRESENCE transaction stop rule - fail right after reset when no device answered with presence pulse */
+#define ONEWIRE_STOP_NO_PRESENCE 0x01
+
+/** @def ONEWIRE_STOP_NONZERO transaction stop rule - read byte by byte and finish at the first byte which is not zero, fail when all are zero */
+#define ONEWIRE_STOP_NONZERO 0x02
+
+/** @def ONEWIRE_UART_FRAME_SIZE maximum number of time slots transferred over UART at once, one character per slot */
+#define ONEWIRE_UART_FRAME_SIZE 80
+
+/**
+ * @def ONEWIRE_WAIT_IDLE(time) hook called by blocking wait functions between process calls with time [us] until the next
+ * call is needed, may be defined to sleep or wait for interrupt instead of spinning
+ */
+#ifndef ONEWIRE_WAIT_IDLE
+#define ONEWIRE_WAIT_IDLE(time)
+#endif
 
 // Timing configuration
 
@@ -15,14 +78,24 @@
 #define ONEWIRE_START_RELEASE_TIME 80
 #define ONEWIRE_START_WAIT_TIME 400
 
+/** @def ONEWIRE_START_RECOVERY_TIME default gap between the end of reset sequence and first time slot [us], datasheet minimum */
+#define ONEWIRE_START_RECOVERY_TIME 1
+
 #define ONEWIRE_WRITE_HIGH_LOW_TIME 10
 #define ONEWIRE_WRITE_HIGH_RELEASE_TIME 55
 #define ONEWIRE_WRITE_LOW_LOW_TIME 65
+#define ONEWIRE_WRITE_LOW_RELEASE_TIME 5
 
 #define ONEWIRE_READ_BEGIN_TIME 2
 #define ONEWIRE_READ_LOW_TIME 2
 #define ONEWIRE_READ_WAIT_TIME 50
 
+// UART transport characters
+
+#define ONEWIRE_UART_RESET 0xF0
+#define ONEWIRE_UART_BIT_HIGH 0xFF
+#define ONEWIRE_UART_BIT_LOW 0x00
+
 // Port definitions
 
 typedef uint8_t OneWire_Id;
@@ -31,10 +104,24 @@ typedef uint8_t OneWire_Byte;
 typedef uint8_t OneWire_Size;
 typedef uint8_t OneWire_Bool;
 typedef uint64_t OneWire_Address;
+typedef uint16_t OneWire_Count;
+typedef uint32_t OneWire_SlotCount;
 
 #define OneWire_True 1
 #define OneWire_False 0
 
+/** @def ONEWIRE_FAMILY_ANY placeholder family code used to search devices of all families */
+#define ONEWIRE_FAMILY_ANY 0x00
+
+/** @def ONEWIRE_SEARCH_PASS_SLOTS time slots of a single full search pass - command byte and 64 triplets, reset excluded */
+#define ONEWIRE_SEARCH_PASS_SLOTS (8 + 64 * 3)
+
+/** @def ONEWIRE_SERVICE_NONE time to service reported when no processing is needed until a new operation is started */
+#define ONEWIRE_SERVICE_NONE ((OneWire_Counter)~0)
+
+/** @def ONEWIRE_ROM_NOT_FOUND index returned when ROM is not present in ROM table */
+#define ONEWIRE_ROM_NOT_FOUND 0xFFFF
+
 // Generic enumerations
 
 typedef enum OneWire_PinDirection
@@ -75,7 +162,9 @@ typedef enum OneWire_State
 	OneWire_Writing,		/**< Data is being transmitted */
 	OneWire_Reading,		/**< Data is being read */
 	OneWire_Searching,		/**< Device search is in progress */
-	OneWire_SearchingAlarm	/**< Device search in alarm mode is in progress */
+	OneWire_SearchingAlarm,	/**< Device search in alarm mode is in progress */
+	OneWire_Verifying,		/**< Presence of known devices is being verified */
+	OneWire_Transacting		/**< Transaction is being processed */
 } OneWire_State;
 
 typedef enum OneWire_StartState
@@ -102,12 +191,37 @@ typedef enum OneWire_ReadState
 	OneWire_Read_3
 } OneWire_ReadState;
 
+typedef enum OneWire_TransactionState
+{
+	OneWire_Transaction_Begin,
+	OneWire_Transaction_Reset,
+	OneWire_Transaction_Write,
+	OneWire_Transaction_Arm,		/**< Transport strong pullup is being armed before the last written byte */
+	OneWire_Transaction_Last,		/**< Last byte is being written with armed strong pullup */
+	OneWire_Transaction_Pullup,
+	OneWire_Transaction_Release,	/**< Transport strong pullup is being released */
+	OneWire_Transaction_Read
+} OneWire_TransactionState;
+
+typedef enum OneWire_UartState
+{
+	OneWire_Uart_Begin,
+	OneWire_Uart_Transfer
+} OneWire_UartState;
+
+typedef enum OneWire_UartBaud
+{
+	OneWire_Baud_9600,			/**< Used for reset pulse */
+	OneWire_Baud_115200			/**< Used for time slots */
+} OneWire_UartBaud;
+
 typedef enum OneWire_SearchState
 {
 	OneWire_Search_Begin,
 	OneWire_Search_Write_Command,
 	OneWire_Search_Read,
-	OneWire_Search_Write_Direction
+	OneWire_Search_Write_Direction,
+	OneWire_Search_Triplet
 } OneWire_SearchState;
 
 // Definitions
@@ -121,10 +235,92 @@ typedef void(*OneWire_StartTimer)(const OneWire *ow);
 typedef OneWire_Counter(*OneWire_ReadTimer)(const OneWire *ow);
 typedef void(*OneWire_Detected)(const OneWire *ow);
 
+#ifdef ONEWIRE_UART
+typedef void(*OneWire_UartSetBaud)(const OneWire *ow, OneWire_UartBaud baud);
+typedef void(*OneWire_UartTransfer)(const OneWire *ow, OneWire_Byte *data, OneWire_Size length);
+typedef OneWire_Bool(*OneWire_UartTransferDone)(const OneWire *ow);
+#endif
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+typedef void(*OneWire_ScheduleTimer)(const OneWire *ow, OneWire_Counter compare);
+#endif
+
 #ifdef ONEWIRE_SEARCH
 typedef void(*OneWire_Search_Cb)(const OneWire *ow);
 #endif
 
+/**
+ * @brief Fixed-capacity table of ROM codes. ROMs are kept sorted in the order the search finds them,
+ * so filling the table during search is an append and lookups by ROM are a binary search.
+ */
+typedef struct OneWire_RomTable
+{
+	OneWire_Address *roms;					/**< Caller-provided ROM storage */
+	OneWire_Count capacity;					/**< Number of ROMs the storage can hold */
+	OneWire_Count count;					/**< Number of ROMs in the table */
+	OneWire_Count rejected;					/**< Number of found ROMs rejected because of invalid CRC */
+	OneWire_Bool overflow;					/**< Set when a ROM was dropped because the table was full */
+} OneWire_RomTable;
+
+/**
+ * @brief Context of a time-sliced search. It lives outside of OneWire, so other operations may use the interface between
+ * slices. A slice ends after every found ROM, or with a `budget` set, before a pass which would not fit into it.
+ * Search passes are never interrupted, as any other operation resets the bus and a broken pass would have to be repeated.
+ */
+typedef struct OneWire_Search
+{
+	OneWire_RomTable *table;				/**< Table collecting found addresses */
+	OneWire_Address lastDiscrepancy;		/**< Discrepancy state at the start of the next pass */
+	OneWire_Address target;					/**< Address bits forced by targeted search */
+	OneWire_Address targetMask;				/**< Mask of address bits forced by targeted search */
+	OneWire_SlotCount budget;				/**< Time slots a single slice may use, 0 to yield after every found ROM */
+	OneWire_SlotCount slots;				/**< Number of time slots used by finished slices */
+	OneWire_Count count;					/**< Number of addresses found so far */
+	OneWire_Bool alarm;						/**< Only devices with alarm flag set are searched */
+	OneWire_Bool done;						/**< Set once there is nothing left to search */
+} OneWire_Search;
+
+/**
+ * @brief Complete bus transaction run by onewireTransact as a single job - optional reset, bytes to write, optional strong
+ * pullup hold and bytes to read. Phases with nothing to do are skipped. Bit-bang transport drives the pin high for the
+ * hold, transports with `pullup` operation arm it before the last written byte, so it is applied right after that
+ * byte's last time slot. Other transports (UART) keep the bus released and only wait.
+ */
+typedef struct OneWire_Transaction
+{
+	OneWire_Bool reset;						/**< Begin with reset pulse */
+	const OneWire_Byte *tx;					/**< Bytes to write */
+	OneWire_Size txLength;					/**< Number of bytes to write */
+	OneWire_Byte *rx;						/**< Buffer for read bytes, cleared before reading, may be the same as `tx` */
+	OneWire_Size rxLength;					/**< Maximum number of bytes to read */
+	OneWire_Counter pullup;					/**< Time to hold the bus high after written bytes [us], 0 for none */
+	OneWire_Byte stop;						/**< Early-stop rules, combination of ONEWIRE_STOP_* flags */
+} OneWire_Transaction;
+
+/**
+ * @brief Physical transport used by OneWire interface. Every operation is non-blocking - it is called repeatedly
+ * until it returns OneWire_Success. Write and read operations transfer `bitLength` bits of every one of `bufferLength`
+ * bytes of attached `buffer`, so the same operations serve single bits, single bytes and whole blocks.
+ * Read operations must OR received bits into the buffer and update `crc` when OneWire state is OneWire_Reading or
+ * OneWire_Transacting. Reset operations should set `presence` to OneWire_False when no device answered.
+ *
+ * Optional triplet operation performs a single search step - reads a bit and its complement, then writes the direction.
+ * On entry bit 0 of `searchHelper` holds direction to take when both values are present, on exit bit 0 holds read bit,
+ * bit 1 its complement and bit 2 the direction taken. When not provided, search is done with read and write operations.
+ *
+ * Optional pullup operation arms strong pullup, which the transport applies once the next write operation completes
+ * and keeps until it is called again to release it. When not provided, transactions can only drive strong pullup
+ * with bit-bang transport.
+ */
+typedef struct OneWire_Transport
+{
+	OneWire_Result(*reset)(OneWire *ow);	/**< Process reset pulse and presence detection */
+	OneWire_Result(*write)(OneWire *ow);	/**< Process writing of attached buffer */
+	OneWire_Result(*read)(OneWire *ow);		/**< Process reading into attached buffer */
+	OneWire_Result(*triplet)(OneWire *ow);	/**< [Optional] Process search triplet */
+	OneWire_Result(*pullup)(OneWire *ow, OneWire_Bool enable);	/**< [Optional] Process arming (enable) or release of strong pullup */
+} OneWire_Transport;
+
 // Primary struct
 
 typedef union OneWireSubState
@@ -132,26 +328,45 @@ typedef union OneWireSubState
 	OneWire_StartState startState;			/**< State of one wire start */
 	OneWire_WriteState writeState;			/**< State of one wire write */
 	OneWire_ReadState readState;			/**< State of one wire read */
+	OneWire_UartState uartState;			/**< State of UART transfer */
 } OneWireSubState;
 
 typedef struct OneWire
 {
 	OneWire_Id id;							/**< Used-specific onewire interface ID used for interface identification in case more than one onewire interfaces are used */
 
+	const OneWire_Transport *transport;		/**< Physical transport @see OneWire_Transport */
+	void *transportData;					/**< [Optional] Transport specific data */
+
 	OneWire_Byte *buffer;					/**< Attached data buffer */
 	OneWire_Size bufferLength;				/**< Data buffer length */
 	OneWire_Byte bitLength;
 	OneWire_Size byteIndex;					/**< Currently processed byte */
 	OneWire_Size bitIndex;					/**< Currently processed bit */
+	OneWire_Byte crc;						/**< Running CRC of the data read so far, or of the address found by the last search pass */
+	OneWire_Bool presence;					/**< Set when a device answered last reset with presence pulse */
+
+	const OneWire_Transaction *transaction;	/**< Transaction in progress */
+	OneWire_TransactionState transactionState;	/**< Phase of transaction in progress */
 
 #ifdef ONEWIRE_SEARCH
 	OneWire_SearchState searchState;		/**< State of one wire device search */
 	OneWire_Address searchedAddress;		/**< Currently searched address */
 	OneWire_Address searchBitIdx;
 	OneWire_Address searchLastDiscrepancy;
+	OneWire_Address searchTarget;			/**< Address bits forced by targeted search */
+	OneWire_Address searchTargetMask;		/**< Mask of address bits forced by targeted search */
 	OneWire_Byte searchHelper;
 
-	OneWire_Search_Cb onSearchDone;
+	OneWire_Search_Cb onSearchDone;			/**< [Optional] Callback fired for every found address */
+	OneWire_RomTable *searchTable;			/**< [Optional] Table collecting found addresses */
+	OneWire_Count searchCount;				/**< Number of addresses found by current search */
+	OneWire_SlotCount searchSlots;			/**< Number of time slots used by current search */
+	OneWire_Search *searchContext;			/**< Context of time-sliced search in progress, null for plain search */
+
+	const OneWire_RomTable *verifyTable;	/**< Table of ROMs being verified */
+	OneWire_Byte *verifyBitmap;				/**< Presence bitmap being filled by verification */
+	OneWire_Count verifyIndex;				/**< Index of ROM being verified */
 #endif
 
 	OneWire_SetPinDirection setPinDir;		/**< Set pin direction */
@@ -161,12 +376,121 @@ typedef struct OneWire
 	OneWire_StartTimer startTimer;			/**< Restart timer counter */
 	OneWire_ReadTimer readTimer;			/**< Read timer value [us] */
 
+#ifdef ONEWIRE_UART
+	OneWire_UartSetBaud uartSetBaud;		/**< Set UART baud rate */
+	OneWire_UartTransfer uartTransfer;		/**< Begin transmitting given characters and receiving the echo in place, may use DMA */
+	OneWire_UartTransferDone uartTransferDone;	/**< Check if all echoed characters have been received */
+	OneWire_Byte uartFrame[ONEWIRE_UART_FRAME_SIZE];	/**< Characters being transferred */
+	OneWire_Size uartLength;				/**< Number of characters being transferred */
+#endif
+
 	OneWire_Detected detectedCallback;		/**< [Optional] Callback fired when one wire presence pulse is detected */
+	OneWire_Counter resetRecovery;			/**< Gap between reset sequence and first time slot [us], may be raised for long or heavily loaded buses */
+
+	OneWire_Counter timerDelay;				/**< Currently awaited delay [us] */
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	OneWire_Counter timerStart;				/**< Counter value at which currently awaited delay started */
+#endif
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	OneWire_ScheduleTimer scheduleTimer;	/**< Set timer compare to given absolute counter value, compare interrupt must call onewireTimerInterrupt */
+	OneWire_Bool timerScheduled;			/**< Set when state machine has scheduled next compare */
+	OneWire_Result result;					/**< Result of last operation, reported once by onewireProcess */
+#endif
 
 	OneWire_State state;					/**< Currently processed function */
 	OneWireSubState substate;				/**< Current one wire sub state */
 } OneWire;
 
+// Port binding
+
+#ifdef ONEWIRE_PORT_HEADER
+#include ONEWIRE_PORT_HEADER
+#endif
+
+static inline void onewireSetPinDir(const OneWire *ow, OneWire_PinDirection dir)
+{
+#ifdef ONEWIRE_PORT_HEADER
+	onewirePortSetPinDir(ow, dir);
+#else
+	ow->setPinDir(ow, dir);
+#endif
+}
+
+static inline void onewireSetPinState(const OneWire *ow, OneWire_PinState state)
+{
+#ifdef ONEWIRE_PORT_HEADER
+	onewirePortSetPinState(ow, state);
+#else
+	ow->setPinState(ow, state);
+#endif
+}
+
+static inline OneWire_PinState onewireReadPin(const OneWire *ow)
+{
+#ifdef ONEWIRE_PORT_HEADER
+	return onewirePortReadPin(ow);
+#else
+	return ow->readPin(ow);
+#endif
+}
+
+static inline void onewireStartTimer(const OneWire *ow)
+{
+#ifdef ONEWIRE_PORT_HEADER
+	onewirePortStartTimer(ow);
+#else
+	ow->startTimer(ow);
+#endif
+}
+
+static inline OneWire_Counter onewireReadTimer(const OneWire *ow)
+{
+#ifdef ONEWIRE_PORT_HEADER
+	return onewirePortReadTimer(ow);
+#else
+	return ow->readTimer(ow);
+#endif
+}
+
+// Timebase
+
+/**
+ * @brief Start measuring time from now - restarts the counter, or takes its snapshot with ONEWIRE_FREE_RUNNING_TIMER
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ */
+static inline void onewireTimerRestart(OneWire *ow)
+{
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	ow->timerStart = onewireReadTimer(ow);
+#else
+	onewireStartTimer(ow);
+#endif
+}
+
+/**
+ * @brief Get time elapsed since last onewireTimerRestart, correct across counter wrap
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @return elapsed time [us]
+ */
+static inline OneWire_Counter onewireTimerElapsed(const OneWire *ow)
+{
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	return (OneWire_Counter)(onewireReadTimer(ow) - ow->timerStart);
+#else
+	return onewireReadTimer(ow);
+#endif
+}
+
+// Transports
+
+extern const OneWire_Transport onewireBitBangTransport;	/**< GPIO bit-banging transport, used by onewireInit */
+
+#ifdef ONEWIRE_UART
+extern const OneWire_Transport onewireUartTransport;	/**< UART transport, used by onewireInitUart */
+#endif
+
 // Public functions
 
 /**
@@ -179,9 +503,39 @@ typedef struct OneWire
  * @param readPin callback to read pin state (read pin value)
  * @param startTimer callback to restart timer counter - counter must have 1us period
  * @param readTimer callback to read timer counter [us]
+ *
+ * When ONEWIRE_PORT_HEADER is defined, the callbacks are not used and may be set to null.
  */
 void onewireInit(OneWire *ow, OneWire_Id id, OneWire_SetPinDirection setPinDir, OneWire_SetPinState setPinState, OneWire_ReadPin readPin, OneWire_StartTimer startTimer, OneWire_ReadTimer readTimer);
 
+/**
+ * @brief Initialize OneWire interface using custom transport
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param id user-assigned ID used to identify which OneWire interface is being used in callbacks
+ * @param transport transport implementation @see OneWire_Transport
+ * @param transportData transport specific data, available to the transport as `transportData` field
+ * @param startTimer callback to restart timer counter, used by DS18B20 module for its delays
+ * @param readTimer callback to read timer counter [us], used by DS18B20 module for its delays
+ */
+void onewireInitTransport(OneWire *ow, OneWire_Id id, const OneWire_Transport *transport, void *transportData, OneWire_StartTimer startTimer, OneWire_ReadTimer readTimer);
+
+#ifdef ONEWIRE_UART
+/**
+ * @brief Initialize OneWire interface using UART transport. Reset is sent at 9600 baud and every time slot is
+ * a single character at 115200 baud, so whole bytes and commands are transferred as a batch of characters.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param id user-assigned ID used to identify which OneWire interface is being used in callbacks
+ * @param setBaud callback to change UART baud rate
+ * @param transfer callback to begin transfer of given characters, received echo must be stored back into the same buffer
+ * @param transferDone callback to check if transfer has finished
+ * @param startTimer callback to restart timer counter, used by DS18B20 module for its delays
+ * @param readTimer callback to read timer counter [us], used by DS18B20 module for its delays
+ */
+void onewireInitUart(OneWire *ow, OneWire_Id id, OneWire_UartSetBaud setBaud, OneWire_UartTransfer transfer, OneWire_UartTransferDone transferDone, OneWire_StartTimer startTimer, OneWire_ReadTimer readTimer);
+#endif
+
 /**
  * @brief Process OneWire state machine - this function is required to work in program's main loop
  *
@@ -190,6 +544,24 @@ void onewireInit(OneWire *ow, OneWire_Id id, OneWire_SetPinDirection setPinDir,
  */
 OneWire_Result onewireProcess(OneWire *ow);
 
+/**
+ * @brief Get time until onewireProcess next needs to be called. Bit-banging transport reports remaining part of the awaited
+ * delay, other transports have to be polled and report 0. The main loop may sleep or do other work until then.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @return time until next service [us], or ONEWIRE_SERVICE_NONE when idle
+ */
+OneWire_Counter onewireTimeToService(const OneWire *ow);
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+/**
+ * @brief Advance OneWire state machine - this function must be called from timer compare interrupt scheduled with `scheduleTimer`
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ */
+void onewireTimerInterrupt(OneWire *ow);
+#endif
+
 /**
  * @brief Begin OneWire start operation
  *
@@ -216,7 +588,25 @@ void onewireWrite(OneWire *ow, OneWire_Byte *buffer, OneWire_Size length);
 void onewireRead(OneWire *ow, OneWire_Byte *buffer, OneWire_Size length);
 
 /**
- * @brief Begin OneWire search operation
+ * @brief Begin OneWire transaction - all its phases are processed as a single operation, finished with OneWire_Success,
+ * or with OneWire_Failed when a stop rule fails it
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param transaction transaction to process, must stay valid until finished @see OneWire_Transaction
+ */
+void onewireTransact(OneWire *ow, const OneWire_Transaction *transaction);
+
+/**
+ * @brief Begin OneWire read of a single time slot, the bit is ORed into bit 0 of given byte
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param bit byte to store the bit to, should be cleared before the read
+ */
+void onewireReadBit(OneWire *ow, OneWire_Byte *bit);
+
+/**
+ * @brief Begin OneWire search operation. onewireProcess returns OneWire_Failed when the transport fails, e.g. a bridge
+ * does not acknowledge, the search then has to be started again.
  *
  * @param ow pointer to OneWire structure @see OneWire
  * @param alarm when set to OneWire_True then only devices with alarm flag set will be found
@@ -224,13 +614,90 @@ void onewireRead(OneWire *ow, OneWire_Byte *buffer, OneWire_Size length);
 void onewireSearch(OneWire *ow, OneWire_Bool alarm);
 
 /**
- * @brief Begin OneWire search operation for devices from specific family
+ * @brief Begin OneWire search operation for devices from specific family. Search path is pre-seeded with the family code,
+ * so devices from other families are never enumerated and the search ends as soon as no device of given family is left.
  *
  * @param ow pointer to OneWire structure @see OneWire
  * @param alarm when set to OneWire_True then only devices with alarm flag set will be found
+ * @param familyCode family code of searched devices
  */
 void onewireSearchTarget(OneWire *ow, OneWire_Bool alarm, OneWire_Byte familyCode);
 
+/**
+ * @brief Begin OneWire search operation collecting results into given ROM table. Every found ROM has its CRC verified,
+ * duplicates are dropped and the table is kept sorted. Once onewireProcess returns OneWire_Success, the table holds
+ * all found devices, and its `overflow` flag tells if any device did not fit.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param table pointer to initialized ROM table, cleared before the search @see OneWire_RomTable
+ * @param alarm when set to OneWire_True then only devices with alarm flag set will be found
+ * @param familyCode family code of searched devices, or ONEWIRE_FAMILY_ANY to search all devices
+ */
+void onewireSearchTable(OneWire *ow, OneWire_RomTable *table, OneWire_Bool alarm, OneWire_Byte familyCode);
+
+/**
+ * @brief Begin incremental re-enumeration of a single subtree of the search tree - devices sharing the lowest `depth` bits
+ * with `rom`. Such ROMs form a contiguous range of the sorted table, which is replaced by the devices found, while
+ * the rest of the table is kept without walking its branches. Depth 0 rescans the whole bus, depth 8 a single family.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param table pointer to ROM table filled by previous search @see OneWire_RomTable
+ * @param rom any ROM code from the subtree, only its lowest `depth` bits are used
+ * @param depth number of ROM bits identifying the subtree, 0 to 64
+ */
+void onewireSearchUpdate(OneWire *ow, OneWire_RomTable *table, OneWire_Address rom, OneWire_Size depth);
+
+/**
+ * @brief Initialize time-sliced search collecting results into given ROM table, the search is run by onewireSearchContinue
+ *
+ * @param search pointer to search context @see OneWire_Search
+ * @param table pointer to initialized ROM table, cleared here @see OneWire_RomTable
+ * @param alarm when set to OneWire_True then only devices with alarm flag set will be found
+ * @param familyCode family code of searched devices, or ONEWIRE_FAMILY_ANY to search all devices
+ * @param budget maximum number of time slots of a single slice, 0 to yield after every found ROM, a slice always finishes at least one pass
+ */
+void onewireSearchInit(OneWire_Search *search, OneWire_RomTable *table, OneWire_Bool alarm, OneWire_Byte familyCode, OneWire_SlotCount budget);
+
+/**
+ * @brief Begin next slice of time-sliced search. onewireProcess returns OneWire_Success at the end of the slice, and
+ * the interface is free for other operations until the next call. The search is finished once `done` is set.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param search pointer to search context @see OneWire_Search
+ */
+void onewireSearchContinue(OneWire *ow, OneWire_Search *search);
+
+/**
+ * @brief Get number of time slots saved by the last search compared to a naive enumeration of all devices in its table,
+ * one full pass per device
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @return saved time slots, 0 when the search did not use fewer slots
+ */
+OneWire_SlotCount onewireSearchSlotsSaved(const OneWire *ow);
+
+/**
+ * @brief Begin verification whether device with given ROM is present on the bus. This is a search seeded with the whole ROM
+ * which stops at first divergence, so it is much cheaper than full enumeration, especially for missing devices.
+ * Once finished, onewireProcess returns OneWire_Success if the device is present, or OneWire_Failed otherwise
+ * (including transport failure).
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param rom ROM code of the device
+ */
+void onewireVerify(OneWire *ow, OneWire_Address rom);
+
+/**
+ * @brief Begin verification of presence of every device from given ROM table. Once onewireProcess returns OneWire_Success,
+ * bit N of the bitmap (bit N % 8 of byte N / 8) is set when device N of the table is present, and cleared when it is missing.
+ * Empty table finishes with OneWire_Success without any bus activity.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @param table table of ROMs to verify, must not change during verification @see OneWire_RomTable
+ * @param bitmap presence bitmap, at least (count + 7) / 8 bytes long
+ */
+void onewireVerifyTable(OneWire *ow, const OneWire_RomTable *table, OneWire_Byte *bitmap);
+
 /**
  * @brief Break currently processing search
  *
@@ -238,20 +705,90 @@ void onewireSearchTarget(OneWire *ow, OneWire_Bool alarm, OneWire_Byte familyCod
  */
 void onewireAbortSearch(OneWire *ow);
 
+/**
+ * @brief Initialize ROM table with caller-provided storage
+ *
+ * @param table pointer to ROM table @see OneWire_RomTable
+ * @param roms storage for ROM codes
+ * @param capacity number of ROM codes the storage can hold
+ */
+void onewireRomTableInit(OneWire_RomTable *table, OneWire_Address *roms, OneWire_Count capacity);
+
+/**
+ * @brief Find ROM in ROM table using binary search
+ *
+ * @param table pointer to ROM table @see OneWire_RomTable
+ * @param rom ROM code to find
+ * @return index of the ROM in the table, or ONEWIRE_ROM_NOT_FOUND
+ */
+OneWire_Count onewireRomTableFind(const OneWire_RomTable *table, OneWire_Address rom);
+
+/**
+ * @brief Insert ROM into ROM table keeping it sorted
+ *
+ * @param table pointer to ROM table @see OneWire_RomTable
+ * @param rom ROM code to insert
+ * @return OneWire_True if ROM was inserted, OneWire_False if it was already present or the table is full
+ */
+OneWire_Bool onewireRomTableInsert(OneWire_RomTable *table, OneWire_Address rom);
+
+/**
+ * @brief Get depth of the smallest subtree of the search tree holding ROM N of the table and no other known ROM. Sorted table
+ * encodes the whole tree - neighbouring ROMs branch at their lowest differing bit - so this is one more than the number
+ * of lowest bits the ROM shares with its closest neighbour. Together with the ROM it selects the branch to rescan
+ * with onewireSearchUpdate when the device went missing or was replaced.
+ *
+ * @param table pointer to ROM table @see OneWire_RomTable
+ * @param index index of the ROM in the table
+ * @return subtree depth, 0 when the ROM is the only one in the table
+ */
+OneWire_Size onewireRomTableSubtree(const OneWire_RomTable *table, OneWire_Count index);
+
 /**
  * @brief Calculate one wire CRC
  *
  * @param buffer one wire data buffer to verify
- * @param len complete length of one wire data
- * @return
+ * @param len complete length of one wire data (including CRC byte)
+ * @return CRC calculated over all bytes but the last one
+ */
+OneWire_Byte onewireCrc(const OneWire_Byte *buffer, OneWire_Size len);
+
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+/** CRC8 lookup table used by onewireCrc, shared with batch verification */
+extern const OneWire_Byte onewireCrcTable[256];
+#endif
+
+/**
+ * @brief Update Dallas CRC8 with a single bit
+ *
+ * @param crc current CRC value
+ * @param bit next bit of data
+ * @return updated CRC value
  */
-OneWire_Byte onewireCrc(OneWire_Byte *buffer, OneWire_Size len);
+static inline OneWire_Byte onewireCrcBit(OneWire_Byte crc, OneWire_Bool bit)
+{
+	return ((crc ^ bit) & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+}
+
+/**
+ * @brief Get CRC of data read by the last read operation. The CRC is updated with every received bit, so it is
+ * available as soon as the read is finished. When the read data ends with its own CRC byte, the result is zero for valid data.
+ *
+ * @param ow pointer to OneWire structure @see OneWire
+ * @return running CRC of the read data
+ */
+static inline OneWire_Byte onewireGetCrc(const OneWire *ow)
+{
+	return ow->crc;
+}
 
 static inline void onewireWait(OneWire *ow)
 {
-  do {
+  onewireProcess(ow);
+  while(ow->state != OneWire_Idle) {
+	  ONEWIRE_WAIT_IDLE(onewireTimeToService(ow));
 	  onewireProcess(ow);
-  } while(ow->state != OneWire_Idle);
+  }
 }
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef _h_onewire_batch
+#define _h_onewire_batch
+
+#include "onewire.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Definitions
+
+/**
+ * @brief CRC kernels, vector ones are available only when built for and supported by the running CPU
+ */
+typedef enum OneWire_BatchKernel
+{
+	OneWire_Batch_Scalar,		/**< Portable C, byte table lookups record by record */
+	OneWire_Batch_SSSE3,		/**< x86 SSSE3, 16 records transposed into lanes, nibble table shuffles */
+	OneWire_Batch_AVX2,			/**< x86 AVX2, 32 records transposed into lanes, nibble table shuffles */
+	OneWire_Batch_NEON			/**< AArch64 NEON, 16 records transposed into lanes, nibble table lookups */
+} OneWire_BatchKernel;
+
+// Public functions
+
+/**
+ * @brief Verify CRC of many fixed-length records at once, e.g. ROM codes (8 bytes) or scratchpads (9 bytes). A record is valid
+ * when its last byte is CRC of the preceding ones, the same as onewireCrc(record, length) == record[length - 1].
+ * Unless a kernel was selected by onewireBatchSelect, the fastest one supported by the CPU is used. Vector kernels handle
+ * records of up to 16 bytes, longer ones are checked by the scalar kernel.
+ *
+ * @param records first byte of the first record
+ * @param stride distance between consecutive records [bytes]
+ * @param length record length including CRC byte, at least 1
+ * @param count number of records
+ * @param bitmap validity bitmap, bit N % 8 of byte N / 8 is set when record N is valid, (count + 7) / 8 bytes are written
+ */
+void onewireBatchCrc(const OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count, OneWire_Byte *bitmap);
+
+/**
+ * @brief Select CRC kernel, not to be called while another thread verifies records
+ *
+ * @param kernel kernel to use @see OneWire_BatchKernel
+ * @return OneWire_True if the kernel was selected, OneWire_False when it is not available on this build or CPU
+ */
+OneWire_Bool onewireBatchSelect(OneWire_BatchKernel kernel);
+
+/**
+ * @brief Get currently used CRC kernel
+ *
+ * @return kernel @see OneWire_BatchKernel
+ */
+OneWire_BatchKernel onewireBatchKernel(void);
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef _h_onewire_multi
+#define _h_onewire_multi
+
+#include "onewire.h"
+
+#include <stdint.h>
+
+// Port definitions
+
+/** @brief GPIO port word, bus N is driven by port bit N */
+typedef uint32_t OneWireMulti_Port;
+
+/** @def ONEWIRE_MULTI_BUSES maximum number of buses driven by a single engine */
+#define ONEWIRE_MULTI_BUSES (sizeof(OneWireMulti_Port) * 8)
+
+// State machine state
+
+typedef enum OneWireMulti_State
+{
+	OneWireMulti_Idle,				/**< Engine is not doing anything */
+	OneWireMulti_Starting,			/**< Reset pulse is being sent to all buses */
+	OneWireMulti_Writing,			/**< Data is being transmitted to all buses */
+	OneWireMulti_Reading			/**< Data is being read from all buses */
+} OneWireMulti_State;
+
+typedef enum OneWireMulti_SlotState
+{
+	OneWireMulti_Slot_Begin,
+	OneWireMulti_Slot_1,
+	OneWireMulti_Slot_2,
+	OneWireMulti_Slot_3
+} OneWireMulti_SlotState;
+
+// Definitions
+
+typedef struct OneWireMulti OneWireMulti;
+
+/**
+ * @brief Single masked write of the port - buses set in `low` must be pulled low, all other buses of `busMask` released
+ * (e.g. one BSRR store on STM32 with the pins in open-drain mode)
+ */
+typedef void(*OneWireMulti_SetPort)(const OneWireMulti *owm, OneWireMulti_Port low);
+
+/**
+ * @brief Read the whole input port, bits outside of `busMask` are ignored
+ */
+typedef OneWireMulti_Port(*OneWireMulti_ReadPort)(const OneWireMulti *owm);
+
+typedef void(*OneWireMulti_StartTimer)(const OneWireMulti *owm);
+typedef OneWire_Counter(*OneWireMulti_ReadTimer)(const OneWireMulti *owm);
+
+// Primary struct
+
+/**
+ * @brief Engine driving every bus of `busMask` in lockstep. Every time slot is one port write per edge and one port read,
+ * per-bus data is (de)multiplexed 8 slots at a time with a bit matrix transpose.
+ */
+typedef struct OneWireMulti
+{
+	OneWireMulti_Port busMask;				/**< Port bits driving buses */
+	OneWireMulti_Port presence;				/**< Buses which answered last reset with presence pulse */
+
+	OneWireMulti_SetPort setPort;			/**< Masked port write */
+	OneWireMulti_ReadPort readPort;			/**< Port read */
+	OneWireMulti_StartTimer startTimer;		/**< Restart timer counter */
+	OneWireMulti_ReadTimer readTimer;		/**< Read timer value [us] */
+
+	OneWire_Byte *buffer;					/**< Attached data, bytes of bus N start at buffer + N * stride */
+	OneWire_Size bufferLength;				/**< Number of bytes transferred on every bus */
+	OneWire_Size stride;					/**< Distance between buffers of consecutive buses, 0 to write the same data to all buses */
+	OneWire_Size byteIndex;					/**< Currently processed byte */
+	OneWire_Size bitIndex;					/**< Currently processed bit */
+
+	OneWireMulti_Port slots[8];				/**< Port words of current byte, one per time slot */
+
+	OneWire_Counter timerDelay;				/**< Currently awaited delay [us] */
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	OneWire_Counter timerStart;				/**< Counter value at which currently awaited delay started */
+#endif
+
+	OneWireMulti_State state;				/**< Currently processed function */
+	OneWireMulti_SlotState slotState;		/**< Current time slot sub state */
+} OneWireMulti;
+
+// Public functions
+
+/**
+ * @brief Initialize multi-bus engine
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ * @param busMask port bits with 1-Wire buses attached
+ * @param setPort callback to write the port
+ * @param readPort callback to read the port
+ * @param startTimer callback to restart timer counter - counter must have 1us period, unused with ONEWIRE_FREE_RUNNING_TIMER
+ * @param readTimer callback to read timer counter [us]
+ */
+void onewireMultiInit(OneWireMulti *owm, OneWireMulti_Port busMask, OneWireMulti_SetPort setPort, OneWireMulti_ReadPort readPort, OneWireMulti_StartTimer startTimer, OneWireMulti_ReadTimer readTimer);
+
+/**
+ * @brief Process multi-bus state machine - this function is required to work in program's main loop
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ * @return current operation status @see OneWire_Result
+ */
+OneWire_Result onewireMultiProcess(OneWireMulti *owm);
+
+/**
+ * @brief Begin reset of all buses. Once finished, `presence` holds buses with at least one device attached.
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ */
+void onewireMultiStart(OneWireMulti *owm);
+
+/**
+ * @brief Begin writing to all buses
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ * @param buffer data to write, bytes of bus N start at buffer + N * stride
+ * @param length number of bytes written to every bus
+ * @param stride distance between buffers of consecutive buses, 0 to write the same bytes to all buses
+ */
+void onewireMultiWrite(OneWireMulti *owm, OneWire_Byte *buffer, OneWire_Size length, OneWire_Size stride);
+
+/**
+ * @brief Begin reading from all buses. Buffer must cover every bus up to the highest bit of `busMask`.
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ * @param buffer buffer to store the data to, bytes of bus N start at buffer + N * stride
+ * @param length number of bytes read from every bus
+ * @param stride distance between buffers of consecutive buses, at least `length`
+ */
+void onewireMultiRead(OneWireMulti *owm, OneWire_Byte *buffer, OneWire_Size length, OneWire_Size stride);
+
+/**
+ * @brief Check CRC of data read by last onewireMultiRead on every bus
+ *
+ * @param owm pointer to OneWireMulti structure @see OneWireMulti
+ * @return buses whose data ends with a valid CRC byte, 0 when no data was read
+ */
+OneWireMulti_Port onewireMultiCrcValid(const OneWireMulti *owm);
+
+#endif
@@ -0,0 +1,408 @@
+#include "ds18b20_batch.h"
+#include "onewire_batch.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DSB_SSE2
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define DSB_AVX2
+#endif
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DSB_NEON
+#endif
+
+// Definitions
+
+/** @def DSB_CRC_BLOCK number of scratchpads passed to onewireBatchCrc at once, multiple of every CRC kernel block */
+#define DSB_CRC_BLOCK 256
+
+/**
+ * @brief Decoding of a block of scratchpads starting at `index`, block length is given by the kernel table
+ */
+typedef void(*DSB_Kernel)(const DS18B20_Byte *scratchpads, size_t stride, size_t index, const DS18B20_BatchOutput *out);
+
+/**
+ * @brief Kernel table entry
+ */
+typedef struct DSB_KernelEntry
+{
+	DSB_Kernel decode;			/**< Decoding function, null when not built for this target */
+	size_t block;				/**< Number of scratchpads decoded at once */
+} DSB_KernelEntry;
+
+// Private variables
+
+/** Kernel forced by ds18b20BatchSelect, the fastest one is picked on every call otherwise */
+static DS18B20_Bool dsb_selected;
+static DS18B20_BatchKernel dsb_kernel;
+
+// Private functions
+
+static void dsb_decodeScalar(const DS18B20_Byte *scratchpads, size_t stride, size_t index, size_t count, const DS18B20_BatchOutput *out)
+{
+	for (size_t i = index; i < index + count; ++i)
+	{
+		const DS18B20_Byte *sp = scratchpads + i * stride;
+
+		out->milli[i] = ds18b20RawToMilli(ds18b20MaskRaw((int16_t)(sp[0] | (sp[1] << 8)), (DS18B20Resolution)sp[4]));
+
+		if (out->resolution)
+			out->resolution[i] = 9 + ((sp[4] >> 5) & 0x03);
+		if (out->userByte1)
+			out->userByte1[i] = sp[2];
+		if (out->userByte2)
+			out->userByte2[i] = sp[3];
+	}
+}
+
+static void dsb_kernelScalar(const DS18B20_Byte *scratchpads, size_t stride, size_t index, const DS18B20_BatchOutput *out)
+{
+	dsb_decodeScalar(scratchpads, stride, index, 1, out);
+}
+
+/*
+ * Vector kernels load the first 8 bytes of 16 scratchpads, which never reaches past the CRC byte, pairs of scratchpads K and K + 8
+ * sharing one register. Three rounds of interleaving register K with register K + 4 rotate the 7-bit register:byte index by one bit
+ * each, after which register 4H + M holds bytes 2M (low half) and 2M + 1 (high half) of scratchpads 8H to 8H + 7. Joining halves
+ * of registers M and 4 + M then gives byte J of every scratchpad in its own lane of row J, only rows 0 to 4 are built.
+ * Fields are decoded in all lanes at once: resolution bits of the configuration register give the mask of undefined temperature
+ * bits, and the masked temperature is scaled by 125 / 2 with halving truncated toward zero, the same as ds18b20MaskRaw and
+ * ds18b20RawToMilli.
+ */
+
+#ifdef DSB_SSE2
+static inline void dsb_rowsSSE2(const DS18B20_Byte *sp, size_t stride, __m128i *rows)
+{
+	__m128i a[8];
+	__m128i b[8];
+
+	for (size_t k = 0; k < 8; ++k)
+		a[k] = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(sp + k * stride)), _mm_loadl_epi64((const __m128i*)(sp + (k + 8) * stride)));
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		b[2 * k] = _mm_unpacklo_epi8(a[k], a[k + 4]);
+		b[2 * k + 1] = _mm_unpackhi_epi8(a[k], a[k + 4]);
+	}
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		a[2 * k] = _mm_unpacklo_epi8(b[k], b[k + 4]);
+		a[2 * k + 1] = _mm_unpackhi_epi8(b[k], b[k + 4]);
+	}
+
+	// Last round only for registers holding bytes 0 to 5
+	b[0] = _mm_unpacklo_epi8(a[0], a[4]);
+	b[1] = _mm_unpackhi_epi8(a[0], a[4]);
+	b[2] = _mm_unpacklo_epi8(a[1], a[5]);
+	b[4] = _mm_unpacklo_epi8(a[2], a[6]);
+	b[5] = _mm_unpackhi_epi8(a[2], a[6]);
+	b[6] = _mm_unpacklo_epi8(a[3], a[7]);
+
+	rows[0] = _mm_unpacklo_epi64(b[0], b[4]);
+	rows[1] = _mm_unpackhi_epi64(b[0], b[4]);
+	rows[2] = _mm_unpacklo_epi64(b[1], b[5]);
+	rows[3] = _mm_unpackhi_epi64(b[1], b[5]);
+	rows[4] = _mm_unpacklo_epi64(b[2], b[6]);
+}
+
+static inline void dsb_milliSSE2(__m128i raw, int32_t *milli)
+{
+	// 16x16 bit multiply split into low and high halves, interleaved back into 32-bit products
+	const __m128i factor = _mm_set1_epi16(125);
+	__m128i lo = _mm_mullo_epi16(raw, factor);
+	__m128i hi = _mm_mulhi_epi16(raw, factor);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Halving truncated toward zero - negative values are rounded up by adding their sign bit
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_srli_epi32(p0, 31)), 1);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_srli_epi32(p1, 31)), 1);
+
+	_mm_storeu_si128((__m128i*)milli, p0);
+	_mm_storeu_si128((__m128i*)(milli + 4), p1);
+}
+
+static void dsb_kernelSSE2(const DS18B20_Byte *scratchpads, size_t stride, size_t index, const DS18B20_BatchOutput *out)
+{
+	__m128i rows[5];
+
+	dsb_rowsSSE2(scratchpads + index * stride, stride, rows);
+
+	// Resolution - 9 in configuration register bits 5 and 6, bits shifted in from the neighbouring byte are masked off
+	__m128i res = _mm_and_si128(_mm_srli_epi16(rows[4], 5), _mm_set1_epi8(0x03));
+	__m128i mask = _mm_set1_epi8((char)0xF8);
+	mask = _mm_or_si128(mask, _mm_and_si128(_mm_cmpgt_epi8(res, _mm_set1_epi8(0)), _mm_set1_epi8(0x04)));
+	mask = _mm_or_si128(mask, _mm_and_si128(_mm_cmpgt_epi8(res, _mm_set1_epi8(1)), _mm_set1_epi8(0x02)));
+	mask = _mm_or_si128(mask, _mm_and_si128(_mm_cmpgt_epi8(res, _mm_set1_epi8(2)), _mm_set1_epi8(0x01)));
+
+	__m128i lsb = _mm_and_si128(rows[0], mask);
+	dsb_milliSSE2(_mm_unpacklo_epi8(lsb, rows[1]), out->milli + index);
+	dsb_milliSSE2(_mm_unpackhi_epi8(lsb, rows[1]), out->milli + index + 8);
+
+	if (out->resolution)
+		_mm_storeu_si128((__m128i*)(out->resolution + index), _mm_add_epi8(res, _mm_set1_epi8(9)));
+	if (out->userByte1)
+		_mm_storeu_si128((__m128i*)(out->userByte1 + index), rows[2]);
+	if (out->userByte2)
+		_mm_storeu_si128((__m128i*)(out->userByte2 + index), rows[3]);
+}
+#endif
+
+#ifdef DSB_AVX2
+__attribute__((target("avx2")))
+static inline __m256i dsb_loadAVX2(const DS18B20_Byte *sp, size_t stride, size_t k)
+{
+	// Lane 0 holds scratchpads K and K + 8, lane 1 scratchpads K + 16 and K + 24, unpacking works within lanes
+	__m128i first = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(sp + k * stride)), _mm_loadl_epi64((const __m128i*)(sp + (k + 8) * stride)));
+	__m128i second = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(sp + (k + 16) * stride)), _mm_loadl_epi64((const __m128i*)(sp + (k + 24) * stride)));
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+}
+
+__attribute__((target("avx2")))
+static inline void dsb_rowsAVX2(const DS18B20_Byte *sp, size_t stride, __m256i *rows)
+{
+	__m256i a[8];
+	__m256i b[8];
+
+	for (size_t k = 0; k < 8; ++k)
+		a[k] = dsb_loadAVX2(sp, stride, k);
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		b[2 * k] = _mm256_unpacklo_epi8(a[k], a[k + 4]);
+		b[2 * k + 1] = _mm256_unpackhi_epi8(a[k], a[k + 4]);
+	}
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		a[2 * k] = _mm256_unpacklo_epi8(b[k], b[k + 4]);
+		a[2 * k + 1] = _mm256_unpackhi_epi8(b[k], b[k + 4]);
+	}
+
+	b[0] = _mm256_unpacklo_epi8(a[0], a[4]);
+	b[1] = _mm256_unpackhi_epi8(a[0], a[4]);
+	b[2] = _mm256_unpacklo_epi8(a[1], a[5]);
+	b[4] = _mm256_unpacklo_epi8(a[2], a[6]);
+	b[5] = _mm256_unpackhi_epi8(a[2], a[6]);
+	b[6] = _mm256_unpacklo_epi8(a[3], a[7]);
+
+	rows[0] = _mm256_unpacklo_epi64(b[0], b[4]);
+	rows[1] = _mm256_unpackhi_epi64(b[0], b[4]);
+	rows[2] = _mm256_unpacklo_epi64(b[1], b[5]);
+	rows[3] = _mm256_unpackhi_epi64(b[1], b[5]);
+	rows[4] = _mm256_unpacklo_epi64(b[2], b[6]);
+}
+
+__attribute__((target("avx2")))
+static inline void dsb_milliAVX2(__m256i raw, int32_t *milli)
+{
+	const __m256i factor = _mm256_set1_epi16(125);
+	__m256i lo = _mm256_mullo_epi16(raw, factor);
+	__m256i hi = _mm256_mulhi_epi16(raw, factor);
+
+	// Unpacking works within 128-bit lanes, so products come out as 0-3, 8-11 and 4-7, 12-15
+	__m256i a = _mm256_unpacklo_epi16(lo, hi);
+	__m256i b = _mm256_unpackhi_epi16(lo, hi);
+
+	a = _mm256_srai_epi32(_mm256_add_epi32(a, _mm256_srli_epi32(a, 31)), 1);
+	b = _mm256_srai_epi32(_mm256_add_epi32(b, _mm256_srli_epi32(b, 31)), 1);
+
+	_mm256_storeu_si256((__m256i*)milli, _mm256_permute2x128_si256(a, b, 0x20));
+	_mm256_storeu_si256((__m256i*)(milli + 8), _mm256_permute2x128_si256(a, b, 0x31));
+}
+
+__attribute__((target("avx2")))
+static void dsb_kernelAVX2(const DS18B20_Byte *scratchpads, size_t stride, size_t index, const DS18B20_BatchOutput *out)
+{
+	__m256i rows[5];
+
+	dsb_rowsAVX2(scratchpads + index * stride, stride, rows);
+
+	__m256i res = _mm256_and_si256(_mm256_srli_epi16(rows[4], 5), _mm256_set1_epi8(0x03));
+	__m256i mask = _mm256_set1_epi8((char)0xF8);
+	mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_cmpgt_epi8(res, _mm256_set1_epi8(0)), _mm256_set1_epi8(0x04)));
+	mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_cmpgt_epi8(res, _mm256_set1_epi8(1)), _mm256_set1_epi8(0x02)));
+	mask = _mm256_or_si256(mask, _mm256_and_si256(_mm256_cmpgt_epi8(res, _mm256_set1_epi8(2)), _mm256_set1_epi8(0x01)));
+
+	// Quadwords reordered to 0-7, 16-23 | 8-15, 24-31, so that byte interleaving gives temperatures 0-15 and 16-31 in order
+	__m256i lsb = _mm256_permute4x64_epi64(_mm256_and_si256(rows[0], mask), 0xD8);
+	__m256i msb = _mm256_permute4x64_epi64(rows[1], 0xD8);
+	dsb_milliAVX2(_mm256_unpacklo_epi8(lsb, msb), out->milli + index);
+	dsb_milliAVX2(_mm256_unpackhi_epi8(lsb, msb), out->milli + index + 16);
+
+	if (out->resolution)
+		_mm256_storeu_si256((__m256i*)(out->resolution + index), _mm256_add_epi8(res, _mm256_set1_epi8(9)));
+	if (out->userByte1)
+		_mm256_storeu_si256((__m256i*)(out->userByte1 + index), rows[2]);
+	if (out->userByte2)
+		_mm256_storeu_si256((__m256i*)(out->userByte2 + index), rows[3]);
+}
+#endif
+
+#ifdef DSB_NEON
+static inline uint8x16_t dsb_zipNEON(uint8x16_t a, uint8x16_t b, int high)
+{
+	uint8x16x2_t zip = vzipq_u8(a, b);
+	return high ? zip.val[1] : zip.val[0];
+}
+
+static inline void dsb_rowsNEON(const DS18B20_Byte *sp, size_t stride, uint8x16_t *rows)
+{
+	uint8x16_t a[8];
+	uint8x16_t b[8];
+
+	for (size_t k = 0; k < 8; ++k)
+		a[k] = vcombine_u8(vld1_u8(sp + k * stride), vld1_u8(sp + (k + 8) * stride));
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		b[2 * k] = dsb_zipNEON(a[k], a[k + 4], 0);
+		b[2 * k + 1] = dsb_zipNEON(a[k], a[k + 4], 1);
+	}
+
+	for (size_t k = 0; k < 4; ++k)
+	{
+		a[2 * k] = dsb_zipNEON(b[k], b[k + 4], 0);
+		a[2 * k + 1] = dsb_zipNEON(b[k], b[k + 4], 1);
+	}
+
+	b[0] = dsb_zipNEON(a[0], a[4], 0);
+	b[1] = dsb_zipNEON(a[0], a[4], 1);
+	b[2] = dsb_zipNEON(a[1], a[5], 0);
+	b[4] = dsb_zipNEON(a[2], a[6], 0);
+	b[5] = dsb_zipNEON(a[2], a[6], 1);
+	b[6] = dsb_zipNEON(a[3], a[7], 0);
+
+	rows[0] = vcombine_u8(vget_low_u8(b[0]), vget_low_u8(b[4]));
+	rows[1] = vcombine_u8(vget_high_u8(b[0]), vget_high_u8(b[4]));
+	rows[2] = vcombine_u8(vget_low_u8(b[1]), vget_low_u8(b[5]));
+	rows[3] = vcombine_u8(vget_high_u8(b[1]), vget_high_u8(b[5]));
+	rows[4] = vcombine_u8(vget_low_u8(b[2]), vget_low_u8(b[6]));
+}
+
+static inline void dsb_milliNEON(int16x8_t raw, int32_t *milli)
+{
+	int32x4_t p0 = vmull_n_s16(vget_low_s16(raw), 125);
+	int32x4_t p1 = vmull_n_s16(vget_high_s16(raw), 125);
+
+	p0 = vshrq_n_s32(vaddq_s32(p0, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(p0), 31))), 1);
+	p1 = vshrq_n_s32(vaddq_s32(p1, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(p1), 31))), 1);
+
+	vst1q_s32(milli, p0);
+	vst1q_s32(milli + 4, p1);
+}
+
+static void dsb_kernelNEON(const DS18B20_Byte *scratchpads, size_t stride, size_t index, const DS18B20_BatchOutput *out)
+{
+	uint8x16_t rows[5];
+
+	dsb_rowsNEON(scratchpads + index * stride, stride, rows);
+
+	uint8x16_t res = vandq_u8(vshrq_n_u8(rows[4], 5), vdupq_n_u8(0x03));
+	uint8x16_t mask = vdupq_n_u8(0xF8);
+	mask = vorrq_u8(mask, vandq_u8(vcgtq_u8(res, vdupq_n_u8(0)), vdupq_n_u8(0x04)));
+	mask = vorrq_u8(mask, vandq_u8(vcgtq_u8(res, vdupq_n_u8(1)), vdupq_n_u8(0x02)));
+	mask = vorrq_u8(mask, vandq_u8(vcgtq_u8(res, vdupq_n_u8(2)), vdupq_n_u8(0x01)));
+
+	uint8x16x2_t raw = vzipq_u8(vandq_u8(rows[0], mask), rows[1]);
+	dsb_milliNEON(vreinterpretq_s16_u8(raw.val[0]), out->milli + index);
+	dsb_milliNEON(vreinterpretq_s16_u8(raw.val[1]), out->milli + index + 8);
+
+	if (out->resolution)
+		vst1q_u8(out->resolution + index, vaddq_u8(res, vdupq_n_u8(9)));
+	if (out->userByte1)
+		vst1q_u8(out->userByte1 + index, rows[2]);
+	if (out->userByte2)
+		vst1q_u8(out->userByte2 + index, rows[3]);
+}
+#endif
+
+static const DSB_KernelEntry dsb_kernels[] = {
+	[DS18B20_Batch_Scalar] = { &dsb_kernelScalar, 1 },
+#ifdef DSB_SSE2
+	[DS18B20_Batch_SSE2] = { &dsb_kernelSSE2, 16 },
+#endif
+#ifdef DSB_AVX2
+	[DS18B20_Batch_AVX2] = { &dsb_kernelAVX2, 32 },
+#endif
+#ifdef DSB_NEON
+	[DS18B20_Batch_NEON] = { &dsb_kernelNEON, 16 },
+#endif
+};
+
+static DS18B20_Bool dsb_supported(DS18B20_BatchKernel kernel)
+{
+	if ((size_t)kernel >= sizeof(dsb_kernels) / sizeof(dsb_kernels[0]) || !dsb_kernels[kernel].decode)
+		return DS18B20_False;
+
+#ifdef DSB_AVX2
+	if (kernel == DS18B20_Batch_AVX2)
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+
+	return DS18B20_True;
+}
+
+static void dsb_crc(const DS18B20_Byte *scratchpads, size_t stride, size_t count, const DS18B20_BatchOutput *out)
+{
+	OneWire_Byte valid[DSB_CRC_BLOCK / 8];
+
+	// Checked in larger blocks than decoding, so that vector CRC kernels get whole blocks of their own
+	for (size_t index = 0; index < count; index += DSB_CRC_BLOCK)
+	{
+		size_t n = count - index < DSB_CRC_BLOCK ? count - index : DSB_CRC_BLOCK;
+
+		onewireBatchCrc(scratchpads + index * stride, stride, DS18B20_SCRATCHPAD_SIZE, n, valid);
+
+		for (size_t i = 0; i < n; ++i)
+			out->crcValid[index + i] = (valid[i >> 3] >> (i & 0x07)) & 0x01;
+	}
+}
+
+// Public functions
+
+DS18B20_Bool ds18b20BatchSelect(DS18B20_BatchKernel kernel)
+{
+	if (!dsb_supported(kernel))
+		return DS18B20_False;
+
+	dsb_kernel = kernel;
+	dsb_selected = DS18B20_True;
+	return DS18B20_True;
+}
+
+DS18B20_BatchKernel ds18b20BatchKernel(void)
+{
+	if (dsb_selected)
+		return dsb_kernel;
+
+	// Fastest available first, nothing is stored, so concurrent first calls do not race
+	if (dsb_supported(DS18B20_Batch_AVX2))
+		return DS18B20_Batch_AVX2;
+	if (dsb_supported(DS18B20_Batch_SSE2))
+		return DS18B20_Batch_SSE2;
+	if (dsb_supported(DS18B20_Batch_NEON))
+		return DS18B20_Batch_NEON;
+	return DS18B20_Batch_Scalar;
+}
+
+void ds18b20BatchDecode(const DS18B20_Byte *scratchpads, size_t stride, size_t count, const DS18B20_BatchOutput *out)
+{
+	const DSB_KernelEntry *kernel = &dsb_kernels[ds18b20BatchKernel()];
+	size_t i = 0;
+
+	for (; i + kernel->block <= count; i += kernel->block)
+		kernel->decode(scratchpads, stride, i, out);
+
+	// Partial block is decoded record by record
+	dsb_decodeScalar(scratchpads, stride, i, count - i, out);
+
+	if (out->crcValid)
+		dsb_crc(scratchpads, stride, count, out);
+}
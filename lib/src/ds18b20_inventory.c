@@ -0,0 +1,190 @@
+#include "ds18b20_inventory.h"
+
+// Private functions
+
+static uint16_t dsi_crc16(uint16_t crc, const DS18B20_Byte *data, DS18B20_Size length)
+{
+	// 1-Wire CRC16, polynomial x^16 + x^15 + x^2 + 1 processed LSB first
+	while (length--)
+	{
+		crc ^= *data++;
+		for (DS18B20_Byte i = 0; i < 8; ++i)
+			crc = (crc & 0x01) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void dsi_prepare(DS18B20_Inventory *inv)
+{
+	DS18B20_Byte *chunk = inv->chunk;
+
+	switch(inv->step)
+	{
+	case DS18B20_Inventory_Header:
+		inv->chunkLength = DS18B20_INVENTORY_HEADER_SIZE;
+		chunk[0] = DS18B20_INVENTORY_MAGIC & 0xFF;
+		chunk[1] = DS18B20_INVENTORY_MAGIC >> 8;
+		chunk[2] = DS18B20_INVENTORY_VERSION;
+		chunk[3] = 0;
+		chunk[4] = inv->count & 0xFF;
+		chunk[5] = inv->count >> 8;
+		break;
+
+	case DS18B20_Inventory_Records:
+	{
+		inv->chunkLength = DS18B20_INVENTORY_RECORD_SIZE;
+		if (inv->state != DS18B20_Inventory_Saving)
+			return;
+
+		OneWire_Address rom = inv->table->roms[inv->index];
+		const DS18B20_InventoryEntry *entry = &inv->entries[inv->index];
+
+		for (DS18B20_Size i = 0; i < 8; ++i)
+			chunk[i] = (rom >> (i * 8)) & 0xFF;
+		chunk[8] = entry->resolution;
+		chunk[9] = entry->userBytes[0];
+		chunk[10] = entry->userBytes[1];
+		break;
+	}
+
+	case DS18B20_Inventory_Crc:
+		inv->chunkLength = DS18B20_INVENTORY_CRC_SIZE;
+		chunk[0] = inv->crc & 0xFF;
+		chunk[1] = inv->crc >> 8;
+		return;
+	}
+
+	if (inv->state == DS18B20_Inventory_Saving)
+		inv->crc = dsi_crc16(inv->crc, chunk, inv->chunkLength);
+}
+
+static DS18B20_Bool dsi_parse(DS18B20_Inventory *inv)
+{
+	DS18B20_Byte *chunk = inv->chunk;
+
+	if (inv->step == DS18B20_Inventory_Crc)
+		return chunk[0] == (inv->crc & 0xFF) && chunk[1] == (inv->crc >> 8);
+
+	inv->crc = dsi_crc16(inv->crc, chunk, inv->chunkLength);
+
+	if (inv->step == DS18B20_Inventory_Header)
+	{
+		inv->count = chunk[4] | (chunk[5] << 8);
+		return chunk[0] == (DS18B20_INVENTORY_MAGIC & 0xFF) && chunk[1] == (DS18B20_INVENTORY_MAGIC >> 8)
+			&& chunk[2] == DS18B20_INVENTORY_VERSION && inv->count <= inv->table->capacity;
+	}
+
+	OneWire_Address rom = 0;
+	OneWire_RomTable *table = inv->table;
+	DS18B20_InventoryEntry *entry = &inv->entries[inv->index];
+
+	for (DS18B20_Size i = 0; i < 8; ++i)
+		rom |= (OneWire_Address)chunk[i] << (i * 8);
+
+	if (onewireCrc(chunk, 8) != chunk[7])
+		return DS18B20_False;
+
+	// Records must come in table order, so every one is appended
+	if (!onewireRomTableInsert(table, rom) || table->roms[table->count - 1] != rom)
+		return DS18B20_False;
+
+	entry->resolution = (DS18B20Resolution)chunk[8];
+	entry->userBytes[0] = chunk[9];
+	entry->userBytes[1] = chunk[10];
+	return DS18B20_True;
+}
+
+static void dsi_begin(DS18B20_Inventory *inv, DS18B20_InventoryState state)
+{
+	inv->state = state;
+	inv->step = DS18B20_Inventory_Header;
+	inv->index = 0;
+	inv->offset = 0;
+	inv->crc = 0;
+	dsi_prepare(inv);
+}
+
+// Public functions
+
+void ds18b20InventoryInit(DS18B20_Inventory *inv, OneWire_RomTable *table, DS18B20_InventoryEntry *entries, DS18B20_InventoryTransfer storageWrite, DS18B20_InventoryTransfer storageRead)
+{
+	inv->table = table;
+	inv->entries = entries;
+	inv->storageWrite = storageWrite;
+	inv->storageRead = storageRead;
+	inv->storageData = 0;
+	inv->state = DS18B20_Inventory_Idle;
+}
+
+OneWire_Result ds18b20InventoryProcess(DS18B20_Inventory *inv)
+{
+	OneWire_Result res;
+
+	switch(inv->state)
+	{
+	case DS18B20_Inventory_Idle: return OneWire_NothingToDo;
+	case DS18B20_Inventory_Saving: res = inv->storageWrite(inv, inv->offset, inv->chunk, inv->chunkLength); break;
+	case DS18B20_Inventory_Loading: res = inv->storageRead(inv, inv->offset, inv->chunk, inv->chunkLength); break;
+	default: return OneWire_Undefined;
+	}
+
+	if (res == OneWire_Working)
+		return OneWire_Working;
+
+	if (res != OneWire_Success || (inv->state == DS18B20_Inventory_Loading && !dsi_parse(inv)))
+	{
+		// Partially loaded table must not be used
+		if (inv->state == DS18B20_Inventory_Loading)
+			inv->table->count = 0;
+
+		inv->state = DS18B20_Inventory_Idle;
+		return OneWire_Failed;
+	}
+
+	inv->offset += inv->chunkLength;
+
+	switch(inv->step)
+	{
+	case DS18B20_Inventory_Header:
+		inv->step = inv->count ? DS18B20_Inventory_Records : DS18B20_Inventory_Crc;
+		break;
+
+	case DS18B20_Inventory_Records:
+		if (++inv->index >= inv->count)
+			inv->step = DS18B20_Inventory_Crc;
+		break;
+
+	case DS18B20_Inventory_Crc:
+		inv->state = DS18B20_Inventory_Idle;
+		return OneWire_Success;
+	}
+
+	dsi_prepare(inv);
+	return OneWire_Working;
+}
+
+void ds18b20InventorySave(DS18B20_Inventory *inv)
+{
+	inv->count = inv->table->count;
+	dsi_begin(inv, DS18B20_Inventory_Saving);
+}
+
+void ds18b20InventoryLoad(DS18B20_Inventory *inv)
+{
+	inv->table->count = 0;
+	inv->table->rejected = 0;
+	inv->table->overflow = OneWire_False;
+
+	inv->count = 0;
+	dsi_begin(inv, DS18B20_Inventory_Loading);
+}
+
+void ds18b20InventoryStore(DS18B20_Inventory *inv, OneWire_Count index, const DS18B20 *ds)
+{
+	DS18B20_InventoryEntry *entry = &inv->entries[index];
+
+	entry->userBytes[0] = ds->buffer[2];
+	entry->userBytes[1] = ds->buffer[3];
+	entry->resolution = (DS18B20Resolution)ds->buffer[4];
+}
@@ -0,0 +1,154 @@
+#include "ds18b20_scheduler.h"
+
+// Private functions
+
+static inline DS18B20_Time dss_conversionTime(const DS18B20_Sensor *sensor)
+{
+	return (ds18b20GetConversionTime(sensor->resolution) + 999) / 1000;
+}
+
+static inline DS18B20_Time dss_leadTime(const DS18B20_Sensor *sensor)
+{
+	return dss_conversionTime(sensor) + DS18B20_SCHEDULER_MARGIN;
+}
+
+static inline DS18B20_Bool dss_reached(DS18B20_Time now, DS18B20_Time time)
+{
+	// Wrap-safe comparison, valid as long as compared times are less than half of the counter range apart
+	return (int32_t)(now - time) >= 0;
+}
+
+static void dss_finish(DS18B20_Scheduler *sched, DS18B20_Time now)
+{
+	DS18B20_Sensor *sensor = &sched->sensors[sched->current];
+
+	if (sched->job == DS18B20_Job_Convert)
+	{
+		sensor->convertDone = now + dss_conversionTime(sensor);
+		sensor->converting = DS18B20_True;
+		return;
+	}
+
+	ds18b20GetReading(sched->ds, &sensor->reading);
+	sensor->converting = DS18B20_False;
+
+	if (!dss_reached(sensor->deadline, now))
+		++sensor->missed;
+
+	// Periods which are already over are skipped and counted as missed
+	sensor->deadline += sensor->period;
+	while (dss_reached(now, sensor->deadline))
+	{
+		sensor->deadline += sensor->period;
+		++sensor->missed;
+	}
+
+	if (sched->onReading)
+		sched->onReading(sched, sensor);
+}
+
+static DS18B20_SchedulerJob dss_pick(DS18B20_Scheduler *sched, DS18B20_Time now)
+{
+	DS18B20_SchedulerJob job = DS18B20_Job_None;
+
+	for (OneWire_Count i = 0; i < sched->count; ++i)
+	{
+		DS18B20_Sensor *sensor = &sched->sensors[i];
+		DS18B20_SchedulerJob candidate;
+
+		if (sensor->converting)
+			candidate = dss_reached(now, sensor->convertDone) ? DS18B20_Job_Read : DS18B20_Job_None;
+		else
+			candidate = dss_reached(now, sensor->deadline - dss_leadTime(sensor)) ? DS18B20_Job_Convert : DS18B20_Job_None;
+
+		if (candidate == DS18B20_Job_None)
+			continue;
+
+		// Earliest deadline first
+		if (job == DS18B20_Job_None || (int32_t)(sensor->deadline - sched->sensors[sched->current].deadline) < 0)
+		{
+			job = candidate;
+			sched->current = i;
+		}
+	}
+
+	return job;
+}
+
+// Public functions
+
+void ds18b20SchedulerInit(DS18B20_Scheduler *sched, DS18B20 *ds, DS18B20_Sensor *sensors, OneWire_Count count)
+{
+	sched->ds = ds;
+	sched->sensors = sensors;
+	sched->count = count;
+	sched->onReading = 0;
+	sched->job = DS18B20_Job_None;
+	sched->current = 0;
+	sched->started = DS18B20_False;
+	sched->busyTime = 0;
+	sched->totalTime = 0;
+
+	ds->convertMode = DS18b20_ConvertMode_NoWait;
+	if (ds->readMode < DS18b20_Read_Temperature)
+		ds->readMode = DS18b20_Read_CRC;
+}
+
+void ds18b20SchedulerProcess(DS18B20_Scheduler *sched, DS18B20_Time now)
+{
+	if (!sched->started)
+	{
+		for (OneWire_Count i = 0; i < sched->count; ++i)
+		{
+			DS18B20_Sensor *sensor = &sched->sensors[i];
+
+			// Staggered so that jobs of sensors sharing a period do not compete for the bus
+			sensor->deadline = now + dss_leadTime(sensor) + i * DS18B20_SCHEDULER_MARGIN;
+			sensor->converting = DS18B20_False;
+			sensor->missed = 0;
+		}
+
+		sched->lastTime = now;
+		sched->started = DS18B20_True;
+	}
+
+	// Both totals are halved before they overflow, which keeps their ratio after 49.7 days of uptime
+	if (sched->totalTime & 0x80000000)
+	{
+		sched->totalTime >>= 1;
+		sched->busyTime >>= 1;
+	}
+
+	sched->totalTime += now - sched->lastTime;
+	if (sched->job != DS18B20_Job_None)
+		sched->busyTime += now - sched->lastTime;
+	sched->lastTime = now;
+
+	if (sched->job != DS18B20_Job_None)
+	{
+		if (ds18b20Process(sched->ds) != DS18b20_State_Finished)
+			return;
+
+		dss_finish(sched, now);
+		sched->job = DS18B20_Job_None;
+	}
+
+	sched->job = dss_pick(sched, now);
+	if (sched->job == DS18B20_Job_None)
+		return;
+
+	if (sched->job == DS18B20_Job_Convert)
+		ds18b20BeginConversion(sched->ds, sched->sensors[sched->current].address);
+	else
+		ds18b20ReadScratchpad(sched->ds, sched->sensors[sched->current].address);
+
+	ds18b20Process(sched->ds);
+}
+
+DS18B20_Time ds18b20SchedulerUtilisation(const DS18B20_Scheduler *sched)
+{
+	if (!sched->totalTime)
+		return 0;
+
+	return (DS18B20_Time)((uint64_t)sched->busyTime * 1000 / sched->totalTime);
+}
@@ -0,0 +1,340 @@
+#include "ds2482.h"
+
+// Private data
+
+static const DS2482_Byte ds2482_channelCodes[DS2482_CHANNELS_800] = { 0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87 };
+static const DS2482_Byte ds2482_channelReadCodes[DS2482_CHANNELS_800] = { 0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87 };
+
+typedef enum DS2482CommandMode
+{
+	DS2482_Mode_Write,				/**< Only write the command */
+	DS2482_Mode_ReadBack,			/**< Write the command and read one byte back */
+	DS2482_Mode_Poll,				/**< Write the command and poll status until 1-Wire is no longer busy */
+	DS2482_Mode_PollData			/**< Poll status, then read data register */
+} DS2482CommandMode;
+
+// Private functions
+
+static inline DS2482 *ds_bridge(const OneWire *ow)
+{
+	return ((DS2482_Channel*)ow->transportData)->bridge;
+}
+
+static inline void ds_prepare(DS2482 *bridge, DS2482_Byte command, DS2482_Byte param, DS2482_Size length)
+{
+	// Command buffer must not change while previous command is being sent
+	if (bridge->commandState != DS2482_Command_Begin)
+		return;
+
+	bridge->command[0] = command;
+	bridge->command[1] = param;
+	bridge->commandLength = length;
+}
+
+static OneWire_Result ds_command(DS2482 *bridge, DS2482CommandMode mode)
+{
+	OneWire_Result res = OneWire_Working;
+
+	switch(bridge->commandState)
+	{
+	case DS2482_Command_Begin:
+		bridge->i2cWrite(bridge, bridge->command, bridge->commandLength);
+		bridge->commandState = DS2482_Command_Writing;
+		return OneWire_Working;
+
+	case DS2482_Command_Writing:
+		res = bridge->i2cDone(bridge);
+		if (res != OneWire_Success)
+			break;
+
+		if (mode == DS2482_Mode_Write)
+		{
+			bridge->commandState = DS2482_Command_Begin;
+			return OneWire_Success;
+		}
+
+		// After 1-Wire commands read pointer is already set to status register
+		bridge->i2cRead(bridge, mode == DS2482_Mode_ReadBack ? &bridge->data : &bridge->status, 1);
+		bridge->commandState = DS2482_Command_Status;
+		return OneWire_Working;
+
+	case DS2482_Command_Status:
+		res = bridge->i2cDone(bridge);
+		if (res != OneWire_Success)
+			break;
+
+		if (mode != DS2482_Mode_ReadBack && (bridge->status & DS2482_STATUS_1WB))
+		{
+			bridge->i2cRead(bridge, &bridge->status, 1);
+			return OneWire_Working;
+		}
+
+		if (mode == DS2482_Mode_PollData)
+		{
+			bridge->command[0] = DS2482_SET_READ_POINTER;
+			bridge->command[1] = DS2482_REGISTER_DATA;
+			bridge->i2cWrite(bridge, bridge->command, 2);
+			bridge->commandState = DS2482_Command_Pointer;
+			return OneWire_Working;
+		}
+
+		bridge->commandState = DS2482_Command_Begin;
+		return OneWire_Success;
+
+	case DS2482_Command_Pointer:
+		res = bridge->i2cDone(bridge);
+		if (res != OneWire_Success)
+			break;
+
+		bridge->i2cRead(bridge, &bridge->data, 1);
+		bridge->commandState = DS2482_Command_Data;
+		return OneWire_Working;
+
+	case DS2482_Command_Data:
+		res = bridge->i2cDone(bridge);
+		if (res != OneWire_Success)
+			break;
+
+		bridge->commandState = DS2482_Command_Begin;
+		return OneWire_Success;
+	}
+
+	if (res == OneWire_Failed)
+		bridge->commandState = DS2482_Command_Begin;
+
+	return res;
+}
+
+static inline DS2482_Byte ds_configParam(DS2482_Byte config)
+{
+	// Upper nibble of written configuration must be one's complement of the lower one
+	return (config & 0x0F) | ((~config & 0x0F) << 4);
+}
+
+static inline OneWire_Bool ds_nextBit(OneWire *ow)
+{
+	if (++ow->bitIndex >= ow->bitLength)
+	{
+		ow->bitIndex = 0;
+		if (++ow->byteIndex >= ow->bufferLength)
+		{
+			ow->byteIndex = 0;
+			return OneWire_True;
+		}
+	}
+
+	return OneWire_False;
+}
+
+// RESET
+
+static OneWire_Result processReset(OneWire *ow)
+{
+	DS2482_Channel *channel = (DS2482_Channel*)ow->transportData;
+	DS2482 *bridge = channel->bridge;
+	OneWire_Result res;
+
+	switch(bridge->resetState)
+	{
+	case DS2482_Reset_Device:
+		if (bridge->configured)
+		{
+			bridge->resetState = DS2482_Reset_Channel;
+			return OneWire_Working;
+		}
+
+		ds_prepare(bridge, DS2482_DEVICE_RESET, 0, 1);
+		res = ds_command(bridge, DS2482_Mode_Write);
+		if (res == OneWire_Success)
+		{
+			// Device reset selects the first channel
+			bridge->channel = 0;
+			bridge->resetState = DS2482_Reset_Config;
+			return OneWire_Working;
+		}
+		return res;
+
+	case DS2482_Reset_Config:
+		ds_prepare(bridge, DS2482_WRITE_CONFIG, ds_configParam(bridge->config), 2);
+		res = ds_command(bridge, DS2482_Mode_Write);
+		if (res == OneWire_Working)
+			return OneWire_Working;
+
+		if (res == OneWire_Success)
+		{
+			bridge->configured = DS2482_True;
+			bridge->resetState = DS2482_Reset_Channel;
+			return OneWire_Working;
+		}
+		break;
+
+	case DS2482_Reset_Channel:
+		if (bridge->channels <= 1 || bridge->channel == channel->channel)
+		{
+			bridge->resetState = DS2482_Reset_Bus;
+			return OneWire_Working;
+		}
+
+		ds_prepare(bridge, DS2482_CHANNEL_SELECT, ds2482_channelCodes[channel->channel], 2);
+		res = ds_command(bridge, DS2482_Mode_ReadBack);
+		if (res == OneWire_Working)
+			return OneWire_Working;
+
+		if (res == OneWire_Success && bridge->data == ds2482_channelReadCodes[channel->channel])
+		{
+			bridge->channel = channel->channel;
+			bridge->resetState = DS2482_Reset_Bus;
+			return OneWire_Working;
+		}
+		break;
+
+	case DS2482_Reset_Bus:
+		ds_prepare(bridge, DS2482_1WIRE_RESET, 0, 1);
+		res = ds_command(bridge, DS2482_Mode_Poll);
+		if (res == OneWire_Success)
+		{
+			bridge->resetState = DS2482_Reset_Device;
+			ow->presence = (bridge->status & DS2482_STATUS_PPD) != 0;
+
+			if (ow->detectedCallback && ow->presence)
+				ow->detectedCallback(ow);
+		}
+		else if (res == OneWire_Failed)
+			bridge->resetState = DS2482_Reset_Device;
+		return res;
+	}
+
+	// Restart whole sequence, including device configuration, on next attempt
+	bridge->configured = DS2482_False;
+	bridge->resetState = DS2482_Reset_Device;
+	return OneWire_Failed;
+}
+
+// WRITE
+
+static OneWire_Result processWrite(OneWire *ow)
+{
+	DS2482 *bridge = ds_bridge(ow);
+	OneWire_Byte data = ow->buffer[ow->byteIndex];
+	OneWire_Result res;
+
+	// Whole bytes use byte command, single bits (used by search) use single bit command
+	if (ow->bitLength == 8)
+		ds_prepare(bridge, DS2482_1WIRE_WRITE_BYTE, data, 2);
+	else
+		ds_prepare(bridge, DS2482_1WIRE_SINGLE_BIT, (data & (1 << ow->bitIndex)) ? 0x80 : 0x00, 2);
+
+	res = ds_command(bridge, DS2482_Mode_Poll);
+	if (res != OneWire_Success)
+		return res;
+
+	if (ow->bitLength == 8)
+		ow->bitIndex = ow->bitLength - 1;
+
+	return ds_nextBit(ow) ? OneWire_Success : OneWire_Working;
+}
+
+// READ
+
+static OneWire_Result processRead(OneWire *ow)
+{
+	DS2482 *bridge = ds_bridge(ow);
+	OneWire_Result res;
+
+	if (ow->bitLength == 8)
+	{
+		ds_prepare(bridge, DS2482_1WIRE_READ_BYTE, 0, 1);
+		res = ds_command(bridge, DS2482_Mode_PollData);
+		if (res != OneWire_Success)
+			return res;
+
+		ow->buffer[ow->byteIndex] |= bridge->data;
+
+		if (ow->state == OneWire_Reading || ow->state == OneWire_Transacting)
+		{
+			for (DS2482_Byte i = 0; i < 8; ++i)
+				ow->crc = onewireCrcBit(ow->crc, (bridge->data >> i) & 0x01);
+		}
+
+		ow->bitIndex = ow->bitLength - 1;
+		return ds_nextBit(ow) ? OneWire_Success : OneWire_Working;
+	}
+
+	// Single bit read is a write of 1 sampled by the bridge
+	ds_prepare(bridge, DS2482_1WIRE_SINGLE_BIT, 0x80, 2);
+	res = ds_command(bridge, DS2482_Mode_Poll);
+	if (res != OneWire_Success)
+		return res;
+
+	OneWire_Bool bit = (bridge->status & DS2482_STATUS_SBR) != 0;
+	ow->buffer[ow->byteIndex] |= bit << ow->bitIndex;
+
+	if (ow->state == OneWire_Reading || ow->state == OneWire_Transacting)
+		ow->crc = onewireCrcBit(ow->crc, bit);
+
+	return ds_nextBit(ow) ? OneWire_Success : OneWire_Working;
+}
+
+// TRIPLET
+
+static OneWire_Result processTriplet(OneWire *ow)
+{
+	DS2482 *bridge = ds_bridge(ow);
+	OneWire_Result res;
+
+	ds_prepare(bridge, DS2482_1WIRE_TRIPLET, (ow->searchHelper & 0x01) ? 0x80 : 0x00, 2);
+	res = ds_command(bridge, DS2482_Mode_Poll);
+	if (res != OneWire_Success)
+		return res;
+
+	ow->searchHelper =
+			((bridge->status & DS2482_STATUS_SBR) ? 0x01 : 0x00) |
+			((bridge->status & DS2482_STATUS_TSB) ? 0x02 : 0x00) |
+			((bridge->status & DS2482_STATUS_DIR) ? 0x04 : 0x00);
+
+	return OneWire_Success;
+}
+
+// PULLUP
+
+static OneWire_Result processPullup(OneWire *ow, OneWire_Bool enable)
+{
+	DS2482 *bridge = ds_bridge(ow);
+
+	// Bridge drives strong pullup once the next 1-Wire write completes, until configuration without SPU is written.
+	// Any other 1-Wire command ends it as well, so a transaction failed in between leaves no pullup behind.
+	ds_prepare(bridge, DS2482_WRITE_CONFIG, ds_configParam(enable ? (bridge->config | DS2482_CONFIG_SPU) : bridge->config), 2);
+	return ds_command(bridge, DS2482_Mode_Write);
+}
+
+// Transport
+
+const OneWire_Transport ds2482Transport = {
+	.reset = &processReset,
+	.write = &processWrite,
+	.read = &processRead,
+	.triplet = &processTriplet,
+	.pullup = &processPullup
+};
+
+// Public functions
+
+void ds2482Init(DS2482 *bridge, DS2482_Byte address, DS2482_Byte channels, DS2482_I2cWrite i2cWrite, DS2482_I2cRead i2cRead, DS2482_I2cDone i2cDone)
+{
+	bridge->address = address;
+	bridge->channels = channels;
+	bridge->config = DS2482_CONFIG_APU;
+	bridge->i2cWrite = i2cWrite;
+	bridge->i2cRead = i2cRead;
+	bridge->i2cDone = i2cDone;
+	bridge->configured = DS2482_False;
+	bridge->commandState = DS2482_Command_Begin;
+	bridge->resetState = DS2482_Reset_Device;
+}
+
+void ds2482InitChannel(DS2482_Channel *channel, DS2482 *bridge, DS2482_Byte number, OneWire *ow, OneWire_Id id, OneWire_StartTimer startTimer, OneWire_ReadTimer readTimer)
+{
+	channel->bridge = bridge;
+	channel->channel = number < bridge->channels ? number : 0;
+	onewireInitTransport(ow, id, &ds2482Transport, channel, startTimer, readTimer);
+}
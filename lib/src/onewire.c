@@ -1,10 +1,73 @@
 #include "onewire.h"
 
+// Private data
+
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+
+const OneWire_Byte onewireCrcTable[256] = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41,
+	0x9D, 0xC3, 0x21, 0x7F, 0xFC, 0xA2, 0x40, 0x1E, 0x5F, 0x01, 0xE3, 0xBD, 0x3E, 0x60, 0x82, 0xDC,
+	0x23, 0x7D, 0x9F, 0xC1, 0x42, 0x1C, 0xFE, 0xA0, 0xE1, 0xBF, 0x5D, 0x03, 0x80, 0xDE, 0x3C, 0x62,
+	0xBE, 0xE0, 0x02, 0x5C, 0xDF, 0x81, 0x63, 0x3D, 0x7C, 0x22, 0xC0, 0x9E, 0x1D, 0x43, 0xA1, 0xFF,
+	0x46, 0x18, 0xFA, 0xA4, 0x27, 0x79, 0x9B, 0xC5, 0x84, 0xDA, 0x38, 0x66, 0xE5, 0xBB, 0x59, 0x07,
+	0xDB, 0x85, 0x67, 0x39, 0xBA, 0xE4, 0x06, 0x58, 0x19, 0x47, 0xA5, 0xFB, 0x78, 0x26, 0xC4, 0x9A,
+	0x65, 0x3B, 0xD9, 0x87, 0x04, 0x5A, 0xB8, 0xE6, 0xA7, 0xF9, 0x1B, 0x45, 0xC6, 0x98, 0x7A, 0x24,
+	0xF8, 0xA6, 0x44, 0x1A, 0x99, 0xC7, 0x25, 0x7B, 0x3A, 0x64, 0x86, 0xD8, 0x5B, 0x05, 0xE7, 0xB9,
+	0x8C, 0xD2, 0x30, 0x6E, 0xED, 0xB3, 0x51, 0x0F, 0x4E, 0x10, 0xF2, 0xAC, 0x2F, 0x71, 0x93, 0xCD,
+	0x11, 0x4F, 0xAD, 0xF3, 0x70, 0x2E, 0xCC, 0x92, 0xD3, 0x8D, 0x6F, 0x31, 0xB2, 0xEC, 0x0E, 0x50,
+	0xAF, 0xF1, 0x13, 0x4D, 0xCE, 0x90, 0x72, 0x2C, 0x6D, 0x33, 0xD1, 0x8F, 0x0C, 0x52, 0xB0, 0xEE,
+	0x32, 0x6C, 0x8E, 0xD0, 0x53, 0x0D, 0xEF, 0xB1, 0xF0, 0xAE, 0x4C, 0x12, 0x91, 0xCF, 0x2D, 0x73,
+	0xCA, 0x94, 0x76, 0x28, 0xAB, 0xF5, 0x17, 0x49, 0x08, 0x56, 0xB4, 0xEA, 0x69, 0x37, 0xD5, 0x8B,
+	0x57, 0x09, 0xEB, 0xB5, 0x36, 0x68, 0x8A, 0xD4, 0x95, 0xCB, 0x29, 0x77, 0xF4, 0xAA, 0x48, 0x16,
+	0xE9, 0xB7, 0x55, 0x0B, 0x88, 0xD6, 0x34, 0x6A, 0x2B, 0x75, 0x97, 0xC9, 0x4A, 0x14, 0xF6, 0xA8,
+	0x74, 0x2A, 0xC8, 0x96, 0x15, 0x4B, 0xA9, 0xF7, 0xB6, 0xE8, 0x0A, 0x54, 0xD7, 0x89, 0x6B, 0x35
+};
+
+#elif ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_NIBBLE
+
+static const OneWire_Byte ow_crcTableLow[16] = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41
+};
+
+static const OneWire_Byte ow_crcTableHigh[16] = {
+	0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+
+#endif
+
 // Private functions
 
-static inline OneWire_Bool ow_timerPassed(const OneWire *ow, OneWire_Counter threshold)
+static inline void ow_delay(OneWire *ow, OneWire_Counter time)
+{
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	// Next edge is scheduled relative to the previous one, so interrupt latency does not accumulate
+	ow->timerStart += ow->timerDelay;
+	ow->timerDelay = time;
+	ow->scheduleTimer(ow, ow->timerStart + time);
+
+	// Interrupt latency may exceed short delays, compare value behind the counter would only match after the counter wraps.
+	// The edge is then processed right away and following delays are measured from now.
+	ow->timerScheduled = onewireTimerElapsed(ow) < time;
+	if (!ow->timerScheduled)
+	{
+		ow->timerStart = onewireReadTimer(ow);
+		ow->timerDelay = 0;
+	}
+#else
+	onewireTimerRestart(ow);
+	ow->timerDelay = time;
+#endif
+}
+
+static inline OneWire_Bool ow_delayPassed(const OneWire *ow)
 {
-	return ow->readTimer(ow) >= threshold;
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	// States are only processed from timer interrupt, once scheduled delay has elapsed
+	(void)ow;
+	return OneWire_True;
+#else
+	return onewireTimerElapsed(ow) >= ow->timerDelay;
+#endif
 }
 
 // START
@@ -14,34 +77,36 @@ static OneWire_Result processStart(OneWire *ow)
 	switch(ow->substate.startState)
 	{
 	case OneWire_Start_Begin:
-		ow->setPinDir(ow, OneWire_PinDir_Output);
-		ow->setPinState(ow, OneWire_PinState_Low);
-		ow->startTimer(ow);
+		onewireSetPinDir(ow, OneWire_PinDir_Output);
+		onewireSetPinState(ow, OneWire_PinState_Low);
+		ow_delay(ow, ONEWIRE_START_RESET_TIME);
 		ow->substate.startState = OneWire_Start_Delay1;
 		return OneWire_Working;
 
 	case OneWire_Start_Delay1:
-		if (ow_timerPassed(ow, ONEWIRE_START_RESET_TIME))
+		if (ow_delayPassed(ow))
 		{
-			ow->setPinDir(ow, OneWire_PinDir_Input);
-			ow->startTimer(ow);
+			onewireSetPinDir(ow, OneWire_PinDir_Input);
+			ow_delay(ow, ONEWIRE_START_RELEASE_TIME);
 			ow->substate.startState = OneWire_Start_Delay2;
 		}
 		return OneWire_Working;
 
 	case OneWire_Start_Delay2:
-		if (ow_timerPassed(ow, ONEWIRE_START_RELEASE_TIME))
+		if (ow_delayPassed(ow))
 		{
-			if (ow->detectedCallback && ow->readPin(ow) == OneWire_PinState_Low)
+			ow->presence = onewireReadPin(ow) == OneWire_PinState_Low;
+			if (ow->detectedCallback && ow->presence)
 				ow->detectedCallback(ow);
 
-			ow->startTimer(ow);
+			// Recovery before the first time slot is folded into the presence window
+			ow_delay(ow, ONEWIRE_START_WAIT_TIME + ow->resetRecovery);
 			ow->substate.startState = OneWire_Start_Delay3;
 		}
 		return OneWire_Working;
 
 	case OneWire_Start_Delay3:
-		if (ow_timerPassed(ow, ONEWIRE_START_WAIT_TIME))
+		if (ow_delayPassed(ow))
 		{
 			ow->substate.startState = OneWire_Start_Begin;
 			return OneWire_Success;
@@ -63,24 +128,24 @@ static OneWire_Result processWrite(OneWire *ow)
 	{
 	// Begin
 	case OneWire_Write_Begin:
-		ow->setPinState(ow, OneWire_PinState_Low);
-		ow->setPinDir(ow, OneWire_PinDir_Output);
+		onewireSetPinState(ow, OneWire_PinState_Low);
+		onewireSetPinDir(ow, OneWire_PinDir_Output);
 		ow->substate.writeState = bitState == 0 ? OneWire_Write_Low_1 : OneWire_Write_High_1;
-		ow->startTimer(ow);
+		ow_delay(ow, bitState == 0 ? ONEWIRE_WRITE_LOW_LOW_TIME : ONEWIRE_WRITE_HIGH_LOW_TIME);
 		return OneWire_Working;
 
 	// High bit
 	case OneWire_Write_High_1:
-		if (ow_timerPassed(ow, ONEWIRE_WRITE_HIGH_LOW_TIME))
+		if (ow_delayPassed(ow))
 		{
-			ow->setPinDir(ow, OneWire_PinDir_Input);
-			ow->startTimer(ow);
+			onewireSetPinDir(ow, OneWire_PinDir_Input);
+			ow_delay(ow, ONEWIRE_WRITE_HIGH_RELEASE_TIME);
 			ow->substate.writeState = OneWire_Write_High_2;
 		}
 		return OneWire_Working;
 
 	case OneWire_Write_High_2:
-		if (ow_timerPassed(ow, ONEWIRE_WRITE_HIGH_RELEASE_TIME))
+		if (ow_delayPassed(ow))
 		{
 			if (++ow->bitIndex >= ow->bitLength)
 			{
@@ -99,22 +164,12 @@ static OneWire_Result processWrite(OneWire *ow)
 
 	// Low bit
 	case OneWire_Write_Low_1:
-		if (ow_timerPassed(ow, ONEWIRE_WRITE_LOW_LOW_TIME))
+		if (ow_delayPassed(ow))
 		{
-			ow->setPinDir(ow, OneWire_PinDir_Input);
-
-			if (++ow->bitIndex >= ow->bitLength)
-			{
-				ow->bitIndex = 0;
-				if (++ow->byteIndex >= ow->bufferLength)
-				{
-					ow->substate.writeState = OneWire_Write_Begin;
-					ow->byteIndex = 0;
-					return OneWire_Success;
-				}
-			}
-
-			ow->substate.writeState = OneWire_Write_Begin;
+			// Let the line recover before next slot, shared with high bit ending
+			onewireSetPinDir(ow, OneWire_PinDir_Input);
+			ow_delay(ow, ONEWIRE_WRITE_LOW_RELEASE_TIME);
+			ow->substate.writeState = OneWire_Write_High_2;
 		}
 
 		return OneWire_Working;
@@ -130,30 +185,33 @@ static OneWire_Result processRead(OneWire *ow)
 	switch(ow->substate.readState)
 	{
 	case OneWire_Read_Begin:
-		ow->setPinDir(ow, OneWire_PinDir_Input);
-		ow->startTimer(ow);
+		onewireSetPinDir(ow, OneWire_PinDir_Input);
+		ow_delay(ow, ONEWIRE_READ_BEGIN_TIME);
 		ow->substate.readState = OneWire_Read_1;
 		return OneWire_Working;
 
 	case OneWire_Read_1:
-		if (ow_timerPassed(ow, ONEWIRE_READ_BEGIN_TIME))
+		if (ow_delayPassed(ow))
 		{
-			ow->setPinState(ow, OneWire_PinState_Low);
-			ow->setPinDir(ow, OneWire_PinDir_Output);
-			ow->startTimer(ow);
+			onewireSetPinState(ow, OneWire_PinState_Low);
+			onewireSetPinDir(ow, OneWire_PinDir_Output);
+			ow_delay(ow, ONEWIRE_READ_LOW_TIME);
 			ow->substate.readState = OneWire_Read_2;
 		}
 		return OneWire_Working;
 
 	case OneWire_Read_2:
-		if (ow_timerPassed(ow, ONEWIRE_READ_LOW_TIME))
+		if (ow_delayPassed(ow))
 		{
-			ow->setPinDir(ow, OneWire_PinDir_Input);
+			onewireSetPinDir(ow, OneWire_PinDir_Input);
 
-			OneWire_Bool bit = ow->readPin(ow) == OneWire_PinState_High;
+			OneWire_Bool bit = onewireReadPin(ow) == OneWire_PinState_High;
 
 			ow->buffer[ow->byteIndex] |= bit << ow->bitIndex;
 
+			if (ow->state == OneWire_Reading || ow->state == OneWire_Transacting)
+				ow->crc = onewireCrcBit(ow->crc, bit);
+
 			if (++ow->bitIndex >= ow->bitLength)
 			{
 				ow->bitIndex = 0;
@@ -166,14 +224,14 @@ static OneWire_Result processRead(OneWire *ow)
 				}
 			}
 
-			ow->startTimer(ow);
+			ow_delay(ow, ONEWIRE_READ_WAIT_TIME);
 			ow->substate.readState = OneWire_Read_3;
 			return OneWire_Working;
 		}
 		return OneWire_Working;
 
 	case OneWire_Read_3:
-		if (ow_timerPassed(ow, ONEWIRE_READ_WAIT_TIME))
+		if (ow_delayPassed(ow))
 			ow->substate.readState = OneWire_Read_1;
 		return OneWire_Working;
 	}
@@ -181,41 +239,412 @@ static OneWire_Result processRead(OneWire *ow)
 	return OneWire_Working;
 }
 
+#ifdef ONEWIRE_UART
+
+// UART
+
+static OneWire_Result processUartStart(OneWire *ow)
+{
+	switch(ow->substate.uartState)
+	{
+	case OneWire_Uart_Begin:
+		// Reset pulse is a single 0xF0 character at 9600 baud, present devices pull part of it low
+		ow->uartSetBaud(ow, OneWire_Baud_9600);
+		ow->uartFrame[0] = ONEWIRE_UART_RESET;
+		ow->uartLength = 1;
+		ow->uartTransfer(ow, ow->uartFrame, ow->uartLength);
+		ow->substate.uartState = OneWire_Uart_Transfer;
+		return OneWire_Working;
+
+	case OneWire_Uart_Transfer:
+		if (ow->uartTransferDone(ow))
+		{
+			ow->presence = ow->uartFrame[0] != ONEWIRE_UART_RESET;
+			if (ow->detectedCallback && ow->presence)
+				ow->detectedCallback(ow);
+
+			ow->uartSetBaud(ow, OneWire_Baud_115200);
+			ow->substate.uartState = OneWire_Uart_Begin;
+			return OneWire_Success;
+		}
+		return OneWire_Working;
+	}
+
+	return OneWire_Working;
+}
+
+static OneWire_Result processUartBits(OneWire *ow, OneWire_Bool reading)
+{
+	switch(ow->substate.uartState)
+	{
+	case OneWire_Uart_Begin:
+	{
+		// Every time slot is a single character at 115200 baud, send as many slots at once as the frame can hold
+		OneWire_Size byteIndex = ow->byteIndex;
+		OneWire_Size bitIndex = ow->bitIndex;
+
+		ow->uartLength = 0;
+		while (ow->uartLength < ONEWIRE_UART_FRAME_SIZE && byteIndex < ow->bufferLength)
+		{
+			OneWire_Bool bit = reading || (ow->buffer[byteIndex] & (1 << bitIndex));
+			ow->uartFrame[ow->uartLength++] = bit ? ONEWIRE_UART_BIT_HIGH : ONEWIRE_UART_BIT_LOW;
+
+			if (++bitIndex >= ow->bitLength)
+			{
+				bitIndex = 0;
+				++byteIndex;
+			}
+		}
+
+		ow->uartTransfer(ow, ow->uartFrame, ow->uartLength);
+		ow->substate.uartState = OneWire_Uart_Transfer;
+		return OneWire_Working;
+	}
+
+	case OneWire_Uart_Transfer:
+		if (ow->uartTransferDone(ow))
+		{
+			for (OneWire_Size i = 0; i < ow->uartLength; ++i)
+			{
+				if (reading)
+				{
+					// Any device pulling the line low during the slot corrupts echoed character
+					OneWire_Bool bit = ow->uartFrame[i] == ONEWIRE_UART_BIT_HIGH;
+
+					ow->buffer[ow->byteIndex] |= bit << ow->bitIndex;
+
+					if (ow->state == OneWire_Reading || ow->state == OneWire_Transacting)
+						ow->crc = onewireCrcBit(ow->crc, bit);
+				}
+
+				if (++ow->bitIndex >= ow->bitLength)
+				{
+					ow->bitIndex = 0;
+					++ow->byteIndex;
+				}
+			}
+
+			ow->substate.uartState = OneWire_Uart_Begin;
+
+			if (ow->byteIndex >= ow->bufferLength)
+			{
+				ow->byteIndex = 0;
+				return OneWire_Success;
+			}
+		}
+		return OneWire_Working;
+	}
+
+	return OneWire_Working;
+}
+
+static OneWire_Result processUartWrite(OneWire *ow)
+{
+	return processUartBits(ow, OneWire_False);
+}
+
+static OneWire_Result processUartRead(OneWire *ow)
+{
+	return processUartBits(ow, OneWire_True);
+}
+
+#endif
+
+// Transports
+
+const OneWire_Transport onewireBitBangTransport = {
+	.reset = &processStart,
+	.write = &processWrite,
+	.read = &processRead
+};
+
+#ifdef ONEWIRE_UART
+const OneWire_Transport onewireUartTransport = {
+	.reset = &processUartStart,
+	.write = &processUartWrite,
+	.read = &processUartRead
+};
+#endif
+
+// TRANSACTION
+
+static inline void ow_hold(OneWire *ow, OneWire_Counter time)
+{
+	// Bit-bang transport drives strong pullup itself, other transports only time the hold - either their armed
+	// pullup is applied by then, or the bus stays released
+	if (ow->transport == &onewireBitBangTransport)
+	{
+		onewireSetPinState(ow, OneWire_PinState_High);
+		onewireSetPinDir(ow, OneWire_PinDir_Output);
+		ow_delay(ow, time);
+		return;
+	}
+
+	onewireTimerRestart(ow);
+	ow->timerDelay = time;
+}
+
+static inline OneWire_Bool ow_holdPassed(OneWire *ow)
+{
+	if (ow->transport != &onewireBitBangTransport)
+		return onewireTimerElapsed(ow) >= ow->timerDelay;
+
+	if (!ow_delayPassed(ow))
+		return OneWire_False;
+
+	onewireSetPinDir(ow, OneWire_PinDir_Input);
+	return OneWire_True;
+}
+
+static inline void ow_transactionWrite(OneWire *ow, const OneWire_Byte *data, OneWire_Size length)
+{
+	ow->substate.writeState = OneWire_Write_Begin;
+	ow->buffer = (OneWire_Byte*)data;
+	ow->bufferLength = length;
+	ow->bitLength = 8;
+}
+
+static OneWire_Result ow_transactionNext(OneWire *ow)
+{
+	// Enter the first following phase which has something to do
+	const OneWire_Transaction *t = ow->transaction;
+	// Transport strong pullup has to be armed before the byte it follows, so the last byte is written on its own
+	OneWire_Size armed = t->pullup && t->txLength && ow->transport->pullup ? 1 : 0;
+
+	if (ow->transactionState < OneWire_Transaction_Reset && t->reset)
+	{
+		// Transports which do not detect presence pulse never fail ONEWIRE_STOP_NO_PRESENCE
+		ow->presence = OneWire_True;
+		ow->substate.startState = OneWire_Start_Begin;
+		ow->transactionState = OneWire_Transaction_Reset;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Write && t->txLength > armed)
+	{
+		ow_transactionWrite(ow, t->tx, t->txLength - armed);
+		ow->transactionState = OneWire_Transaction_Write;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Arm && armed)
+	{
+		ow->transactionState = OneWire_Transaction_Arm;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Last && armed)
+	{
+		ow_transactionWrite(ow, t->tx + t->txLength - 1, 1);
+		ow->transactionState = OneWire_Transaction_Last;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Pullup && t->pullup)
+	{
+		ow_hold(ow, t->pullup);
+		ow->transactionState = OneWire_Transaction_Pullup;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Release && armed)
+	{
+		ow->transactionState = OneWire_Transaction_Release;
+		return OneWire_Working;
+	}
+
+	if (ow->transactionState < OneWire_Transaction_Read && t->rxLength)
+	{
+		for (OneWire_Size i = 0; i < t->rxLength; ++i)
+			t->rx[i] = 0;
+
+		ow->substate.readState = OneWire_Read_Begin;
+		ow->buffer = t->rx;
+		ow->bufferLength = (t->stop & ONEWIRE_STOP_NONZERO) ? 1 : t->rxLength;
+		ow->bitLength = 8;
+		ow->crc = 0;
+		ow->transactionState = OneWire_Transaction_Read;
+		return OneWire_Working;
+	}
+
+	return OneWire_Success;
+}
+
+static OneWire_Result processTransaction(OneWire *ow)
+{
+	const OneWire_Transaction *t = ow->transaction;
+	OneWire_Result res;
+
+	switch(ow->transactionState)
+	{
+	case OneWire_Transaction_Begin:
+		break;
+
+	case OneWire_Transaction_Reset:
+		res = ow->transport->reset(ow);
+		if (res != OneWire_Success)
+			return res;
+
+		if ((t->stop & ONEWIRE_STOP_NO_PRESENCE) && !ow->presence)
+			return OneWire_Failed;
+		break;
+
+	case OneWire_Transaction_Write:
+	case OneWire_Transaction_Last:
+		res = ow->transport->write(ow);
+		if (res != OneWire_Success)
+			return res;
+		break;
+
+	case OneWire_Transaction_Arm:
+	case OneWire_Transaction_Release:
+		res = ow->transport->pullup(ow, ow->transactionState == OneWire_Transaction_Arm);
+		if (res != OneWire_Success)
+			return res;
+		break;
+
+	case OneWire_Transaction_Pullup:
+		if (!ow_holdPassed(ow))
+			return OneWire_Working;
+		break;
+
+	case OneWire_Transaction_Read:
+		res = ow->transport->read(ow);
+		if (res != OneWire_Success)
+			return res;
+
+		// Byte by byte reading goes on while zeros are read, device which never answers fails the transaction
+		if ((t->stop & ONEWIRE_STOP_NONZERO) && !ow->buffer[0])
+			return ++ow->buffer < t->rx + t->rxLength ? OneWire_Working : OneWire_Failed;
+		break;
+	}
+
+	return ow_transactionNext(ow);
+}
+
 // SEARCH
 
+static inline OneWire_Bool ow_searchTargeted(const OneWire *ow)
+{
+	return (ow->searchTargetMask & ow->searchBitIdx) != 0;
+}
+
+static inline OneWire_Bool ow_searchDirection(const OneWire *ow)
+{
+	if (ow_searchTargeted(ow))
+		return (ow->searchTarget & ow->searchBitIdx) != 0;
+
+	// Follow previous path when there is a pending discrepancy further on, otherwise take the pending branch
+	if (ow->searchLastDiscrepancy & ~(ow->searchBitIdx | (ow->searchBitIdx - 1)))
+		return !(ow->searchLastDiscrepancy & ow->searchBitIdx);
+	return (ow->searchLastDiscrepancy & ow->searchBitIdx) != 0;
+}
+
+static inline void ow_searchCommit(OneWire *ow, OneWire_Bool conflict, OneWire_Bool bit)
+{
+	// Branches leaving the targeted path are never revisited
+	if (conflict && !ow_searchTargeted(ow) && !(ow->searchLastDiscrepancy & ~(ow->searchBitIdx | (ow->searchBitIdx - 1))))
+		ow->searchLastDiscrepancy ^= ow->searchBitIdx;
+
+	ow->searchedAddress |= bit ? ow->searchBitIdx : 0;
+	ow->crc = onewireCrcBit(ow->crc, bit);
+}
+
+static inline void ow_searchBeginBit(OneWire *ow)
+{
+	ow->buffer = &ow->searchHelper;
+	ow->bufferLength = 1;
+
+	if (ow->transport->triplet)
+	{
+		ow->searchHelper = ow_searchDirection(ow);
+		ow->searchState = OneWire_Search_Triplet;
+	}
+	else
+	{
+		ow->searchHelper = 0;
+		ow->bitLength = 2;
+		ow->searchState = OneWire_Search_Read;
+	}
+}
+
+static inline OneWire_Result ow_searchEndBit(OneWire *ow)
+{
+	ow->searchBitIdx <<= 1;
+
+	if (ow->searchBitIdx)
+	{
+		ow_searchBeginBit(ow);
+		return OneWire_Working;
+	}
+
+	++ow->searchCount;
+
+	if (ow->searchTable)
+	{
+		if (ow->crc == 0)
+			onewireRomTableInsert(ow->searchTable, ow->searchedAddress);
+		else
+			++ow->searchTable->rejected;
+	}
+
+	if (ow->onSearchDone)
+		ow->onSearchDone(ow);
+
+	ow->searchBitIdx = 1;
+
+	ow->searchState = OneWire_Search_Begin;
+	if (!ow->searchLastDiscrepancy)
+		return OneWire_Success;
+
+	return OneWire_Working;
+}
+
+static inline OneWire_Result ow_searchPending(OneWire *ow, OneWire_Result res)
+{
+	// Transport errors (e.g. bridge not acknowledging) end the search, next one starts from reset
+	if (res != OneWire_Failed)
+		return OneWire_Working;
+
+	ow->searchState = OneWire_Search_Begin;
+	return OneWire_Failed;
+}
+
 static OneWire_Result processSearch(OneWire *ow)
 {
+	OneWire_Result res;
+
 	switch(ow->searchState)
 	{
 	case OneWire_Search_Begin:
-		if (processStart(ow) == OneWire_Success)
+		res = ow->transport->reset(ow);
+		if (res == OneWire_Success)
 		{
 			ow->searchedAddress = 0;
 			ow->searchBitIdx = 1;
+			ow->crc = 0;
+			ow->searchSlots += 8;
 
 			ow->searchState = OneWire_Search_Write_Command;
-			ow->searchHelper = ow->state == OneWire_Searching ? OneWire_Cmd_Search : OneWire_Cmd_Search_Alarm;
+			ow->searchHelper = ow->state == OneWire_SearchingAlarm ? OneWire_Cmd_Search_Alarm : OneWire_Cmd_Search;
 			ow->buffer = &ow->searchHelper;
 			ow->bufferLength = 1;
 			ow->bitLength = 8;
 		}
-		return OneWire_Working;
+		return ow_searchPending(ow, res);
 
 	case OneWire_Search_Write_Command:
-		if (processWrite(ow) == OneWire_Success)
-		{
-			ow->searchHelper = 0;
-			ow->buffer = &ow->searchHelper;
-			ow->bitLength = 2;
-			ow->bufferLength = 1;
-			ow->searchState = OneWire_Search_Read;
-		}
-		return OneWire_Working;
+		res = ow->transport->write(ow);
+		if (res == OneWire_Success)
+			ow_searchBeginBit(ow);
+		return ow_searchPending(ow, res);
 
 	case OneWire_Search_Read:
-		if (processRead(ow) == OneWire_Success)
+		res = ow->transport->read(ow);
+		if (res == OneWire_Success)
 		{
 			OneWire_Byte bit = ow->buffer[0];
+			ow->searchSlots += 2;
 
 			if (bit == 0x03)
 			{
@@ -226,17 +655,16 @@ static OneWire_Result processSearch(OneWire *ow)
 			if (bit == 0x01 || bit == 0x02)
 				bit &= 0x01;
 			else
+				bit = ow_searchDirection(ow);
+
+			// No device left on targeted path - the search is over
+			if (ow_searchTargeted(ow) && bit != ow_searchDirection(ow))
 			{
-				if (ow->searchLastDiscrepancy >= (ow->searchBitIdx << 1))
-					bit = !(ow->searchLastDiscrepancy & ow->searchBitIdx);
-				else
-				{
-					bit = (ow->searchLastDiscrepancy & ow->searchBitIdx) != 0;
-					ow->searchLastDiscrepancy ^= ow->searchBitIdx;
-				}
+				ow->searchState = OneWire_Search_Begin;
+				return OneWire_Success;
 			}
 
-			ow->searchedAddress |= bit ? ow->searchBitIdx : 0;
+			ow_searchCommit(ow, ow->buffer[0] == 0x00, bit);
 
 			ow->searchHelper = bit;
 			ow->buffer = &ow->searchHelper;
@@ -245,39 +673,105 @@ static OneWire_Result processSearch(OneWire *ow)
 
 			ow->searchState = OneWire_Search_Write_Direction;
 		}
-		return OneWire_Working;
+		return ow_searchPending(ow, res);
 
 	case OneWire_Search_Write_Direction:
-		if (processWrite(ow) == OneWire_Success)
+		res = ow->transport->write(ow);
+		if (res == OneWire_Success)
+		{
+			++ow->searchSlots;
+			return ow_searchEndBit(ow);
+		}
+		return ow_searchPending(ow, res);
+
+	case OneWire_Search_Triplet:
+		res = ow->transport->triplet(ow);
+		if (res == OneWire_Success)
 		{
-			ow->searchBitIdx <<= 1;
+			OneWire_Byte bits = ow->searchHelper & 0x03;
+			ow->searchSlots += 3;
 
-			if (ow->searchBitIdx)
+			if (bits == 0x03)
 			{
-				ow->searchHelper = 0;
-				ow->buffer = &ow->searchHelper;
-				ow->bitLength = 2;
-				ow->bufferLength = 1;
-				ow->searchState = OneWire_Search_Read;
+				ow->searchState = OneWire_Search_Begin;
+				return OneWire_Success;
 			}
-			else
-			{
-				ow->onSearchDone(ow);
 
-				ow->searchBitIdx = 1;
+			OneWire_Bool bit = (ow->searchHelper & 0x04) != 0;
 
+			if (ow_searchTargeted(ow) && bit != ow_searchDirection(ow))
+			{
 				ow->searchState = OneWire_Search_Begin;
-				if (!ow->searchLastDiscrepancy)
-					return OneWire_Success;
+				return OneWire_Success;
 			}
 
+			ow_searchCommit(ow, bits == 0x00, bit);
+			return ow_searchEndBit(ow);
 		}
-		return OneWire_Working;
+		return ow_searchPending(ow, res);
 	}
 
 	return OneWire_Working;
 }
 
+static OneWire_Result processSearchSlice(OneWire *ow)
+{
+	OneWire_Search *search = ow->searchContext;
+	OneWire_Result res = processSearch(ow);
+
+	if (res == OneWire_Success)
+		search->done = OneWire_True;
+	else if (ow->searchCount == search->count)
+		return res;
+	else
+	{
+		search->count = ow->searchCount;
+
+		// Passes cannot be interrupted, so the next one is only started when it fits into the budget of the slice
+		if (search->budget && ow->searchSlots - search->slots + ONEWIRE_SEARCH_PASS_SLOTS <= search->budget)
+			return OneWire_Working;
+
+		if (!ow->searchLastDiscrepancy)
+			search->done = OneWire_True;
+	}
+
+	search->lastDiscrepancy = ow->searchLastDiscrepancy;
+	search->count = ow->searchCount;
+	search->slots = ow->searchSlots;
+	return OneWire_Success;
+}
+
+// VERIFY
+
+static OneWire_Result processVerify(OneWire *ow)
+{
+	// Empty table finishes right away without touching the bus, the same way as a verified one
+	if (ow->verifyTable && !ow->verifyTable->count)
+		return OneWire_Success;
+
+	OneWire_Result res = processSearch(ow);
+	if (res != OneWire_Success)
+		return res;
+
+	// Search seeded with the whole ROM either finds exactly this ROM, or stops at first divergence
+	OneWire_Bool present = ow->searchCount != 0;
+
+	if (!ow->verifyTable)
+		return present ? OneWire_Success : OneWire_Failed;
+
+	if (present)
+		ow->verifyBitmap[ow->verifyIndex >> 3] |= 1 << (ow->verifyIndex & 0x07);
+	else
+		ow->verifyBitmap[ow->verifyIndex >> 3] &= ~(1 << (ow->verifyIndex & 0x07));
+
+	if (++ow->verifyIndex >= ow->verifyTable->count)
+		return OneWire_Success;
+
+	ow->searchTarget = ow->verifyTable->roms[ow->verifyIndex];
+	ow->searchCount = 0;
+	return OneWire_Working;
+}
+
 // Public functions
 
 void onewireInit(
@@ -291,90 +785,454 @@ void onewireInit(
 )
 {
 	ow->id = id;
+	ow->transport = &onewireBitBangTransport;
 	ow->setPinDir = setPinDir;
 	ow->setPinState = setPinState;
 	ow->readPin = readPin;
 	ow->startTimer = startTimer;
 	ow->readTimer = readTimer;
+	ow->resetRecovery = ONEWIRE_START_RECOVERY_TIME;
 }
 
-OneWire_Result onewireProcess(OneWire *ow)
+void onewireInitTransport(
+	OneWire *ow,
+	OneWire_Id id,
+	const OneWire_Transport *transport,
+	void *transportData,
+	OneWire_StartTimer startTimer,
+	OneWire_ReadTimer readTimer
+)
 {
-	OneWire_Result res = OneWire_Undefined;
+	ow->id = id;
+	ow->transport = transport;
+	ow->transportData = transportData;
+	ow->startTimer = startTimer;
+	ow->readTimer = readTimer;
+	ow->resetRecovery = ONEWIRE_START_RECOVERY_TIME;
+}
 
+#ifdef ONEWIRE_UART
+void onewireInitUart(
+	OneWire *ow,
+	OneWire_Id id,
+	OneWire_UartSetBaud setBaud,
+	OneWire_UartTransfer transfer,
+	OneWire_UartTransferDone transferDone,
+	OneWire_StartTimer startTimer,
+	OneWire_ReadTimer readTimer
+)
+{
+	onewireInitTransport(ow, id, &onewireUartTransport, 0, startTimer, readTimer);
+	ow->uartSetBaud = setBaud;
+	ow->uartTransfer = transfer;
+	ow->uartTransferDone = transferDone;
+}
+#endif
+
+static OneWire_Result ow_process(OneWire *ow)
+{
 	switch(ow->state)
 	{
 	case OneWire_Idle: return OneWire_NothingToDo;
-	case OneWire_Starting: res = processStart(ow); break;
-	case OneWire_Writing: res = processWrite(ow); break;
-	case OneWire_Reading: res = processRead(ow); break;
+	case OneWire_Starting: return ow->transport->reset(ow);
+	case OneWire_Writing: return ow->transport->write(ow);
+	case OneWire_Reading: return ow->transport->read(ow);
 	case OneWire_Searching:
 	case OneWire_SearchingAlarm:
-		res = processSearch(ow);
-		break;
+		return ow->searchContext ? processSearchSlice(ow) : processSearch(ow);
+	case OneWire_Verifying: return processVerify(ow);
+	case OneWire_Transacting: return processTransaction(ow);
 	}
 
-	if (res == OneWire_Success)
+	return OneWire_Undefined;
+}
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+
+static inline void ow_begin(OneWire *ow)
+{
+	// Only bit-bang transport is driven by timer interrupt
+	if (ow->transport != &onewireBitBangTransport)
+		return;
+
+	ow->result = OneWire_Working;
+	ow->timerStart = onewireReadTimer(ow);
+	ow->timerDelay = 0;
+	onewireTimerInterrupt(ow);
+}
+
+void onewireTimerInterrupt(OneWire *ow)
+{
+	OneWire_Result res;
+
+	// Compare left over from a delay which was already late when scheduled, or from a finished operation
+	if (ow->state == OneWire_Idle || onewireTimerElapsed(ow) < ow->timerDelay)
+		return;
+
+	// Run the state machine until the next edge is scheduled or the operation is done
+	do
+	{
+		ow->timerScheduled = OneWire_False;
+		res = ow_process(ow);
+	} while (res == OneWire_Working && !ow->timerScheduled);
+
+	if (res != OneWire_Working)
+	{
+		ow->result = res;
 		ow->state = OneWire_Idle;
+	}
+}
 
+OneWire_Result onewireProcess(OneWire *ow)
+{
+	if (ow->transport != &onewireBitBangTransport)
+	{
+		OneWire_Result res = ow_process(ow);
+		if (res == OneWire_Success || res == OneWire_Failed)
+			ow->state = OneWire_Idle;
+		return res;
+	}
+
+	if (*(volatile OneWire_State*)&ow->state != OneWire_Idle)
+		return OneWire_Working;
+
+	// Report completion event only once
+	OneWire_Result res = ow->result;
+	ow->result = OneWire_NothingToDo;
 	return res;
 }
 
+#else
+
+static inline void ow_begin(OneWire *ow)
+{
+	// Delay left from previous operation must not be reported by onewireTimeToService
+	ow->timerDelay = 0;
+}
+
+OneWire_Result onewireProcess(OneWire *ow)
+{
+	OneWire_Result res = ow_process(ow);
+
+	if (res == OneWire_Success || res == OneWire_Failed)
+		ow->state = OneWire_Idle;
+
+	return res;
+}
+
+#endif
+
+OneWire_Counter onewireTimeToService(const OneWire *ow)
+{
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	if (ow->transport == &onewireBitBangTransport)
+	{
+		// Interrupt advances the state machine, main loop is only needed to pick the result up
+		if (ow->state == OneWire_Idle && ow->result != OneWire_NothingToDo)
+			return 0;
+		return ONEWIRE_SERVICE_NONE;
+	}
+#endif
+
+	if (ow->state == OneWire_Idle)
+		return ONEWIRE_SERVICE_NONE;
+
+	// Other transports complete transfers on their own and have to be polled
+	if (ow->transport != &onewireBitBangTransport)
+		return 0;
+
+	OneWire_Counter elapsed = onewireTimerElapsed(ow);
+	return elapsed >= ow->timerDelay ? 0 : ow->timerDelay - elapsed;
+}
+
 void onewireStart(OneWire *ow)
 {
 	ow->state = OneWire_Starting;
 	ow->substate.startState = OneWire_Start_Begin;
+	ow_begin(ow);
 }
 
 void onewireWrite(OneWire *ow, OneWire_Byte *buffer, OneWire_Size length)
 {
 	ow->state = OneWire_Writing;
-	ow->substate.startState = OneWire_Write_Begin;
+	ow->substate.writeState = OneWire_Write_Begin;
 	ow->buffer = buffer;
 	ow->bufferLength = length;
 	ow->bitLength = 8;
+	ow_begin(ow);
 }
 
 void onewireRead(OneWire *ow, OneWire_Byte *buffer, OneWire_Size length)
 {
 	ow->state = OneWire_Reading;
-	ow->substate.startState = OneWire_Read_Begin;
+	ow->substate.readState = OneWire_Read_Begin;
 	ow->buffer = buffer;
 	ow->bufferLength = length;
 	ow->bitLength = 8;
+	ow->crc = 0;
+	ow_begin(ow);
+}
+
+void onewireTransact(OneWire *ow, const OneWire_Transaction *transaction)
+{
+	ow->state = OneWire_Transacting;
+	ow->transaction = transaction;
+	// First phase is entered by processTransaction, after ow_begin, so that a leading strong pullup keeps its delay
+	ow->transactionState = OneWire_Transaction_Begin;
+	ow_begin(ow);
 }
 
-static inline void onewireSearchReset(OneWire *ow)
+void onewireReadBit(OneWire *ow, OneWire_Byte *bit)
+{
+	ow->state = OneWire_Reading;
+	ow->substate.readState = OneWire_Read_Begin;
+	ow->buffer = bit;
+	ow->bufferLength = 1;
+	ow->bitLength = 1;
+	ow->crc = 0;
+	ow_begin(ow);
+}
+
+static inline void onewireSearchReset(OneWire *ow, OneWire_Bool alarm, OneWire_Address target, OneWire_Address targetMask)
 {
 	ow->searchLastDiscrepancy = 0;
+	ow->searchCount = 0;
+	ow->searchSlots = 0;
+	ow->searchContext = 0;
+	ow->searchTarget = target;
+	ow->searchTargetMask = targetMask;
+	ow->state = alarm ? OneWire_SearchingAlarm : OneWire_Searching;
+	ow->searchState = OneWire_Search_Begin;
 }
 
 void onewireSearch(OneWire *ow, OneWire_Bool alarm)
 {
-	onewireSearchReset(ow);
-	ow->state = OneWire_Searching;
-	ow->searchState = OneWire_Search_Begin;
+	ow->searchTable = 0;
+	onewireSearchReset(ow, alarm, 0, 0);
+	ow_begin(ow);
 }
 
 void onewireSearchTarget(OneWire *ow, OneWire_Bool alarm, OneWire_Byte familyCode)
 {
-	onewireSearchReset(ow);
-	ow->state = OneWire_SearchingAlarm;
-	ow->searchState = OneWire_Search_Begin;
+	// Family code occupies the lowest 8 bits of ROM, which are searched first
+	ow->searchTable = 0;
+	onewireSearchReset(ow, alarm, familyCode, 0xFF);
+	ow_begin(ow);
+}
+
+void onewireSearchTable(OneWire *ow, OneWire_RomTable *table, OneWire_Bool alarm, OneWire_Byte familyCode)
+{
+	table->count = 0;
+	table->rejected = 0;
+	table->overflow = OneWire_False;
+
+	ow->searchTable = table;
+	onewireSearchReset(ow, alarm, familyCode, familyCode == ONEWIRE_FAMILY_ANY ? 0 : 0xFF);
+	ow_begin(ow);
+}
+
+void onewireVerify(OneWire *ow, OneWire_Address rom)
+{
+	ow->searchTable = 0;
+	ow->verifyTable = 0;
+	onewireSearchReset(ow, OneWire_False, rom, ~(OneWire_Address)0);
+	ow->state = OneWire_Verifying;
+	ow_begin(ow);
+}
+
+void onewireVerifyTable(OneWire *ow, const OneWire_RomTable *table, OneWire_Byte *bitmap)
+{
+	ow->searchTable = 0;
+	ow->verifyTable = table;
+	ow->verifyBitmap = bitmap;
+	ow->verifyIndex = 0;
+	onewireSearchReset(ow, OneWire_False, table->count ? table->roms[0] : 0, ~(OneWire_Address)0);
+	ow->state = OneWire_Verifying;
+	ow_begin(ow);
 }
 
 void onewireAbortSearch(OneWire *ow)
 {
-	if (ow->state == OneWire_Searching || ow->state == OneWire_SearchingAlarm)
+	if (ow->state == OneWire_Searching || ow->state == OneWire_SearchingAlarm || ow->state == OneWire_Verifying)
+		ow->state = OneWire_Idle;
+}
+
+void onewireRomTableInit(OneWire_RomTable *table, OneWire_Address *roms, OneWire_Count capacity)
+{
+	table->roms = roms;
+	table->capacity = capacity;
+	table->count = 0;
+	table->rejected = 0;
+	table->overflow = OneWire_False;
+}
+
+static inline int ow_romCompare(OneWire_Address a, OneWire_Address b)
+{
+	// ROMs are ordered the way search finds them - by the lowest differing bit
+	OneWire_Address diff = a ^ b;
+	if (!diff)
+		return 0;
+	return (a & diff & -diff) ? 1 : -1;
+}
+
+static OneWire_Count ow_romLowerBound(const OneWire_RomTable *table, OneWire_Address rom)
+{
+	OneWire_Count low = 0;
+	OneWire_Count high = table->count;
+
+	while (low < high)
+	{
+		OneWire_Count mid = low + (high - low) / 2;
+		if (ow_romCompare(table->roms[mid], rom) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+OneWire_Count onewireRomTableFind(const OneWire_RomTable *table, OneWire_Address rom)
+{
+	OneWire_Count idx = ow_romLowerBound(table, rom);
+	return idx < table->count && table->roms[idx] == rom ? idx : ONEWIRE_ROM_NOT_FOUND;
+}
+
+OneWire_Bool onewireRomTableInsert(OneWire_RomTable *table, OneWire_Address rom)
+{
+	// Search finds ROMs in table order, so new ROM usually goes to the end
+	OneWire_Count idx = table->count && ow_romCompare(table->roms[table->count - 1], rom) < 0 ? table->count : ow_romLowerBound(table, rom);
+
+	if (idx < table->count && table->roms[idx] == rom)
+		return OneWire_False;
+
+	if (table->count >= table->capacity)
+	{
+		table->overflow = OneWire_True;
+		return OneWire_False;
+	}
+
+	for (OneWire_Count i = table->count; i > idx; --i)
+		table->roms[i] = table->roms[i - 1];
+
+	table->roms[idx] = rom;
+	++table->count;
+	return OneWire_True;
+}
+
+static inline OneWire_Size ow_romSharedBits(OneWire_Address a, OneWire_Address b)
+{
+	OneWire_Address diff = a ^ b;
+	OneWire_Size bits = 0;
+
+	if (!diff)
+		return 64;
+
+	while (!(diff & 0x01))
+	{
+		diff >>= 1;
+		++bits;
+	}
+
+	return bits;
+}
+
+OneWire_Size onewireRomTableSubtree(const OneWire_RomTable *table, OneWire_Count index)
+{
+	OneWire_Size shared = 0;
+	OneWire_Size bits;
+
+	if (table->count < 2)
+		return 0;
+
+	// Closest neighbour is the one branching off deepest
+	if (index > 0)
+		shared = ow_romSharedBits(table->roms[index], table->roms[index - 1]);
+
+	if (index + 1 < table->count && (bits = ow_romSharedBits(table->roms[index], table->roms[index + 1])) > shared)
+		shared = bits;
+
+	return shared < 64 ? shared + 1 : 64;
+}
+
+void onewireSearchUpdate(OneWire *ow, OneWire_RomTable *table, OneWire_Address rom, OneWire_Size depth)
+{
+	OneWire_Address mask = depth >= 64 ? ~(OneWire_Address)0 : ((OneWire_Address)1 << depth) - 1;
+	OneWire_Count first;
+	OneWire_Count last;
+
+	// Subtree is a contiguous range of the table, starting at its prefix followed by zeros
+	rom &= mask;
+	first = ow_romLowerBound(table, rom);
+	last = first;
+	while (last < table->count && !((table->roms[last] ^ rom) & mask))
+		++last;
+
+	for (OneWire_Count i = last; i < table->count; ++i)
+		table->roms[i - (last - first)] = table->roms[i];
+
+	table->count -= last - first;
+	table->rejected = 0;
+	table->overflow = OneWire_False;
+
+	ow->searchTable = table;
+	onewireSearchReset(ow, OneWire_False, rom, mask);
+	ow_begin(ow);
+}
+
+void onewireSearchInit(OneWire_Search *search, OneWire_RomTable *table, OneWire_Bool alarm, OneWire_Byte familyCode, OneWire_SlotCount budget)
+{
+	table->count = 0;
+	table->rejected = 0;
+	table->overflow = OneWire_False;
+
+	search->table = table;
+	search->lastDiscrepancy = 0;
+	search->target = familyCode;
+	search->targetMask = familyCode == ONEWIRE_FAMILY_ANY ? 0 : 0xFF;
+	search->budget = budget;
+	search->slots = 0;
+	search->count = 0;
+	search->alarm = alarm;
+	search->done = OneWire_False;
+}
+
+void onewireSearchContinue(OneWire *ow, OneWire_Search *search)
+{
+	if (search->done)
+	{
 		ow->state = OneWire_Idle;
+		return;
+	}
+
+	ow->searchTable = search->table;
+	onewireSearchReset(ow, search->alarm, search->target, search->targetMask);
+	ow->searchLastDiscrepancy = search->lastDiscrepancy;
+	ow->searchCount = search->count;
+	ow->searchSlots = search->slots;
+	ow->searchContext = search;
+	ow_begin(ow);
+}
+
+OneWire_SlotCount onewireSearchSlotsSaved(const OneWire *ow)
+{
+	OneWire_SlotCount naive = (OneWire_SlotCount)(ow->searchTable ? ow->searchTable->count : ow->searchCount) * ONEWIRE_SEARCH_PASS_SLOTS;
+
+	return naive > ow->searchSlots ? naive - ow->searchSlots : 0;
 }
 
-OneWire_Byte onewireCrc(OneWire_Byte *buffer, OneWire_Size len)
+OneWire_Byte onewireCrc(const OneWire_Byte *buffer, OneWire_Size len)
 {
 	OneWire_Byte crc = 0;
 
 	while (--len)
 	{
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+		crc = onewireCrcTable[crc ^ *buffer++];
+#elif ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_NIBBLE
+		OneWire_Byte idx = crc ^ *buffer++;
+		crc = ow_crcTableLow[idx & 0x0F] ^ ow_crcTableHigh[idx >> 4];
+#else
 		OneWire_Byte inbyte = *buffer++;
 		for (OneWire_Byte i = 8; i > 0; --i)
 		{
@@ -384,6 +1242,7 @@ OneWire_Byte onewireCrc(OneWire_Byte *buffer, OneWire_Size len)
 				crc ^= 0x8C;
 			inbyte >>= 1;
 		}
+#endif
 	}
 
 	return crc;
@@ -0,0 +1,279 @@
+#include "onewire_batch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define OWB_X86
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define OWB_NEON
+#endif
+
+// Definitions
+
+/**
+ * @brief CRC check of a block of records, writes `bitmap` bytes for exactly one block
+ */
+typedef void(*OWB_Kernel)(const OneWire_Byte *records, size_t stride, OneWire_Size length, OneWire_Byte *bitmap);
+
+/**
+ * @brief Kernel table entry
+ */
+typedef struct OWB_KernelEntry
+{
+	OWB_Kernel check;			/**< Vector CRC check function, null for the scalar kernel */
+	size_t block;				/**< Number of records checked at once, multiple of 8, 0 when not built for this target */
+} OWB_KernelEntry;
+
+// Private variables
+
+/** CRC8 is linear, so the byte table is XOR of tables of its two nibbles */
+static const OneWire_Byte owb_crcTableLow[16] = {
+	0x00, 0x5E, 0xBC, 0xE2, 0x61, 0x3F, 0xDD, 0x83, 0xC2, 0x9C, 0x7E, 0x20, 0xA3, 0xFD, 0x1F, 0x41
+};
+
+static const OneWire_Byte owb_crcTableHigh[16] = {
+	0x00, 0x9D, 0x23, 0xBE, 0x46, 0xDB, 0x65, 0xF8, 0x8C, 0x11, 0xAF, 0x32, 0xCA, 0x57, 0xE9, 0x74
+};
+
+/** Kernel forced by onewireBatchSelect, the fastest one is picked on every call otherwise */
+static OneWire_Bool owb_selected;
+static OneWire_BatchKernel owb_kernel;
+
+// Private functions
+
+static void owb_scalar(const OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count, OneWire_Byte *bitmap)
+{
+	size_t i = 0;
+
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+	// Table lookups of 8 records are interleaved, so their dependency chains overlap instead of running one after another
+	for (; i + 8 <= count; i += 8, records += 8 * stride)
+	{
+		OneWire_Byte crc0 = 0, crc1 = 0, crc2 = 0, crc3 = 0, crc4 = 0, crc5 = 0, crc6 = 0, crc7 = 0;
+
+		for (OneWire_Size j = 0; j < length; ++j)
+		{
+			const OneWire_Byte *data = records + j;
+
+			crc0 = onewireCrcTable[crc0 ^ data[0]];
+			crc1 = onewireCrcTable[crc1 ^ data[stride]];
+			crc2 = onewireCrcTable[crc2 ^ data[2 * stride]];
+			crc3 = onewireCrcTable[crc3 ^ data[3 * stride]];
+			crc4 = onewireCrcTable[crc4 ^ data[4 * stride]];
+			crc5 = onewireCrcTable[crc5 ^ data[5 * stride]];
+			crc6 = onewireCrcTable[crc6 ^ data[6 * stride]];
+			crc7 = onewireCrcTable[crc7 ^ data[7 * stride]];
+		}
+
+		// CRC over data followed by its own CRC byte is zero
+		OneWire_Byte valid = (crc0 == 0) | (crc1 == 0) << 1 | (crc2 == 0) << 2 | (crc3 == 0) << 3 |
+			(crc4 == 0) << 4 | (crc5 == 0) << 5 | (crc6 == 0) << 6 | (crc7 == 0) << 7;
+
+		*bitmap++ = valid;
+	}
+#endif
+
+	for (; i < count; i += 8)
+	{
+		OneWire_Byte valid = 0;
+
+		for (size_t r = 0; r < 8 && i + r < count; ++r, records += stride)
+			valid |= (onewireCrc(records, length) == records[length - 1]) << r;
+
+		*bitmap++ = valid;
+	}
+}
+
+/*
+ * Vector kernels load the first 16 bytes of 16 records and transpose them, so that byte J of every record lands in its own
+ * lane of row J. Each of four rounds interleaves row K with row K + 8, which rotates the 8-bit row:column index by one bit,
+ * so after four rounds rows and columns are swapped. CRC is then run on all lanes at once with two 16-entry nibble lookups per byte.
+ */
+
+#ifdef OWB_X86
+__attribute__((target("ssse3")))
+static void owb_kernelSSSE3(const OneWire_Byte *records, size_t stride, OneWire_Size length, OneWire_Byte *bitmap)
+{
+	const __m128i low = _mm_loadu_si128((const __m128i*)owb_crcTableLow);
+	const __m128i high = _mm_loadu_si128((const __m128i*)owb_crcTableHigh);
+	const __m128i nibble = _mm_set1_epi8(0x0F);
+	__m128i crc = _mm_setzero_si128();
+	__m128i rows[16];
+	__m128i tmp[16];
+
+	for (size_t r = 0; r < 16; ++r)
+		rows[r] = _mm_loadu_si128((const __m128i*)(records + r * stride));
+
+	for (size_t round = 0; round < 4; ++round)
+	{
+		for (size_t k = 0; k < 8; ++k)
+		{
+			tmp[2 * k] = _mm_unpacklo_epi8(rows[k], rows[k + 8]);
+			tmp[2 * k + 1] = _mm_unpackhi_epi8(rows[k], rows[k + 8]);
+		}
+
+		for (size_t k = 0; k < 16; ++k)
+			rows[k] = tmp[k];
+	}
+
+	for (OneWire_Size j = 0; j < length; ++j)
+	{
+		__m128i x = _mm_xor_si128(crc, rows[j]);
+		crc = _mm_xor_si128(_mm_shuffle_epi8(low, _mm_and_si128(x, nibble)), _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(x, 4), nibble)));
+	}
+
+	int valid = _mm_movemask_epi8(_mm_cmpeq_epi8(crc, _mm_setzero_si128()));
+	bitmap[0] = valid & 0xFF;
+	bitmap[1] = valid >> 8;
+}
+
+__attribute__((target("avx2")))
+static void owb_kernelAVX2(const OneWire_Byte *records, size_t stride, OneWire_Size length, OneWire_Byte *bitmap)
+{
+	// Lane 0 holds records 0-15 and lane 1 records 16-31, unpacking and shuffles work within lanes, so both get the same tables
+	const __m256i low = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)owb_crcTableLow));
+	const __m256i high = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)owb_crcTableHigh));
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	__m256i crc = _mm256_setzero_si256();
+	__m256i rows[16];
+	__m256i tmp[16];
+
+	for (size_t r = 0; r < 16; ++r)
+	{
+		__m128i first = _mm_loadu_si128((const __m128i*)(records + r * stride));
+		__m128i second = _mm_loadu_si128((const __m128i*)(records + (r + 16) * stride));
+		rows[r] = _mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1);
+	}
+
+	for (size_t round = 0; round < 4; ++round)
+	{
+		for (size_t k = 0; k < 8; ++k)
+		{
+			tmp[2 * k] = _mm256_unpacklo_epi8(rows[k], rows[k + 8]);
+			tmp[2 * k + 1] = _mm256_unpackhi_epi8(rows[k], rows[k + 8]);
+		}
+
+		for (size_t k = 0; k < 16; ++k)
+			rows[k] = tmp[k];
+	}
+
+	for (OneWire_Size j = 0; j < length; ++j)
+	{
+		__m256i x = _mm256_xor_si256(crc, rows[j]);
+		crc = _mm256_xor_si256(_mm256_shuffle_epi8(low, _mm256_and_si256(x, nibble)), _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(x, 4), nibble)));
+	}
+
+	uint32_t valid = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(crc, _mm256_setzero_si256()));
+	for (size_t b = 0; b < 4; ++b)
+		bitmap[b] = (valid >> (b * 8)) & 0xFF;
+}
+#endif
+
+#ifdef OWB_NEON
+static void owb_kernelNEON(const OneWire_Byte *records, size_t stride, OneWire_Size length, OneWire_Byte *bitmap)
+{
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	const uint8x16_t low = vld1q_u8(owb_crcTableLow);
+	const uint8x16_t high = vld1q_u8(owb_crcTableHigh);
+	uint8x16_t crc = vdupq_n_u8(0);
+	uint8x16_t rows[16];
+	uint8x16_t tmp[16];
+
+	for (size_t r = 0; r < 16; ++r)
+		rows[r] = vld1q_u8(records + r * stride);
+
+	for (size_t round = 0; round < 4; ++round)
+	{
+		for (size_t k = 0; k < 8; ++k)
+		{
+			tmp[2 * k] = vzip1q_u8(rows[k], rows[k + 8]);
+			tmp[2 * k + 1] = vzip2q_u8(rows[k], rows[k + 8]);
+		}
+
+		for (size_t k = 0; k < 16; ++k)
+			rows[k] = tmp[k];
+	}
+
+	for (OneWire_Size j = 0; j < length; ++j)
+	{
+		uint8x16_t x = veorq_u8(crc, rows[j]);
+		crc = veorq_u8(vqtbl1q_u8(low, vandq_u8(x, vdupq_n_u8(0x0F))), vqtbl1q_u8(high, vshrq_n_u8(x, 4)));
+	}
+
+	// Lanes with zero CRC keep their bit weight, each half sums to one bitmap byte
+	uint8x16_t valid = vandq_u8(vceqq_u8(crc, vdupq_n_u8(0)), vld1q_u8(weights));
+	bitmap[0] = vaddv_u8(vget_low_u8(valid));
+	bitmap[1] = vaddv_u8(vget_high_u8(valid));
+}
+#endif
+
+static const OWB_KernelEntry owb_kernels[] = {
+	[OneWire_Batch_Scalar] = { 0, 8 },
+#ifdef OWB_X86
+	[OneWire_Batch_SSSE3] = { &owb_kernelSSSE3, 16 },
+	[OneWire_Batch_AVX2] = { &owb_kernelAVX2, 32 },
+#endif
+#ifdef OWB_NEON
+	[OneWire_Batch_NEON] = { &owb_kernelNEON, 16 },
+#endif
+};
+
+static OneWire_Bool owb_supported(OneWire_BatchKernel kernel)
+{
+	if ((size_t)kernel >= sizeof(owb_kernels) / sizeof(owb_kernels[0]) || !owb_kernels[kernel].block)
+		return OneWire_False;
+
+#ifdef OWB_X86
+	if (kernel == OneWire_Batch_SSSE3)
+		return __builtin_cpu_supports("ssse3") != 0;
+	if (kernel == OneWire_Batch_AVX2)
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+
+	return OneWire_True;
+}
+
+// Public functions
+
+OneWire_Bool onewireBatchSelect(OneWire_BatchKernel kernel)
+{
+	if (!owb_supported(kernel))
+		return OneWire_False;
+
+	owb_kernel = kernel;
+	owb_selected = OneWire_True;
+	return OneWire_True;
+}
+
+OneWire_BatchKernel onewireBatchKernel(void)
+{
+	if (owb_selected)
+		return owb_kernel;
+
+	// Fastest available first, nothing is stored, so concurrent first calls do not race
+	if (owb_supported(OneWire_Batch_AVX2))
+		return OneWire_Batch_AVX2;
+	if (owb_supported(OneWire_Batch_SSSE3))
+		return OneWire_Batch_SSSE3;
+	if (owb_supported(OneWire_Batch_NEON))
+		return OneWire_Batch_NEON;
+	return OneWire_Batch_Scalar;
+}
+
+void onewireBatchCrc(const OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count, OneWire_Byte *bitmap)
+{
+	const OWB_KernelEntry *kernel = &owb_kernels[onewireBatchKernel()];
+	size_t i = 0;
+
+	// Vector kernels read 16 bytes of every record, so they stop before the last records where it would cross the end of data
+	if (kernel->check && length <= 16)
+	{
+		for (; i + kernel->block <= count && (count - i - kernel->block) * stride + length >= 16; i += kernel->block)
+			kernel->check(records + i * stride, stride, length, bitmap + i / 8);
+	}
+
+	// Blocks are multiples of 8 records, so the rest starts at a bitmap byte boundary
+	owb_scalar(records + i * stride, stride, length, count - i, bitmap + i / 8);
+}
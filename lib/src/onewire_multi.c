@@ -0,0 +1,321 @@
+#include "onewire_multi.h"
+
+// Private functions
+
+static inline void owm_delay(OneWireMulti *owm, OneWire_Counter time)
+{
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	owm->timerStart = owm->readTimer(owm);
+#else
+	owm->startTimer(owm);
+#endif
+	owm->timerDelay = time;
+}
+
+static inline OneWire_Bool owm_delayPassed(const OneWireMulti *owm)
+{
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	return (OneWire_Counter)(owm->readTimer(owm) - owm->timerStart) >= owm->timerDelay;
+#else
+	return owm->readTimer(owm) >= owm->timerDelay;
+#endif
+}
+
+static inline uint64_t owm_transpose(uint64_t x)
+{
+	// 8x8 bit matrix transpose - bit C of byte R is swapped with bit R of byte C, in three swaps of growing blocks
+	uint64_t t;
+
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+
+	return x;
+}
+
+static void owm_mux(OneWireMulti *owm)
+{
+	// Spread current byte of every bus into 8 port words, one per time slot
+	for (OneWire_Size b = 0; b < 8; ++b)
+		owm->slots[b] = 0;
+
+	for (OneWire_Size group = 0; group < sizeof(OneWireMulti_Port); ++group)
+	{
+		OneWire_Byte groupMask = (owm->busMask >> (group * 8)) & 0xFF;
+		uint64_t x = 0;
+
+		if (!groupMask)
+			continue;
+
+		for (OneWire_Size i = 0; i < 8; ++i)
+		{
+			if (groupMask & (1 << i))
+				x |= (uint64_t)owm->buffer[(group * 8 + i) * owm->stride + owm->byteIndex] << (i * 8);
+		}
+
+		x = owm_transpose(x);
+
+		for (OneWire_Size b = 0; b < 8; ++b)
+			owm->slots[b] |= (OneWireMulti_Port)((x >> (b * 8)) & 0xFF) << (group * 8);
+	}
+}
+
+static void owm_demux(OneWireMulti *owm)
+{
+	// Gather 8 sampled port words back into current byte of every bus
+	for (OneWire_Size group = 0; group < sizeof(OneWireMulti_Port); ++group)
+	{
+		OneWire_Byte groupMask = (owm->busMask >> (group * 8)) & 0xFF;
+		uint64_t x = 0;
+
+		if (!groupMask)
+			continue;
+
+		for (OneWire_Size b = 0; b < 8; ++b)
+			x |= (uint64_t)((owm->slots[b] >> (group * 8)) & 0xFF) << (b * 8);
+
+		x = owm_transpose(x);
+
+		for (OneWire_Size i = 0; i < 8; ++i)
+		{
+			if (groupMask & (1 << i))
+				owm->buffer[(group * 8 + i) * owm->stride + owm->byteIndex] = (x >> (i * 8)) & 0xFF;
+		}
+	}
+}
+
+static inline OneWire_Bool owm_nextBit(OneWireMulti *owm)
+{
+	if (++owm->bitIndex < 8)
+		return OneWire_False;
+
+	owm->bitIndex = 0;
+	return ++owm->byteIndex >= owm->bufferLength;
+}
+
+// START
+
+static OneWire_Result processStart(OneWireMulti *owm)
+{
+	switch(owm->slotState)
+	{
+	case OneWireMulti_Slot_Begin:
+		owm->setPort(owm, owm->busMask);
+		owm_delay(owm, ONEWIRE_START_RESET_TIME);
+		owm->slotState = OneWireMulti_Slot_1;
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_1:
+		if (owm_delayPassed(owm))
+		{
+			owm->setPort(owm, 0);
+			owm_delay(owm, ONEWIRE_START_RELEASE_TIME);
+			owm->slotState = OneWireMulti_Slot_2;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_2:
+		if (owm_delayPassed(owm))
+		{
+			owm->presence = ~owm->readPort(owm) & owm->busMask;
+			owm_delay(owm, ONEWIRE_START_WAIT_TIME);
+			owm->slotState = OneWireMulti_Slot_3;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_3:
+		if (owm_delayPassed(owm))
+		{
+			owm->slotState = OneWireMulti_Slot_Begin;
+			return OneWire_Success;
+		}
+		return OneWire_Working;
+	}
+
+	return OneWire_Working;
+}
+
+// WRITE
+
+static OneWire_Result processWrite(OneWireMulti *owm)
+{
+	switch(owm->slotState)
+	{
+	case OneWireMulti_Slot_Begin:
+		if (owm->bitIndex == 0)
+			owm_mux(owm);
+
+		owm->setPort(owm, owm->busMask);
+		owm_delay(owm, ONEWIRE_WRITE_HIGH_LOW_TIME);
+		owm->slotState = OneWireMulti_Slot_1;
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_1:
+		if (owm_delayPassed(owm))
+		{
+			// Buses writing 1 are released early, the rest is held low for the whole write 0 time
+			owm->setPort(owm, owm->busMask & ~owm->slots[owm->bitIndex]);
+			owm_delay(owm, ONEWIRE_WRITE_LOW_LOW_TIME - ONEWIRE_WRITE_HIGH_LOW_TIME);
+			owm->slotState = OneWireMulti_Slot_2;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_2:
+		if (owm_delayPassed(owm))
+		{
+			owm->setPort(owm, 0);
+			owm_delay(owm, ONEWIRE_WRITE_LOW_RELEASE_TIME);
+			owm->slotState = OneWireMulti_Slot_3;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_3:
+		if (owm_delayPassed(owm))
+		{
+			owm->slotState = OneWireMulti_Slot_Begin;
+
+			if (owm_nextBit(owm))
+			{
+				owm->byteIndex = 0;
+				return OneWire_Success;
+			}
+		}
+		return OneWire_Working;
+	}
+
+	return OneWire_Working;
+}
+
+// READ
+
+static OneWire_Result processRead(OneWireMulti *owm)
+{
+	switch(owm->slotState)
+	{
+	case OneWireMulti_Slot_Begin:
+		owm->setPort(owm, 0);
+		owm_delay(owm, ONEWIRE_READ_BEGIN_TIME);
+		owm->slotState = OneWireMulti_Slot_1;
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_1:
+		if (owm_delayPassed(owm))
+		{
+			owm->setPort(owm, owm->busMask);
+			owm_delay(owm, ONEWIRE_READ_LOW_TIME);
+			owm->slotState = OneWireMulti_Slot_2;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_2:
+		if (owm_delayPassed(owm))
+		{
+			owm->setPort(owm, 0);
+			owm->slots[owm->bitIndex] = owm->readPort(owm);
+
+			if (owm->bitIndex == 7)
+				owm_demux(owm);
+
+			if (owm_nextBit(owm))
+			{
+				owm->slotState = OneWireMulti_Slot_Begin;
+				owm->byteIndex = 0;
+				return OneWire_Success;
+			}
+
+			owm_delay(owm, ONEWIRE_READ_WAIT_TIME);
+			owm->slotState = OneWireMulti_Slot_3;
+		}
+		return OneWire_Working;
+
+	case OneWireMulti_Slot_3:
+		if (owm_delayPassed(owm))
+			owm->slotState = OneWireMulti_Slot_1;
+		return OneWire_Working;
+	}
+
+	return OneWire_Working;
+}
+
+// Public functions
+
+void onewireMultiInit(OneWireMulti *owm, OneWireMulti_Port busMask, OneWireMulti_SetPort setPort, OneWireMulti_ReadPort readPort, OneWireMulti_StartTimer startTimer, OneWireMulti_ReadTimer readTimer)
+{
+	owm->busMask = busMask;
+	owm->presence = 0;
+	owm->setPort = setPort;
+	owm->readPort = readPort;
+	owm->startTimer = startTimer;
+	owm->readTimer = readTimer;
+	owm->state = OneWireMulti_Idle;
+	owm->slotState = OneWireMulti_Slot_Begin;
+}
+
+OneWire_Result onewireMultiProcess(OneWireMulti *owm)
+{
+	OneWire_Result res;
+
+	switch(owm->state)
+	{
+	case OneWireMulti_Idle: return OneWire_NothingToDo;
+	case OneWireMulti_Starting: res = processStart(owm); break;
+	case OneWireMulti_Writing: res = processWrite(owm); break;
+	case OneWireMulti_Reading: res = processRead(owm); break;
+	default: return OneWire_Undefined;
+	}
+
+	if (res == OneWire_Success)
+		owm->state = OneWireMulti_Idle;
+
+	return res;
+}
+
+void onewireMultiStart(OneWireMulti *owm)
+{
+	owm->state = OneWireMulti_Starting;
+	owm->slotState = OneWireMulti_Slot_Begin;
+}
+
+void onewireMultiWrite(OneWireMulti *owm, OneWire_Byte *buffer, OneWire_Size length, OneWire_Size stride)
+{
+	owm->state = OneWireMulti_Writing;
+	owm->slotState = OneWireMulti_Slot_Begin;
+	owm->buffer = buffer;
+	owm->bufferLength = length;
+	owm->stride = stride;
+	owm->byteIndex = 0;
+	owm->bitIndex = 0;
+}
+
+void onewireMultiRead(OneWireMulti *owm, OneWire_Byte *buffer, OneWire_Size length, OneWire_Size stride)
+{
+	owm->state = OneWireMulti_Reading;
+	owm->slotState = OneWireMulti_Slot_Begin;
+	owm->buffer = buffer;
+	owm->bufferLength = length;
+	owm->stride = stride;
+	owm->byteIndex = 0;
+	owm->bitIndex = 0;
+}
+
+OneWireMulti_Port onewireMultiCrcValid(const OneWireMulti *owm)
+{
+	OneWireMulti_Port valid = 0;
+
+	// Nothing read, there is no CRC byte to check
+	if (!owm->bufferLength)
+		return 0;
+
+	for (OneWire_Size bus = 0; bus < ONEWIRE_MULTI_BUSES; ++bus)
+	{
+		OneWire_Byte *data = owm->buffer + bus * owm->stride;
+
+		if (owm->busMask & ((OneWireMulti_Port)1 << bus) && onewireCrc(data, owm->bufferLength) == data[owm->bufferLength - 1])
+			valid |= (OneWireMulti_Port)1 << bus;
+	}
+
+	return valid;
+}
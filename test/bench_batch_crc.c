@@ -0,0 +1,124 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "onewire_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def CRC_CACHED_RECORDS records verified in-cache, small enough to stay in L1 cache */
+#define CRC_CACHED_RECORDS 4096
+
+/** @def CRC_DUMP_RECORDS records verified from memory */
+#define CRC_DUMP_RECORDS 1000000
+
+static const char *const onewireKernels[] = { "scalar", "ssse3", "avx2", "neon" };
+
+static volatile long sink;
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void fillRecords(OneWire_Byte *records, OneWire_Size length, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		OneWire_Byte *record = records + i * length;
+		for (OneWire_Size b = 0; b < length; ++b)
+			record[b] = rand() & 0xFF;
+		if (rand() % 4)
+			record[length - 1] = onewireCrc(record, length);
+	}
+}
+
+static double crcLoop(const OneWire_Byte *records, OneWire_Size length, size_t count, int repeat)
+{
+	double start = now();
+	long valid = 0;
+
+	for (int r = 0; r < repeat; ++r)
+	{
+		for (size_t i = 0; i < count; ++i)
+			valid += onewireCrc(records + i * length, length) == records[i * length + length - 1];
+	}
+
+	sink += valid;
+	return now() - start;
+}
+
+static double crcBatch(const OneWire_Byte *records, OneWire_Size length, size_t count, int repeat, OneWire_Byte *bitmap)
+{
+	double start = now();
+
+	for (int r = 0; r < repeat; ++r)
+		onewireBatchCrc(records, length, length, count, bitmap);
+
+	sink += bitmap[0];
+	return now() - start;
+}
+
+/**
+ * @brief onewireCrc loop against every batch CRC kernel, runs are interleaved so that all of them see the same machine load
+ *
+ * @param length record length
+ * @param count number of records
+ * @param repeat passes over the records per run
+ * @param runs number of runs, the fastest one is reported
+ */
+static void benchCrc(OneWire_Size length, size_t count, int repeat, int runs)
+{
+	OneWire_Byte *records = malloc(count * length);
+	OneWire_Byte *bitmap = malloc((count + 7) / 8);
+	double loop = 1e9;
+	double batch[4] = { 1e9, 1e9, 1e9, 1e9 };
+
+	srand(length);
+	fillRecords(records, length, count);
+
+	for (int run = 0; run < runs; ++run)
+	{
+		double t = crcLoop(records, length, count, repeat);
+		if (t < loop)
+			loop = t;
+
+		for (int k = 0; k < 4; ++k)
+		{
+			if (!onewireBatchSelect(k))
+				continue;
+
+			t = crcBatch(records, length, count, repeat, bitmap);
+			if (t < batch[k])
+				batch[k] = t;
+		}
+	}
+
+	printf("%zu %d-byte records, onewireCrc loop %7.1f M records/s\n", count, length, repeat * count / loop / 1e6);
+	for (int k = 0; k < 4; ++k)
+	{
+		if (!onewireBatchSelect(k))
+			printf("  %-8s not available\n", onewireKernels[k]);
+		else
+			printf("  %-8s %7.1f M records/s (%.2fx)\n", onewireKernels[k], repeat * count / batch[k] / 1e6, loop / batch[k]);
+	}
+
+	onewireBatchSelect(OneWire_Batch_Scalar);
+	free(records);
+	free(bitmap);
+}
+
+int main(void)
+{
+	benchCrc(8, CRC_CACHED_RECORDS, 20, 200);
+	benchCrc(9, CRC_CACHED_RECORDS, 20, 200);
+	benchCrc(8, CRC_DUMP_RECORDS, 1, 5);
+	benchCrc(9, CRC_DUMP_RECORDS, 1, 5);
+	return 0;
+}
@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "ds18b20_batch.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def DECODE_SCRATCHPADS scratchpads decoded per run */
+#define DECODE_SCRATCHPADS 1000000
+
+/** @def DECODE_RUNS runs per kernel, the fastest one is reported */
+#define DECODE_RUNS 10
+
+static const char *const ds18b20Kernels[] = { "scalar", "sse2", "avx2", "neon" };
+
+static volatile long sink;
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void fillRecords(OneWire_Byte *records, OneWire_Size length, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		OneWire_Byte *record = records + i * length;
+		for (OneWire_Size b = 0; b < length; ++b)
+			record[b] = rand() & 0xFF;
+		if (rand() % 4)
+			record[length - 1] = onewireCrc(record, length);
+	}
+}
+
+/**
+ * @brief Scratchpads decoded one by one with the accessors of a single driver, the baseline of the batch kernels
+ */
+static double decodeLoop(const DS18B20_Byte *scratchpads, const DS18B20_BatchOutput *out)
+{
+	double start = now();
+
+	for (size_t i = 0; i < DECODE_SCRATCHPADS; ++i)
+	{
+		const DS18B20_Byte *sp = scratchpads + i * DS18B20_SCRATCHPAD_SIZE;
+
+		out->milli[i] = ds18b20RawToMilli(ds18b20MaskRaw((int16_t)(sp[0] | (sp[1] << 8)), (DS18B20Resolution)sp[4]));
+		if (out->crcValid)
+			out->crcValid[i] = onewireCrc(sp, DS18B20_SCRATCHPAD_SIZE) == sp[8];
+		if (out->resolution)
+			out->resolution[i] = 9 + ((sp[4] >> 5) & 0x03);
+		if (out->userByte1)
+		{
+			out->userByte1[i] = sp[2];
+			out->userByte2[i] = sp[3];
+		}
+	}
+
+	return now() - start;
+}
+
+/**
+ * @brief Every decoding kernel over a dump of scratchpads, with all output fields and with temperatures only
+ */
+static void benchDecode(void)
+{
+	static const DS18B20Resolution resolutions[] = { DS18B20_Resolution_9, DS18B20_Resolution_10, DS18B20_Resolution_11, DS18B20_Resolution_12 };
+	DS18B20_Byte *scratchpads = malloc((size_t)DECODE_SCRATCHPADS * DS18B20_SCRATCHPAD_SIZE);
+	int32_t *milli = malloc(DECODE_SCRATCHPADS * sizeof(int32_t));
+	DS18B20_Bool *crcValid = malloc(DECODE_SCRATCHPADS);
+	DS18B20_Byte *resolution = malloc(DECODE_SCRATCHPADS);
+	DS18B20_Byte *userByte1 = malloc(DECODE_SCRATCHPADS);
+	DS18B20_Byte *userByte2 = malloc(DECODE_SCRATCHPADS);
+	const DS18B20_BatchOutput all = { milli, crcValid, resolution, userByte1, userByte2 };
+	const DS18B20_BatchOutput temperatures = { milli, 0, 0, 0, 0 };
+
+	srand(24);
+	fillRecords(scratchpads, DS18B20_SCRATCHPAD_SIZE, DECODE_SCRATCHPADS);
+	for (size_t i = 0; i < DECODE_SCRATCHPADS; ++i)
+		scratchpads[i * DS18B20_SCRATCHPAD_SIZE + 4] = resolutions[rand() & 0x03];
+
+	double loopAll = 1e9;
+	double loopTemperatures = 1e9;
+
+	for (int run = 0; run < DECODE_RUNS; ++run)
+	{
+		double t = decodeLoop(scratchpads, &all);
+		if (t < loopAll)
+			loopAll = t;
+
+		t = decodeLoop(scratchpads, &temperatures);
+		if (t < loopTemperatures)
+			loopTemperatures = t;
+	}
+	sink += milli[0];
+
+	printf("%d scratchpads decoded\n", DECODE_SCRATCHPADS);
+	printf("  %-8s all fields %6.2f ms, temperatures only %6.2f ms\n", "loop", loopAll * 1e3, loopTemperatures * 1e3);
+	for (int k = 0; k < 4; ++k)
+	{
+		if (!ds18b20BatchSelect(k))
+		{
+			printf("  %-8s not available\n", ds18b20Kernels[k]);
+			continue;
+		}
+
+		double bestAll = 1e9;
+		double bestTemperatures = 1e9;
+
+		for (int run = 0; run < DECODE_RUNS; ++run)
+		{
+			double t = now();
+			ds18b20BatchDecode(scratchpads, DS18B20_SCRATCHPAD_SIZE, DECODE_SCRATCHPADS, &all);
+			t = now() - t;
+			if (t < bestAll)
+				bestAll = t;
+
+			t = now();
+			ds18b20BatchDecode(scratchpads, DS18B20_SCRATCHPAD_SIZE, DECODE_SCRATCHPADS, &temperatures);
+			t = now() - t;
+			if (t < bestTemperatures)
+				bestTemperatures = t;
+		}
+
+		sink += milli[0];
+		printf("  %-8s all fields %6.2f ms, temperatures only %6.2f ms\n", ds18b20Kernels[k], bestAll * 1e3, bestTemperatures * 1e3);
+	}
+
+	ds18b20BatchSelect(DS18B20_Batch_Scalar);
+
+	free(scratchpads);
+	free(milli);
+	free(crcValid);
+	free(resolution);
+	free(userByte1);
+	free(userByte2);
+}
+
+int main(void)
+{
+	benchDecode();
+	return 0;
+}
@@ -0,0 +1,73 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "onewire.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def SCRATCHPADS random scratchpads checked per pass */
+#define SCRATCHPADS (1 << 20)
+
+/** @def PASSES passes over the scratchpads per run */
+#define PASSES 4
+
+/** @def RUNS number of runs, the fastest one is reported */
+#define RUNS 10
+
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+#define CRC_VARIANT "full table"
+#elif ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_NIBBLE
+#define CRC_VARIANT "nibble tables"
+#else
+#define CRC_VARIANT "bitwise"
+#endif
+
+static volatile long sink;
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+	OneWire_Byte *scratchpads = malloc((size_t)SCRATCHPADS * 9);
+	double best = 1e9;
+
+	srand(1);
+	for (size_t i = 0; i < (size_t)SCRATCHPADS * 9; ++i)
+		scratchpads[i] = rand() & 0xFF;
+
+	for (int run = 0; run < RUNS; ++run)
+	{
+		double start = now();
+		long valid = 0;
+
+		for (int pass = 0; pass < PASSES; ++pass)
+		{
+			for (size_t i = 0; i < SCRATCHPADS; ++i)
+			{
+				const OneWire_Byte *sp = scratchpads + i * 9;
+				valid += onewireCrc(sp, 9) == sp[8];
+			}
+		}
+
+		double t = now() - start;
+		if (t < best)
+			best = t;
+		sink += valid;
+	}
+
+	printf("onewireCrc, %s: %d x %d 9-byte scratchpads, %.1f M scratchpads/s, %.2f ns per scratchpad\n",
+			CRC_VARIANT, PASSES, SCRATCHPADS, (double)PASSES * SCRATCHPADS / best / 1e6, best * 1e9 / ((double)PASSES * SCRATCHPADS));
+
+	free(scratchpads);
+	return 0;
+}
@@ -0,0 +1,54 @@
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def TRANSACTIONS transactions per measurement */
+#define TRANSACTIONS 1000
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+
+// Private functions
+
+/**
+ * @brief Transactions per second of simulated bus time for given gap after reset
+ */
+static void bench(const char *name, DS18b20ReadMode readMode, OneWire_Counter recovery)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+	ow.resetRecovery = recovery;
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = readMode;
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	int good = 0;
+	unsigned long start = simTime;
+	for (int i = 0; i < TRANSACTIONS; ++i)
+	{
+		ds18b20ReadScratchpad(&ds, dev->rom);
+		simRunDs18b20(&ds);
+		good += ds.error == DS18b20_Success && ds18b20GetTemperatureRaw(&ds) == 0x0191;
+	}
+	unsigned long took = simTime - start;
+
+	printf("%-12s gap %5u us: %6lu us per transaction, %6.1f transactions/s, %d/%d ok\n", name, (unsigned)recovery,
+		took / TRANSACTIONS, TRANSACTIONS * 1e6 / took, good, TRANSACTIONS);
+}
+
+int main(void)
+{
+	// 1000us is the gap every DS18B20 operation used to wait after reset
+	bench("temperature", DS18b20_Read_Temperature, ONEWIRE_START_RECOVERY_TIME);
+	bench("temperature", DS18b20_Read_Temperature, 1000);
+	bench("scratchpad", DS18b20_Read_CRC, ONEWIRE_START_RECOVERY_TIME);
+	bench("scratchpad", DS18b20_Read_CRC, 1000);
+
+	return 0;
+}
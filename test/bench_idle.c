@@ -0,0 +1,69 @@
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+
+static long calls;
+static long idleCalls;
+
+// Private functions
+
+/**
+ * @brief Call ds18b20Process until the operation finishes. A call made while the driver still reported time left
+ * until its next service is counted as idle. A spinning loop calls right away, a sleeping one waits the reported time.
+ */
+static void run(OneWire_Bool sleep)
+{
+	for (;;)
+	{
+		DS18B20_Time wait = ds18b20TimeToService(&ds);
+
+		if (sleep && wait > 1 && wait != DS18B20_SERVICE_NONE)
+		{
+			simTime += wait - 1;
+			wait = ds18b20TimeToService(&ds);
+		}
+
+		++calls;
+		if (wait > 0 && wait != DS18B20_SERVICE_NONE)
+			++idleCalls;
+
+		if (ds18b20Process(&ds) == DS18b20_State_Finished)
+			return;
+	}
+}
+
+static void bench(const char *name, OneWire_Bool sleep)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	calls = 0;
+	idleCalls = 0;
+	unsigned long start = simTime;
+
+	ds18b20BeginConversion(&ds, dev->rom);
+	run(sleep);
+	ds18b20ReadScratchpad(&ds, dev->rom);
+	run(sleep);
+
+	printf("%-9s %7ld process calls, %7ld made no progress, cycle took %lu us, %s\n", name, calls, idleCalls,
+		simTime - start, ds18b20VerifyCrc(&ds) && ds18b20GetTemperatureRaw(&ds) == 0x0191 ? "reading ok" : "reading FAILED");
+}
+
+int main(void)
+{
+	bench("spinning", OneWire_False);
+	bench("sleeping", OneWire_True);
+
+	return 0;
+}
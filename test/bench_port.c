@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Private definitions
+
+/** @def BYTES bytes written and read per operation */
+#define BYTES 255
+
+/** @def OPERATIONS write and read operations per run */
+#define OPERATIONS 16
+
+/** @def RUNS number of runs, the fastest one is reported */
+#define RUNS 20
+
+#ifdef ONEWIRE_PORT_HEADER
+#define PORT_MODE "port header"
+#else
+#define PORT_MODE "callbacks"
+#endif
+
+// Private variables
+
+static OneWire ow;
+static OneWire_Byte data[BYTES];
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static unsigned long long cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * @brief Run operation the way a sleeping main loop would - the engine is only called when its next edge is due,
+ * so the measured time is spent in the state machine and the pin and timer primitives rather than in polling
+ */
+static void run(void)
+{
+	while (onewireProcess(&ow) == OneWire_Working)
+	{
+		OneWire_Counter wait = onewireTimeToService(&ow);
+		if (wait > 1 && wait != ONEWIRE_SERVICE_NONE)
+			simTime += wait - 1;
+	}
+}
+
+int main(void)
+{
+	double bestTime = 1e9;
+	unsigned long long bestCycles = ~0ULL;
+	long slots = 0;
+
+	simReset();
+	simInitOneWire(&ow, 0);
+
+	for (int i = 0; i < BYTES; ++i)
+		data[i] = i * 37;
+
+	for (int r = 0; r < RUNS; ++r)
+	{
+		long before = simBuses[0].slots;
+		double start = now();
+		unsigned long long startCycles = cycles();
+
+		// No device is attached, read slots are answered by the pullup
+		for (int op = 0; op < OPERATIONS; ++op)
+		{
+			onewireWrite(&ow, data, BYTES);
+			run();
+			onewireRead(&ow, data, BYTES);
+			run();
+		}
+		simSettle();
+
+		unsigned long long c = cycles() - startCycles;
+		double t = now() - start;
+		if (t < bestTime)
+			bestTime = t;
+		if (c < bestCycles)
+			bestCycles = c;
+		slots = simBuses[0].slots - before;
+	}
+
+	printf("%-12s %ld slots, %6.1f ns per slot", PORT_MODE, slots, bestTime * 1e9 / slots);
+	if (bestCycles)
+		printf(", %6.1f cycles per slot", (double)bestCycles / slots);
+	printf("\n");
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def SENSORS largest number of sensors on the bus */
+#define SENSORS 100
+
+/** @def RUNS number of runs, the fastest one is reported */
+#define RUNS 5
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+static OneWire_Address roms[SENSORS];
+static OneWire_RomTable table;
+static DS18B20_Reading readings[SENSORS];
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void setup(int sensors)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+
+	onewireRomTableInit(&table, roms, SENSORS);
+	for (int i = 0; i < sensors; ++i)
+	{
+		roms[i] = simAddDevice(0, 0x0000C00000000028ULL | (OneWire_Address)(i + 1) << 16, (int16_t)(0x0100 + i))->rom;
+	}
+	table.count = sensors;
+}
+
+/**
+ * @brief Bus time of one sampling cycle, CPU time of the fastest run
+ */
+static unsigned long benchSample(int sensors, double *cpu, int *good)
+{
+	unsigned long busTime = 0;
+
+	setup(sensors);
+	*cpu = 1e9;
+	for (int r = 0; r < RUNS; ++r)
+	{
+		unsigned long start = simTime;
+		double t = now();
+
+		ds18b20Sample(&ds, &table, readings);
+		simRunDs18b20(&ds);
+
+		t = now() - t;
+		if (t < *cpu)
+			*cpu = t;
+		busTime = simTime - start;
+	}
+
+	*good = 0;
+	for (int i = 0; i < sensors; ++i)
+		*good += readings[i].error == DS18b20_Success && readings[i].raw == 0x0100 + i;
+	return busTime;
+}
+
+/**
+ * @brief Bus time of converting and reading every sensor one by one by address
+ */
+static unsigned long benchSequential(int sensors)
+{
+	setup(sensors);
+	unsigned long start = simTime;
+
+	ds.convertMode = DS18b20_ConvertMode_Wait;
+	for (int i = 0; i < sensors; ++i)
+	{
+		ds18b20BeginConversion(&ds, roms[i]);
+		simRunDs18b20(&ds);
+		ds18b20ReadScratchpad(&ds, roms[i]);
+		simRunDs18b20(&ds);
+	}
+
+	return simTime - start;
+}
+
+int main(void)
+{
+	static const int counts[] = { 1, 10, 100 };
+
+	for (unsigned i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		int n = counts[i], good;
+		double cpu;
+		unsigned long cycle = benchSample(n, &cpu, &good);
+		unsigned long sequential = benchSequential(n);
+
+		printf("%3d sensors: cycle %8lu us bus time, %7.1f samples/s, %8.1f us CPU, %3d/%d readings ok;"
+			" one by one %9lu us, %6.2f samples/s\n", n, cycle, n * 1e6 / cycle, cpu * 1e6, good, n,
+			sequential, n * 1e6 / sequential);
+	}
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "ds18b20.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def SCRATCHPADS random scratchpads converted per pass */
+#define SCRATCHPADS (1 << 20)
+
+/** @def RUNS number of runs, the fastest one is reported */
+#define RUNS 10
+
+static volatile double sink;
+
+// Private variables
+
+static DS18B20 *sensors;
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double runMilli(void)
+{
+	double best = 1e9;
+
+	for (int run = 0; run < RUNS; ++run)
+	{
+		double start = now();
+		long sum = 0;
+
+		for (size_t i = 0; i < SCRATCHPADS; ++i)
+			sum += ds18b20GetTemperatureMilli(&sensors[i]);
+
+		double t = now() - start;
+		if (t < best)
+			best = t;
+		sink += sum;
+	}
+
+	return best;
+}
+
+#if DS18B20_FLOAT_ENABLED
+
+static double runFloat(void)
+{
+	double best = 1e9;
+
+	for (int run = 0; run < RUNS; ++run)
+	{
+		double start = now();
+		float sum = 0;
+
+		for (size_t i = 0; i < SCRATCHPADS; ++i)
+			sum += ds18b20GetTemperatureFloat(&sensors[i]);
+
+		double t = now() - start;
+		if (t < best)
+			best = t;
+		sink += sum;
+	}
+
+	return best;
+}
+
+#endif
+
+static void report(const char *name, double t)
+{
+	printf("%-28s %d conversions, %.1f M conversions/s, %.2f ns per conversion\n",
+			name, SCRATCHPADS, SCRATCHPADS / t / 1e6, t * 1e9 / SCRATCHPADS);
+}
+
+int main(void)
+{
+	sensors = calloc(SCRATCHPADS, sizeof(DS18B20));
+
+	// Sensor range -55..125 degrees at random resolutions
+	srand(23);
+	for (size_t i = 0; i < SCRATCHPADS; ++i)
+	{
+		int raw = -55 * 16 + rand() % (180 * 16 + 1);
+
+		sensors[i].buffer[0] = (DS18B20_Byte)(raw & 0xFF);
+		sensors[i].buffer[1] = (DS18B20_Byte)((raw >> 8) & 0xFF);
+		sensors[i].resolution = (DS18B20Resolution)(DS18B20_Resolution_9 + (rand() % 4) * 0x20);
+	}
+
+	report("ds18b20GetTemperatureMilli", runMilli());
+#if DS18B20_FLOAT_ENABLED
+	// Host FPU makes the float path cheap here, targets without one pay a soft-float multiply per call
+	report("ds18b20GetTemperatureFloat", runFloat());
+#endif
+
+	free(sensors);
+	return 0;
+}
@@ -0,0 +1,93 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Private definitions
+
+/** @def READS scratchpad reads per run */
+#define READS 2000
+
+/** @def RUNS number of runs, the fastest one is reported */
+#define RUNS 10
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+
+// Private functions
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Run operation the way a sleeping main loop would and count calls of ds18b20Process
+ */
+static long run(void)
+{
+	long calls = 1;
+
+	while (ds18b20Process(&ds) != DS18b20_State_Finished)
+	{
+		DS18B20_Time wait = ds18b20TimeToService(&ds);
+		if (wait > 1 && wait != DS18B20_SERVICE_NONE)
+			simTime += wait - 1;
+		++calls;
+	}
+
+	return calls;
+}
+
+static void bench(const char *name, OneWire_Bool mock)
+{
+	double best = 1e9;
+	long calls = 0;
+	unsigned long busTime = 0;
+
+	simReset();
+	if (mock)
+		simInitMock(&ow, 0, OneWire_True);
+	else
+		simInitOneWire(&ow, 0);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	for (int r = 0; r < RUNS; ++r)
+	{
+		unsigned long startTime = simTime;
+		double start = now();
+
+		calls = 0;
+		for (int i = 0; i < READS; ++i)
+		{
+			ds18b20ReadScratchpad(&ds, dev->rom);
+			calls += run();
+		}
+
+		double t = now() - start;
+		if (t < best)
+			best = t;
+		busTime = simTime - startTime;
+	}
+
+	printf("%-10s %6.1f process calls, %8.1f ns CPU, %6lu us bus time per 9-byte read\n",
+		name, (double)calls / READS, best * 1e9 / READS, busTime / READS);
+}
+
+int main(void)
+{
+	bench("bit-bang", OneWire_False);
+	bench("mock", OneWire_True);
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef _h_onewire_port
+#define _h_onewire_port
+
+/*
+ * Compile-time port binding of the simulated buses, used by the configuration which defines
+ * ONEWIRE_PORT_HEADER as "onewire_port.h". Every pin and timer operation is a direct call
+ * into the simulation instead of an indirect call through OneWire callbacks.
+ */
+
+void simSetPinDir(OneWire_Id bus, OneWire_PinDirection dir);
+void simSetPinState(OneWire_Id bus, OneWire_PinState state);
+OneWire_PinState simReadPin(OneWire_Id bus);
+void simStartTimer(OneWire_Id bus);
+OneWire_Counter simReadTimer(OneWire_Id bus);
+
+static inline void onewirePortSetPinDir(const OneWire *ow, OneWire_PinDirection dir)
+{
+	simSetPinDir(ow->id, dir);
+}
+
+static inline void onewirePortSetPinState(const OneWire *ow, OneWire_PinState state)
+{
+	simSetPinState(ow->id, state);
+}
+
+static inline OneWire_PinState onewirePortReadPin(const OneWire *ow)
+{
+	return simReadPin(ow->id);
+}
+
+static inline void onewirePortStartTimer(const OneWire *ow)
+{
+	simStartTimer(ow->id);
+}
+
+static inline OneWire_Counter onewirePortReadTimer(const OneWire *ow)
+{
+	return simReadTimer(ow->id);
+}
+
+#endif
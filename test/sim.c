@@ -0,0 +1,802 @@
+#include "sim.h"
+
+#include <string.h>
+
+// Simulation state
+
+SimBus simBuses[SIM_BUSES];
+unsigned long simTime;
+unsigned long simLatency;
+
+static unsigned long sim_timerBase[SIM_BUSES];
+static unsigned long sim_multiTimerBase;
+
+SimMock simMocks[SIM_BUSES];
+#ifdef ONEWIRE_UART
+SimUart simUarts[SIM_BUSES];
+#endif
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+static unsigned long sim_compare[SIM_BUSES];
+static OneWire_Bool sim_compareArmed[SIM_BUSES];
+#endif
+
+// Private functions
+
+static OneWire_Byte sim_crc(const OneWire_Byte *data, int length)
+{
+	OneWire_Byte crc = 0;
+
+	// Bitwise reference, independent of the lookup tables under test
+	for (int i = 0; i < length; ++i)
+	{
+		for (int b = 0; b < 8; ++b)
+			crc = ((crc ^ (data[i] >> b)) & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+	}
+
+	return crc;
+}
+
+static void sim_updateCrc(SimDevice *dev)
+{
+	dev->scratchpad[8] = sim_crc(dev->scratchpad, 8);
+}
+
+static void sim_transmit(SimDevice *dev, const OneWire_Byte *data, OneWire_Size length, SimDeviceState next)
+{
+	memcpy(dev->tx, data, length);
+	dev->txLength = length;
+	dev->txNext = next;
+	dev->state = Sim_Device_Transmit;
+}
+
+static void sim_busy(SimDevice *dev)
+{
+	dev->busyUntil = dev->busyTime == SIM_FOREVER ? SIM_FOREVER : simTime + dev->busyTime;
+	dev->state = Sim_Device_Busy;
+}
+
+static OneWire_Bool sim_romBit(const SimDevice *dev, unsigned bit)
+{
+	return (dev->rom >> bit) & 0x01;
+}
+
+static void sim_romCommand(SimDevice *dev, OneWire_Byte command)
+{
+	OneWire_Byte rom[8];
+
+	switch(command)
+	{
+	case DS18B20_SEARCH_ROM: dev->state = Sim_Device_Search; break;
+	case DS18B20_ALARM_SEARCH: dev->state = dev->alarm ? Sim_Device_Search : Sim_Device_Idle; break;
+	case DS18B20_MATCH_ROM: dev->state = Sim_Device_Match; break;
+	case DS18B20_SKIP_ROM: dev->state = Sim_Device_Function; break;
+	case DS18B20_READ_ROM:
+		for (int i = 0; i < 8; ++i)
+			rom[i] = (dev->rom >> (i * 8)) & 0xFF;
+		sim_transmit(dev, rom, 8, Sim_Device_Function);
+		break;
+	default: dev->state = Sim_Device_Idle; break;
+	}
+}
+
+static void sim_functionCommand(SimDevice *dev, OneWire_Byte command)
+{
+	switch(command)
+	{
+	case DS18B20_READ_SCRATCHPAD:
+		sim_transmit(dev, dev->scratchpad, 9, Sim_Device_Idle);
+		break;
+
+	case DS18B20_WRITE_SCRATCHPAD:
+		dev->rxIndex = 0;
+		dev->state = Sim_Device_Receive;
+		break;
+
+	case DS18B20_COPY_SCRATCHPAD:
+		memcpy(dev->eeprom, dev->scratchpad + 2, 3);
+		sim_busy(dev);
+		break;
+
+	case DS18B20_RECALL_EEPROM:
+		memcpy(dev->scratchpad + 2, dev->eeprom, 3);
+		sim_updateCrc(dev);
+		sim_busy(dev);
+		break;
+
+	case DS18B20_CONVERT:
+		dev->scratchpad[0] = dev->temperature & 0xFF;
+		dev->scratchpad[1] = (dev->temperature >> 8) & 0xFF;
+		sim_updateCrc(dev);
+		sim_busy(dev);
+		break;
+
+	case DS18B20_READ_POWER_SUPPLY:
+		dev->state = Sim_Device_PowerSupply;
+		break;
+
+	default:
+		dev->state = Sim_Device_Idle;
+		break;
+	}
+}
+
+static OneWire_Bool sim_deviceDrive(const SimDevice *dev)
+{
+	switch(dev->state)
+	{
+	case Sim_Device_Search:
+		// Address bit, its complement, then the direction written by master
+		switch(dev->bit % 3)
+		{
+		case 0: return sim_romBit(dev, dev->bit / 3);
+		case 1: return !sim_romBit(dev, dev->bit / 3);
+		default: return OneWire_True;
+		}
+
+	case Sim_Device_Transmit: return (dev->tx[dev->bit / 8] >> (dev->bit % 8)) & 0x01;
+	case Sim_Device_Busy: return simTime >= dev->busyUntil;
+	case Sim_Device_PowerSupply: return !dev->parasitic;
+	default: return OneWire_True;
+	}
+}
+
+static void sim_deviceSample(SimDevice *dev, OneWire_Bool line)
+{
+	switch(dev->state)
+	{
+	case Sim_Device_RomCommand:
+	case Sim_Device_Function:
+	case Sim_Device_Receive:
+		dev->shift |= line << dev->bit;
+		if (++dev->bit < 8)
+			return;
+
+		OneWire_Byte data = dev->shift;
+		dev->bit = 0;
+		dev->shift = 0;
+
+		if (dev->state == Sim_Device_RomCommand)
+			sim_romCommand(dev, data);
+		else if (dev->state == Sim_Device_Function)
+			sim_functionCommand(dev, data);
+		else
+		{
+			dev->scratchpad[2 + dev->rxIndex] = data;
+			sim_updateCrc(dev);
+			if (++dev->rxIndex == 3)
+				dev->state = Sim_Device_Idle;
+		}
+		return;
+
+	case Sim_Device_Search:
+		if (dev->bit % 3 == 2 && line != sim_romBit(dev, dev->bit / 3))
+			dev->state = Sim_Device_Idle;
+		else if (++dev->bit == 64 * 3)
+		{
+			dev->bit = 0;
+			dev->state = Sim_Device_Function;
+		}
+		return;
+
+	case Sim_Device_Match:
+		if (line != sim_romBit(dev, dev->bit))
+			dev->state = Sim_Device_Idle;
+		else if (++dev->bit == 64)
+		{
+			dev->bit = 0;
+			dev->state = Sim_Device_Function;
+		}
+		return;
+
+	case Sim_Device_PowerSupply:
+		// Answer takes only the first read slot
+		dev->state = Sim_Device_Idle;
+		return;
+
+	case Sim_Device_Transmit:
+		if (++dev->bit == dev->txLength * 8u)
+		{
+			dev->bit = 0;
+			dev->state = dev->txNext;
+		}
+		return;
+
+	default:
+		return;
+	}
+}
+
+static OneWire_Bool sim_busSlot(SimBus *bus, OneWire_Bool master)
+{
+	OneWire_Bool line = master;
+
+	++bus->slots;
+
+	// Open drain - any device driving 0 pulls the line low
+	for (int i = 0; i < bus->count; ++i)
+	{
+		if (bus->devices[i].present)
+			line &= sim_deviceDrive(&bus->devices[i]);
+	}
+
+	for (int i = 0; i < bus->count; ++i)
+	{
+		if (bus->devices[i].present)
+			sim_deviceSample(&bus->devices[i], line);
+	}
+
+	return line;
+}
+
+static void sim_busReset(SimBus *bus)
+{
+	++bus->resets;
+	bus->presence = OneWire_False;
+
+	for (int i = 0; i < bus->count; ++i)
+	{
+		SimDevice *dev = &bus->devices[i];
+
+		dev->state = dev->present ? Sim_Device_RomCommand : Sim_Device_Idle;
+		dev->bit = 0;
+		dev->shift = 0;
+		bus->presence |= dev->present;
+	}
+
+	bus->presencePending = OneWire_True;
+}
+
+static void sim_busDrive(SimBus *bus, OneWire_Bool low)
+{
+	if (low == bus->low)
+		return;
+
+	if (low)
+	{
+		// Slot started by previous falling edge ends here, write 1 unless it was sampled as a read slot
+		if (bus->slotPending)
+		{
+			bus->slotPending = OneWire_False;
+			sim_busSlot(bus, OneWire_True);
+		}
+
+		bus->presencePending = OneWire_False;
+		bus->lowAt = simTime;
+	}
+	else
+	{
+		unsigned long width = simTime - bus->lowAt;
+
+		if (width >= 400)
+		{
+			if (!bus->resetMin || width < bus->resetMin)
+				bus->resetMin = width;
+			sim_busReset(bus);
+		}
+		else if (width < 15)
+		{
+			if (width > bus->oneMax)
+				bus->oneMax = width;
+			bus->slotPending = OneWire_True;
+		}
+		else
+		{
+			if (!bus->zeroMin || width < bus->zeroMin)
+				bus->zeroMin = width;
+			if (width > bus->zeroMax)
+				bus->zeroMax = width;
+			sim_busSlot(bus, OneWire_False);
+		}
+	}
+
+	bus->low = low;
+}
+
+static OneWire_Bool sim_busRead(SimBus *bus)
+{
+	if (bus->low)
+		return OneWire_False;
+
+	if (bus->slotPending)
+	{
+		if (simTime - bus->lowAt > bus->sampleMax)
+			bus->sampleMax = simTime - bus->lowAt;
+
+		bus->slotPending = OneWire_False;
+		return sim_busSlot(bus, OneWire_True);
+	}
+
+	if (bus->presencePending)
+		return !bus->presence;
+
+	return OneWire_True;
+}
+
+static void sim_busPin(SimBus *bus, OneWire_Bool output, OneWire_Bool high)
+{
+	OneWire_Bool pullup = output && high;
+
+	if (pullup && !(bus->output && bus->outputHigh))
+		bus->pullupAt = simTime;
+	else if (!pullup && bus->output && bus->outputHigh)
+		bus->pullupTime = simTime - bus->pullupAt;
+
+	bus->output = output;
+	bus->outputHigh = high;
+	sim_busDrive(bus, output && !high);
+}
+
+static void sim_tick(void)
+{
+	++simTime;
+
+	// Devices sample write 1 slots 15 us after the falling edge
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		SimBus *bus = &simBuses[i];
+		if (bus->slotPending && simTime - bus->lowAt >= 15)
+		{
+			bus->slotPending = OneWire_False;
+			sim_busSlot(bus, OneWire_True);
+		}
+	}
+}
+
+// OneWire callbacks
+
+static void sim_setPinDir(const OneWire *ow, OneWire_PinDirection dir)
+{
+	simSetPinDir(ow->id, dir);
+}
+
+static void sim_setPinState(const OneWire *ow, OneWire_PinState state)
+{
+	simSetPinState(ow->id, state);
+}
+
+static OneWire_PinState sim_readPin(const OneWire *ow)
+{
+	return simReadPin(ow->id);
+}
+
+static void sim_startTimer(const OneWire *ow)
+{
+	simStartTimer(ow->id);
+}
+
+static OneWire_Counter sim_readTimer(const OneWire *ow)
+{
+	return simReadTimer(ow->id);
+}
+
+// Mock transport
+
+/** @def SIM_SLOT_TIME bus time of a single time slot including recovery [us] */
+#define SIM_SLOT_TIME 70
+
+/** @def SIM_RESET_TIME bus time of reset pulse and presence detection [us] */
+#define SIM_RESET_TIME 960
+
+static OneWire_Bool sim_mockPoll(const OneWire *ow)
+{
+	SimMock *mock = &simMocks[ow->id];
+
+	++mock->calls;
+	if (!mock->busy)
+	{
+		mock->busy = OneWire_True;
+		mock->pending = mock->pollCalls;
+	}
+	if (mock->pending > 0)
+	{
+		--mock->pending;
+		return OneWire_False;
+	}
+	mock->busy = OneWire_False;
+	return OneWire_True;
+}
+
+static OneWire_Bool sim_mockSlot(const OneWire *ow, OneWire_Bool bit)
+{
+	simTime += SIM_SLOT_TIME;
+	return simBusSlot(ow->id, bit);
+}
+
+static OneWire_Result sim_mockReset(OneWire *ow)
+{
+	if (!sim_mockPoll(ow))
+		return OneWire_Working;
+
+	simTime += SIM_RESET_TIME;
+	ow->presence = simBusReset(ow->id);
+	if (ow->detectedCallback && ow->presence)
+		ow->detectedCallback(ow);
+
+	++simMocks[ow->id].resets;
+	return OneWire_Success;
+}
+
+static OneWire_Result sim_mockWrite(OneWire *ow)
+{
+	if (!sim_mockPoll(ow))
+		return OneWire_Working;
+
+	for (OneWire_Size i = 0; i < ow->bufferLength; ++i)
+		for (OneWire_Byte b = 0; b < ow->bitLength; ++b)
+			sim_mockSlot(ow, (ow->buffer[i] >> b) & 1);
+
+	++simMocks[ow->id].writes;
+	return OneWire_Success;
+}
+
+static OneWire_Result sim_mockRead(OneWire *ow)
+{
+	if (!sim_mockPoll(ow))
+		return OneWire_Working;
+
+	for (OneWire_Size i = 0; i < ow->bufferLength; ++i)
+	{
+		for (OneWire_Byte b = 0; b < ow->bitLength; ++b)
+		{
+			OneWire_Bool bit = sim_mockSlot(ow, OneWire_True);
+
+			ow->buffer[i] |= bit << b;
+			if (ow->state == OneWire_Reading || ow->state == OneWire_Transacting)
+				ow->crc = onewireCrcBit(ow->crc, bit);
+		}
+	}
+
+	++simMocks[ow->id].reads;
+	return OneWire_Success;
+}
+
+#ifdef ONEWIRE_SEARCH
+static OneWire_Result sim_mockTriplet(OneWire *ow)
+{
+	if (!sim_mockPoll(ow))
+		return OneWire_Working;
+
+	OneWire_Bool bit = sim_mockSlot(ow, OneWire_True);
+	OneWire_Bool complement = sim_mockSlot(ow, OneWire_True);
+	OneWire_Bool direction = bit != complement ? bit : (ow->searchHelper & 1);
+
+	sim_mockSlot(ow, direction);
+	ow->searchHelper = bit | (complement << 1) | (direction << 2);
+
+	++simMocks[ow->id].triplets;
+	return OneWire_Success;
+}
+#endif
+
+static const OneWire_Transport sim_mockTransport = {
+	.reset = &sim_mockReset,
+	.write = &sim_mockWrite,
+	.read = &sim_mockRead
+};
+
+#ifdef ONEWIRE_SEARCH
+static const OneWire_Transport sim_mockTripletTransport = {
+	.reset = &sim_mockReset,
+	.write = &sim_mockWrite,
+	.read = &sim_mockRead,
+	.triplet = &sim_mockTriplet
+};
+#endif
+
+#ifdef ONEWIRE_UART
+
+// UART callbacks
+
+static void sim_uartSetBaud(const OneWire *ow, OneWire_UartBaud baud)
+{
+	simUarts[ow->id].baud = baud;
+}
+
+static void sim_uartTransfer(const OneWire *ow, OneWire_Byte *data, OneWire_Size length)
+{
+	SimUart *uart = &simUarts[ow->id];
+	OneWire_Bool slow = uart->baud == OneWire_Baud_9600;
+
+	++uart->transfers;
+	if (length > uart->longestFrame)
+		uart->longestFrame = length;
+
+	// Start bit, 8 data bits and stop bit per character
+	uart->doneAt = simTime + (length * 10 * 1000000UL + (slow ? 9600 : 115200) - 1) / (slow ? 9600 : 115200);
+
+	for (OneWire_Size i = 0; i < length; ++i)
+	{
+		if (slow && data[i] == ONEWIRE_UART_RESET)
+		{
+			// Presence pulse follows the low half of the character and pulls the next data bit low
+			++uart->resetChars;
+			if (simBusReset(ow->id))
+				data[i] = 0xE0;
+		}
+		else if (!slow && (data[i] == ONEWIRE_UART_BIT_HIGH || data[i] == ONEWIRE_UART_BIT_LOW))
+		{
+			// Device driving 0 keeps the line low past the start bit
+			++uart->slotChars;
+			if (!simBusSlot(ow->id, data[i] == ONEWIRE_UART_BIT_HIGH))
+				data[i] &= 0xFC;
+		}
+		else
+			++uart->invalid;
+	}
+}
+
+static OneWire_Bool sim_uartTransferDone(const OneWire *ow)
+{
+	sim_tick();
+	return simTime >= simUarts[ow->id].doneAt;
+}
+
+#endif
+
+// OneWireMulti callbacks
+
+static void sim_setPort(const OneWireMulti *owm, OneWireMulti_Port low)
+{
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (owm->busMask & ((OneWireMulti_Port)1 << i))
+			sim_busPin(&simBuses[i], (low >> i) & 0x01, OneWire_False);
+	}
+}
+
+static OneWireMulti_Port sim_readPort(const OneWireMulti *owm)
+{
+	OneWireMulti_Port port = 0;
+
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (owm->busMask & ((OneWireMulti_Port)1 << i))
+			port |= (OneWireMulti_Port)sim_busRead(&simBuses[i]) << i;
+	}
+
+	return port;
+}
+
+static void sim_multiStartTimer(const OneWireMulti *owm)
+{
+	(void)owm;
+	sim_multiTimerBase = simTime;
+}
+
+static OneWire_Counter sim_multiReadTimer(const OneWireMulti *owm)
+{
+	(void)owm;
+	sim_tick();
+	return (OneWire_Counter)(simTime - sim_multiTimerBase);
+}
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+static void sim_scheduleTimer(const OneWire *ow, OneWire_Counter compare)
+{
+	// Compare value behind the counter matches only after the counter wraps, as on hardware
+	sim_compare[ow->id] = simTime + (OneWire_Counter)(compare - (OneWire_Counter)(simTime - sim_timerBase[ow->id]));
+	sim_compareArmed[ow->id] = OneWire_True;
+}
+#endif
+
+// Public functions
+
+void simReset(void)
+{
+	memset(simBuses, 0, sizeof(simBuses));
+	memset(sim_timerBase, 0, sizeof(sim_timerBase));
+	sim_multiTimerBase = 0;
+	simLatency = 0;
+	memset(simMocks, 0, sizeof(simMocks));
+#ifdef ONEWIRE_UART
+	memset(simUarts, 0, sizeof(simUarts));
+#endif
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	memset(sim_compareArmed, 0, sizeof(sim_compareArmed));
+#endif
+
+	// Close to 16-bit counter wrap, so that every test crosses it
+	simTime = 0xFF00;
+}
+
+OneWire_Bool simBusReset(int bus)
+{
+	SimBus *b = &simBuses[bus];
+
+	simSettle();
+	sim_busReset(b);
+	b->presencePending = OneWire_False;
+	return b->presence;
+}
+
+OneWire_Bool simBusSlot(int bus, OneWire_Bool bit)
+{
+	simSettle();
+	return sim_busSlot(&simBuses[bus], bit);
+}
+
+void simSetPinDir(OneWire_Id bus, OneWire_PinDirection dir)
+{
+	sim_busPin(&simBuses[bus], dir == OneWire_PinDir_Output, simBuses[bus].outputHigh);
+}
+
+void simSetPinState(OneWire_Id bus, OneWire_PinState state)
+{
+	sim_busPin(&simBuses[bus], simBuses[bus].output, state == OneWire_PinState_High);
+}
+
+OneWire_PinState simReadPin(OneWire_Id bus)
+{
+	return sim_busRead(&simBuses[bus]) ? OneWire_PinState_High : OneWire_PinState_Low;
+}
+
+void simStartTimer(OneWire_Id bus)
+{
+	++simBuses[bus].timerStarts;
+	sim_timerBase[bus] = simTime;
+}
+
+OneWire_Counter simReadTimer(OneWire_Id bus)
+{
+	sim_tick();
+	return (OneWire_Counter)(simTime - sim_timerBase[bus]);
+}
+
+SimDevice *simAddDevice(int bus, OneWire_Address rom, int16_t temperature)
+{
+	SimDevice *dev = &simBuses[bus].devices[simBuses[bus].count++];
+	OneWire_Byte bytes[7];
+
+	memset(dev, 0, sizeof(SimDevice));
+
+	for (int i = 0; i < 7; ++i)
+		bytes[i] = (rom >> (i * 8)) & 0xFF;
+	dev->rom = (rom & 0x00FFFFFFFFFFFFFFULL) | (OneWire_Address)sim_crc(bytes, 7) << 56;
+
+	const OneWire_Byte scratchpad[8] = { temperature & 0xFF, (temperature >> 8) & 0xFF, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10 };
+	memcpy(dev->scratchpad, scratchpad, 8);
+	memcpy(dev->eeprom, scratchpad + 2, 3);
+	sim_updateCrc(dev);
+
+	dev->temperature = temperature;
+	dev->present = OneWire_True;
+	dev->busyTime = 10000;
+	return dev;
+}
+
+void simSettle(void)
+{
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (simBuses[i].slotPending)
+		{
+			simBuses[i].slotPending = OneWire_False;
+			sim_busSlot(&simBuses[i], OneWire_True);
+		}
+	}
+}
+
+void simInitOneWire(OneWire *ow, int bus)
+{
+	memset(ow, 0, sizeof(OneWire));
+	onewireInit(ow, bus, sim_setPinDir, sim_setPinState, sim_readPin, sim_startTimer, sim_readTimer);
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	ow->scheduleTimer = sim_scheduleTimer;
+#endif
+}
+
+static OneWire_Bool sim_fire(OneWire *ow, unsigned long until)
+{
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	if (sim_compareArmed[ow->id] && sim_compare[ow->id] + simLatency <= until)
+	{
+		if (simTime < sim_compare[ow->id] + simLatency)
+			simTime = sim_compare[ow->id] + simLatency;
+
+		sim_compareArmed[ow->id] = OneWire_False;
+		onewireTimerInterrupt(ow);
+		return OneWire_True;
+	}
+#else
+	(void)ow;
+	(void)until;
+#endif
+
+	return OneWire_False;
+}
+
+static void sim_service(OneWire *ow)
+{
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	// Main loop waits for the interrupt, or keeps time going when nothing is scheduled
+	if (!sim_fire(ow, SIM_FOREVER))
+		sim_tick();
+#else
+	(void)ow;
+#endif
+}
+
+void simInitMulti(OneWireMulti *owm, OneWireMulti_Port busMask)
+{
+	memset(owm, 0, sizeof(OneWireMulti));
+	onewireMultiInit(owm, busMask, sim_setPort, sim_readPort, sim_multiStartTimer, sim_multiReadTimer);
+}
+
+void simInitMock(OneWire *ow, int bus, OneWire_Bool triplet)
+{
+	memset(ow, 0, sizeof(OneWire));
+#ifdef ONEWIRE_SEARCH
+	if (triplet)
+	{
+		onewireInitTransport(ow, bus, &sim_mockTripletTransport, 0, sim_startTimer, sim_readTimer);
+		return;
+	}
+#else
+	(void)triplet;
+#endif
+	onewireInitTransport(ow, bus, &sim_mockTransport, 0, sim_startTimer, sim_readTimer);
+}
+
+#ifdef ONEWIRE_UART
+void simInitUart(OneWire *ow, int bus)
+{
+	memset(ow, 0, sizeof(OneWire));
+	onewireInitUart(ow, bus, sim_uartSetBaud, sim_uartTransfer, sim_uartTransferDone, sim_startTimer, sim_readTimer);
+}
+#endif
+
+OneWire_Bool simInterrupt(OneWire *ow, unsigned long until)
+{
+	if (sim_fire(ow, until))
+		return OneWire_True;
+
+	if (simTime < until)
+		simTime = until;
+	return OneWire_False;
+}
+
+OneWire_Result simRun(OneWire *ow)
+{
+	OneWire_Result res;
+
+	do
+	{
+		sim_service(ow);
+		res = onewireProcess(ow);
+	} while (res == OneWire_Working);
+
+	return res;
+}
+
+void simRunDs18b20(DS18B20 *ds)
+{
+	for (;;)
+	{
+		sim_service(ds->oneWire);
+		if (ds18b20Process(ds) == DS18b20_State_Finished)
+			return;
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+		if (sim_compareArmed[ds->oneWire->id])
+			continue;
+#endif
+
+		// Sleep the way a main loop would, bit-banged slots are then stretched if reported time is too long
+		DS18B20_Time wait = ds18b20TimeToService(ds);
+		if (wait > 1 && wait != DS18B20_SERVICE_NONE)
+			simTime += wait - 1;
+	}
+}
+
+OneWire_Result simRunMulti(OneWireMulti *owm)
+{
+	OneWire_Result res;
+
+	do
+	{
+		res = onewireMultiProcess(owm);
+	} while (res == OneWire_Working);
+
+	return res;
+}
@@ -0,0 +1,248 @@
+#ifndef _h_sim
+#define _h_sim
+
+#include "onewire.h"
+#include "ds18b20.h"
+#include "onewire_multi.h"
+
+// Properties
+
+/** @def SIM_BUSES number of simulated buses, bus N is used by OneWire with id N */
+#define SIM_BUSES 32
+
+/** @def SIM_BUS_DEVICES maximum number of devices attached to a single bus */
+#define SIM_BUS_DEVICES 128
+
+/** @def SIM_FOREVER busy time of a device which never finishes its operation */
+#define SIM_FOREVER ((unsigned long)-1)
+
+// Definitions
+
+typedef enum SimDeviceState
+{
+	Sim_Device_Idle,				/**< Waiting for reset pulse */
+	Sim_Device_RomCommand,			/**< Receiving ROM command */
+	Sim_Device_Search,				/**< Taking part in search, every address bit is a triplet of slots */
+	Sim_Device_Match,				/**< Comparing address of match ROM command */
+	Sim_Device_Function,			/**< Receiving function command */
+	Sim_Device_Transmit,			/**< Sending bytes of `tx` */
+	Sim_Device_Receive,				/**< Receiving bytes into scratchpad */
+	Sim_Device_Busy,				/**< Read slots return 0 until `busyUntil` */
+	Sim_Device_PowerSupply			/**< Next read slot returns power supply mode */
+} SimDeviceState;
+
+/**
+ * @brief Simulated DS18B20 with its protocol state
+ */
+typedef struct SimDevice
+{
+	OneWire_Address rom;				/**< ROM code including CRC byte */
+	OneWire_Byte scratchpad[9];			/**< Scratchpad including CRC byte */
+	OneWire_Byte eeprom[3];				/**< TH, TL and configuration stored by copy scratchpad */
+	int16_t temperature;				/**< Raw temperature loaded into scratchpad by conversion */
+	OneWire_Bool present;				/**< Device is attached to the bus */
+	OneWire_Bool alarm;					/**< Device answers alarm search */
+	OneWire_Bool parasitic;				/**< Device reports parasitic power supply */
+	unsigned long busyTime;				/**< Duration of convert, copy and recall [us], SIM_FOREVER to never finish */
+
+	SimDeviceState state;				/**< Protocol state @see SimDeviceState */
+	SimDeviceState txNext;				/**< State entered once all bytes of `tx` are sent */
+	unsigned bit;						/**< Slot index within current state */
+	OneWire_Byte shift;					/**< Bits of byte being received */
+	OneWire_Size rxIndex;				/**< Number of scratchpad bytes received */
+	OneWire_Byte tx[9];					/**< Bytes being sent */
+	OneWire_Size txLength;				/**< Number of bytes being sent */
+	unsigned long busyUntil;			/**< Time at which current operation finishes [us] */
+} SimDevice;
+
+/**
+ * @brief Simulated bus line with attached devices. The line is low while the master pulls it low or a device drives 0
+ * in a time slot. Length of each master low pulse tells reset, write 0 and write 1 / read slots apart.
+ */
+typedef struct SimBus
+{
+	SimDevice devices[SIM_BUS_DEVICES];
+	int count;							/**< Number of attached devices */
+
+	OneWire_Bool output;				/**< Master drives the pin */
+	OneWire_Bool outputHigh;			/**< Driven pin is high - strong pullup */
+	OneWire_Bool low;					/**< Master pulls the line low */
+	unsigned long lowAt;				/**< Time of last falling edge [us] */
+	OneWire_Bool slotPending;			/**< Write 1 or read slot waits to be sampled */
+	OneWire_Bool presencePending;		/**< Reset pulse has ended, presence pulse not sampled yet */
+	OneWire_Bool presence;				/**< A device answered last reset */
+
+	unsigned long pullupAt;				/**< Time strong pullup was last enabled [us] */
+	unsigned long pullupTime;			/**< Duration of last strong pullup [us] */
+
+	unsigned long resetMin;				/**< Shortest reset pulse [us] */
+	unsigned long zeroMin;				/**< Shortest write 0 pulse [us] */
+	unsigned long zeroMax;				/**< Longest write 0 pulse [us] */
+	unsigned long oneMax;				/**< Longest write 1 or read slot pulse [us] */
+	unsigned long sampleMax;			/**< Longest time from falling edge of a read slot to the master sampling it [us] */
+
+	long slots;							/**< Number of time slots since last simReset */
+	long resets;						/**< Number of reset pulses since last simReset */
+	long timerStarts;					/**< Number of restarts of the bus timer counter since last simReset */
+} SimBus;
+
+#ifdef ONEWIRE_UART
+/**
+ * @brief Loopback UART of a bus - its TX and RX are tied to the bus line, so every character is echoed with the bits
+ * the devices pulled low. At 9600 baud 0xF0 is a reset pulse, at 115200 baud 0xFF and 0x00 are single time slots.
+ */
+typedef struct SimUart
+{
+	OneWire_UartBaud baud;				/**< Current baud rate */
+	unsigned long doneAt;				/**< Time the transfer in progress finishes [us] */
+	long transfers;						/**< Number of transfers since last simReset */
+	OneWire_Size longestFrame;			/**< Largest number of characters sent by a single transfer */
+	long resetChars;					/**< Number of reset characters sent at 9600 baud */
+	long slotChars;						/**< Number of time slot characters sent at 115200 baud */
+	long invalid;						/**< Number of characters which were neither a reset nor a time slot */
+} SimUart;
+#endif
+
+/**
+ * @brief Mock transport of a bus - moves whole blocks straight on the simulated bus, with triplet search
+ */
+typedef struct SimMock
+{
+	int pollCalls;						/**< Number of calls every operation reports OneWire_Working before it completes */
+	OneWire_Bool busy;					/**< Set while an operation is in progress */
+	int pending;						/**< Calls left until the operation in progress completes */
+	long resets;						/**< Number of completed reset operations since last simReset */
+	long writes;						/**< Number of completed write operations */
+	long reads;							/**< Number of completed read operations */
+	long triplets;						/**< Number of completed triplet operations */
+	long calls;							/**< Number of all transport calls, including those reporting OneWire_Working */
+} SimMock;
+
+// Simulation state
+
+extern SimBus simBuses[SIM_BUSES];
+extern unsigned long simTime;			/**< Simulated time [us], every timer read advances it by 1 us */
+extern unsigned long simLatency;		/**< Time from timer compare match to the interrupt being served [us] */
+extern SimMock simMocks[SIM_BUSES];
+#ifdef ONEWIRE_UART
+extern SimUart simUarts[SIM_BUSES];
+#endif
+
+// Public functions
+
+/**
+ * @brief Detach all devices, clear statistics and timers
+ */
+void simReset(void);
+
+/**
+ * @brief Attach a device to a bus, it behaves as DS18B20 whatever its family code
+ *
+ * @param bus bus index
+ * @param rom family code and serial number in the lowest 56 bits, CRC byte is added
+ * @param temperature raw temperature of the device
+ * @return attached device
+ */
+SimDevice *simAddDevice(int bus, OneWire_Address rom, int16_t temperature);
+
+/**
+ * @brief Sample pending time slot of every bus, e.g. before checking data received by devices
+ */
+void simSettle(void);
+
+/**
+ * @brief Reset pulse on a bus, for transports which do not drive the line through pin callbacks
+ *
+ * @param bus bus index
+ * @return OneWire_True when a device answered with presence pulse
+ */
+OneWire_Bool simBusReset(int bus);
+
+/**
+ * @brief Single time slot on a bus, for transports which do not drive the line through pin callbacks
+ *
+ * @param bus bus index
+ * @param bit OneWire_False for write 0, OneWire_True for write 1 or read slot
+ * @return state of the line sampled within the slot
+ */
+OneWire_Bool simBusSlot(int bus, OneWire_Bool bit);
+
+/**
+ * @brief Pin and timer primitives of a bus, called by OneWire callbacks or inlined through onewire_port.h
+ */
+void simSetPinDir(OneWire_Id bus, OneWire_PinDirection dir);
+void simSetPinState(OneWire_Id bus, OneWire_PinState state);
+OneWire_PinState simReadPin(OneWire_Id bus);
+void simStartTimer(OneWire_Id bus);
+OneWire_Counter simReadTimer(OneWire_Id bus);
+
+/**
+ * @brief Initialize OneWire bit-banging interface driving given simulated bus
+ *
+ * @param ow pointer to OneWire structure
+ * @param bus bus index
+ */
+void simInitOneWire(OneWire *ow, int bus);
+
+/**
+ * @brief Initialize OneWire interface working on mock transport of given simulated bus. Operations take the bus time
+ * of the time slots they perform, but complete within a single call unless `pollCalls` of the bus mock is set.
+ *
+ * @param ow pointer to OneWire structure
+ * @param bus bus index
+ * @param triplet OneWire_True to provide triplet operation, otherwise search uses read and write operations
+ */
+void simInitMock(OneWire *ow, int bus, OneWire_Bool triplet);
+
+#ifdef ONEWIRE_UART
+/**
+ * @brief Initialize OneWire UART interface working on loopback UART of given simulated bus
+ *
+ * @param ow pointer to OneWire structure
+ * @param bus bus index
+ */
+void simInitUart(OneWire *ow, int bus);
+#endif
+
+/**
+ * @brief Initialize multi-bus engine driving simulated buses of `busMask`, bus N being port bit N
+ *
+ * @param owm pointer to OneWireMulti structure
+ * @param busMask buses to drive
+ */
+void simInitMulti(OneWireMulti *owm, OneWireMulti_Port busMask);
+
+/**
+ * @brief Serve timer compare interrupt of a bus if it is due before given time, otherwise let the time pass.
+ * Without ONEWIRE_TIMER_INTERRUPT the time just passes.
+ *
+ * @param ow pointer to OneWire structure
+ * @param until time the caller waits for [us]
+ * @return OneWire_True when the interrupt was served
+ */
+OneWire_Bool simInterrupt(OneWire *ow, unsigned long until);
+
+/**
+ * @brief Process OneWire operation until it finishes, firing scheduled timer interrupts with ONEWIRE_TIMER_INTERRUPT
+ *
+ * @param ow pointer to OneWire structure
+ * @return operation result
+ */
+OneWire_Result simRun(OneWire *ow);
+
+/**
+ * @brief Process DS18B20 operation until it finishes, skipping idle time reported by ds18b20TimeToService
+ *
+ * @param ds pointer to DS18B20 structure
+ */
+void simRunDs18b20(DS18B20 *ds);
+
+/**
+ * @brief Process multi-bus operation until it finishes
+ *
+ * @param owm pointer to OneWireMulti structure
+ * @return operation result
+ */
+OneWire_Result simRunMulti(OneWireMulti *owm);
+
+#endif
@@ -0,0 +1,277 @@
+#include "sim_ds2482.h"
+
+#include <string.h>
+
+// Private definitions
+
+/** @def SIM_DS2482_REGISTER_CHANNEL read pointer code of DS2482-800 channel selection register */
+#define SIM_DS2482_REGISTER_CHANNEL 0xD2
+
+// Private data
+
+static const DS2482_Byte sim_channelCodes[DS2482_CHANNELS_800] = { 0xF0, 0xE1, 0xD2, 0xC3, 0xB4, 0xA5, 0x96, 0x87 };
+static const DS2482_Byte sim_channelReadCodes[DS2482_CHANNELS_800] = { 0xB8, 0xB1, 0xAA, 0xA3, 0x9C, 0x95, 0x8E, 0x87 };
+
+// Simulation state
+
+SimDs2482 simDs2482;
+
+// Private functions
+
+static int sim_ds2482Bus(void)
+{
+	return simDs2482.bus + simDs2482.channel;
+}
+
+static OneWire_Bool sim_ds2482Slot(OneWire_Bool bit)
+{
+	simDs2482.busyUntil += SIM_DS2482_SLOT_TIME;
+	return simBusSlot(sim_ds2482Bus(), bit);
+}
+
+static void sim_ds2482EndPullup(void)
+{
+	SimDs2482 *m = &simDs2482;
+
+	// Ending strong pullup clears SPU
+	if (m->pullup)
+	{
+		SimBus *bus = &simBuses[sim_ds2482Bus()];
+		bus->pullupTime = simTime - bus->pullupAt;
+		m->pullup = OneWire_False;
+		m->config &= ~DS2482_CONFIG_SPU;
+	}
+}
+
+static void sim_ds2482OneWire(DS2482_Byte command, DS2482_Byte param)
+{
+	SimDs2482 *m = &simDs2482;
+
+	if (simTime < m->busyUntil)
+	{
+		++m->busyCommands;
+		return;
+	}
+
+	sim_ds2482EndPullup();
+	m->pointer = DS2482_REGISTER_STATUS;
+	m->busyUntil = simTime;
+
+	switch(command)
+	{
+	case DS2482_1WIRE_RESET:
+		m->status &= ~(DS2482_STATUS_PPD | DS2482_STATUS_SD);
+		if (simBusReset(sim_ds2482Bus()))
+			m->status |= DS2482_STATUS_PPD;
+		m->busyUntil += SIM_DS2482_RESET_TIME;
+		return;
+
+	case DS2482_1WIRE_WRITE_BYTE:
+		for (int i = 0; i < 8; ++i)
+			sim_ds2482Slot((param >> i) & 0x01);
+		break;
+
+	case DS2482_1WIRE_READ_BYTE:
+		m->data = 0;
+		for (int i = 0; i < 8; ++i)
+			m->data |= sim_ds2482Slot(OneWire_True) << i;
+		break;
+
+	case DS2482_1WIRE_SINGLE_BIT:
+		m->status &= ~DS2482_STATUS_SBR;
+		if (sim_ds2482Slot((param & 0x80) != 0))
+			m->status |= DS2482_STATUS_SBR;
+		break;
+
+	case DS2482_1WIRE_TRIPLET:
+	{
+		OneWire_Bool bit = sim_ds2482Slot(OneWire_True);
+		OneWire_Bool complement = sim_ds2482Slot(OneWire_True);
+		// Direction byte decides only when both values are present, with no device answering 1 is written
+		OneWire_Bool direction = bit == complement ? (bit || (param & 0x80)) : bit;
+
+		sim_ds2482Slot(direction);
+		m->status &= ~(DS2482_STATUS_SBR | DS2482_STATUS_TSB | DS2482_STATUS_DIR);
+		m->status |= (bit ? DS2482_STATUS_SBR : 0) | (complement ? DS2482_STATUS_TSB : 0) | (direction ? DS2482_STATUS_DIR : 0);
+		return;
+	}
+	}
+
+	// Armed strong pullup takes over once the last slot of write, read or single bit command is done
+	if (m->config & DS2482_CONFIG_SPU)
+	{
+		m->pullup = OneWire_True;
+		simBuses[sim_ds2482Bus()].pullupAt = m->busyUntil;
+		++m->pullups;
+	}
+}
+
+static void sim_ds2482Command(const DS2482_Byte *data, DS2482_Size length)
+{
+	SimDs2482 *m = &simDs2482;
+	DS2482_Byte command = data[0];
+	DS2482_Byte param = length > 1 ? data[1] : 0;
+	OneWire_Bool hasParam = command != DS2482_DEVICE_RESET && command != DS2482_1WIRE_RESET && command != DS2482_1WIRE_READ_BYTE;
+
+	++m->commands[command];
+	if (length != (hasParam ? 2 : 1))
+	{
+		++m->invalid;
+		return;
+	}
+
+	switch(command)
+	{
+	case DS2482_DEVICE_RESET:
+		sim_ds2482EndPullup();
+		m->status = DS2482_STATUS_RST;
+		m->config = 0;
+		m->channel = 0;
+		m->pointer = DS2482_REGISTER_STATUS;
+		m->busyUntil = simTime;
+		return;
+
+	case DS2482_SET_READ_POINTER:
+		if (param == DS2482_REGISTER_STATUS || param == DS2482_REGISTER_DATA || param == DS2482_REGISTER_CONFIG ||
+				(param == SIM_DS2482_REGISTER_CHANNEL && m->channels > 1))
+			m->pointer = param;
+		else
+			++m->invalid;
+		return;
+
+	case DS2482_WRITE_CONFIG:
+		if ((param >> 4) != (~param & 0x0F))
+		{
+			++m->invalid;
+			return;
+		}
+		if (simTime < m->busyUntil)
+		{
+			++m->busyCommands;
+			return;
+		}
+		m->config = param & 0x0F;
+		m->status &= ~DS2482_STATUS_RST;
+		m->pointer = DS2482_REGISTER_CONFIG;
+		if (!(m->config & DS2482_CONFIG_SPU))
+			sim_ds2482EndPullup();
+		return;
+
+	case DS2482_CHANNEL_SELECT:
+		if (m->channels <= 1)
+			break;
+		for (DS2482_Byte i = 0; i < m->channels; ++i)
+		{
+			if (sim_channelCodes[i] == param)
+			{
+				sim_ds2482EndPullup();
+				m->channel = i;
+				m->pointer = SIM_DS2482_REGISTER_CHANNEL;
+				return;
+			}
+		}
+		break;
+
+	case DS2482_1WIRE_RESET:
+	case DS2482_1WIRE_WRITE_BYTE:
+	case DS2482_1WIRE_READ_BYTE:
+	case DS2482_1WIRE_SINGLE_BIT:
+	case DS2482_1WIRE_TRIPLET:
+		sim_ds2482OneWire(command, param);
+		return;
+	}
+
+	++m->invalid;
+}
+
+static OneWire_Bool sim_ds2482Begin(const DS2482 *bridge, DS2482_Size length)
+{
+	SimDs2482 *m = &simDs2482;
+
+	// Address byte is sent with every transfer
+	m->doneAt = simTime + (length + 1) * SIM_DS2482_I2C_BYTE;
+	m->result = OneWire_Success;
+	if (bridge->address != m->address || ++m->transfers == m->failTransfer)
+		m->result = OneWire_Failed;
+
+	return m->result == OneWire_Success;
+}
+
+// DS2482 callbacks
+
+static void sim_ds2482Write(const DS2482 *bridge, const DS2482_Byte *data, DS2482_Size length)
+{
+	if (sim_ds2482Begin(bridge, length))
+		sim_ds2482Command(data, length);
+}
+
+static void sim_ds2482Read(const DS2482 *bridge, DS2482_Byte *data, DS2482_Size length)
+{
+	SimDs2482 *m = &simDs2482;
+
+	if (!sim_ds2482Begin(bridge, length))
+		return;
+
+	for (DS2482_Size i = 0; i < length; ++i)
+	{
+		switch(m->pointer)
+		{
+		case DS2482_REGISTER_DATA: data[i] = m->data; break;
+		case DS2482_REGISTER_CONFIG: data[i] = m->config; break;
+		case SIM_DS2482_REGISTER_CHANNEL:
+			data[i] = m->channelReadCode ? m->channelReadCode : sim_channelReadCodes[m->channel];
+			break;
+		default: data[i] = simDs2482Status(); break;
+		}
+	}
+}
+
+static OneWire_Result sim_ds2482Done(const DS2482 *bridge)
+{
+	(void)bridge;
+
+	// Main loop polls about once per I2C byte
+	if (simTime < simDs2482.doneAt)
+	{
+		simTime += simTime + SIM_DS2482_I2C_BYTE < simDs2482.doneAt ? SIM_DS2482_I2C_BYTE : simDs2482.doneAt - simTime;
+		return OneWire_Working;
+	}
+
+	return simDs2482.result;
+}
+
+static void sim_ds2482StartTimer(const OneWire *ow)
+{
+	simStartTimer(ow->id);
+}
+
+static OneWire_Counter sim_ds2482ReadTimer(const OneWire *ow)
+{
+	return simReadTimer(ow->id);
+}
+
+// Public functions
+
+void simInitDs2482(DS2482 *bridge, DS2482_Byte channels, int bus)
+{
+	memset(&simDs2482, 0, sizeof(SimDs2482));
+	simDs2482.address = DS2482_ADDRESS;
+	simDs2482.channels = channels;
+	simDs2482.bus = bus;
+	simDs2482.status = DS2482_STATUS_RST;
+	simDs2482.pointer = DS2482_REGISTER_STATUS;
+
+	memset(bridge, 0, sizeof(DS2482));
+	ds2482Init(bridge, DS2482_ADDRESS, channels, sim_ds2482Write, sim_ds2482Read, sim_ds2482Done);
+}
+
+void simInitDs2482Channel(DS2482_Channel *channel, DS2482 *bridge, DS2482_Byte number, OneWire *ow)
+{
+	memset(ow, 0, sizeof(OneWire));
+	ds2482InitChannel(channel, bridge, number, ow, simDs2482.bus + number, sim_ds2482StartTimer, sim_ds2482ReadTimer);
+}
+
+DS2482_Byte simDs2482Status(void)
+{
+	return simDs2482.status | (simTime < simDs2482.busyUntil ? DS2482_STATUS_1WB : 0);
+}
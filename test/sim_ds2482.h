@@ -0,0 +1,81 @@
+#ifndef _h_sim_ds2482
+#define _h_sim_ds2482
+
+#include "sim.h"
+#include "ds2482.h"
+
+// Properties
+
+/** @def SIM_DS2482_I2C_BYTE time of a single I2C byte at 400 kHz, including acknowledge [us] */
+#define SIM_DS2482_I2C_BYTE 23
+
+/** @def SIM_DS2482_RESET_TIME time the bridge is busy with 1-Wire reset [us] */
+#define SIM_DS2482_RESET_TIME 1148
+
+/** @def SIM_DS2482_SLOT_TIME time the bridge is busy with a single 1-Wire time slot [us] */
+#define SIM_DS2482_SLOT_TIME 73
+
+// Definitions
+
+/**
+ * @brief Register-level model of DS2482-100/800 bridge. Every channel drives a simulated bus, channel N being bus
+ * `bus + N`. 1-Wire commands act on the bus at once and keep 1WB set for the time real slots would take, so the
+ * driver has to poll status. Strong pullup is tracked in `pullupAt` and `pullupTime` of the bus it is applied on.
+ */
+typedef struct SimDs2482
+{
+	DS2482_Byte address;				/**< 7-bit I2C address the model answers to */
+	DS2482_Byte channels;				/**< Number of channels, DS2482_CHANNELS_100 or DS2482_CHANNELS_800 */
+	int bus;							/**< Simulated bus of channel 0 */
+
+	DS2482_Byte status;					/**< Status register, without 1WB which is computed from `busyUntil` */
+	DS2482_Byte config;					/**< Configuration register, lower nibble only */
+	DS2482_Byte data;					/**< Read data register */
+	DS2482_Byte pointer;				/**< Register read by I2C reads, one of DS2482_REGISTER_* or channel selection */
+	DS2482_Byte channel;				/**< Selected channel */
+	unsigned long busyUntil;			/**< Time the 1-Wire command in progress finishes [us] */
+	OneWire_Bool pullup;				/**< Strong pullup is applied on the selected channel */
+
+	unsigned long doneAt;				/**< Time the I2C transfer in progress finishes [us] */
+	OneWire_Result result;				/**< Result of the I2C transfer in progress */
+	long failTransfer;					/**< Transfer number (counting from 1) which is not acknowledged, 0 for none */
+	DS2482_Byte channelReadCode;		/**< When nonzero, returned instead of the code of selected channel */
+
+	long transfers;						/**< Number of I2C transfers */
+	long commands[256];					/**< Number of received commands, by command code */
+	long busyCommands;					/**< Number of 1-Wire commands received while 1WB was set, which are ignored */
+	long invalid;						/**< Number of malformed commands, which are ignored */
+	long pullups;						/**< Number of strong pullups applied */
+} SimDs2482;
+
+// Simulation state
+
+extern SimDs2482 simDs2482;
+
+// Public functions
+
+/**
+ * @brief Power up the bridge model and initialize DS2482 driver structure talking to it
+ *
+ * @param bridge pointer to DS2482 structure
+ * @param channels number of bridge channels, DS2482_CHANNELS_100 or DS2482_CHANNELS_800
+ * @param bus simulated bus of channel 0
+ */
+void simInitDs2482(DS2482 *bridge, DS2482_Byte channels, int bus);
+
+/**
+ * @brief Initialize OneWire interface working on a channel of the bridge model, its id is the simulated bus of the channel
+ *
+ * @param channel pointer to DS2482_Channel structure
+ * @param bridge pointer to DS2482 structure initialized by simInitDs2482
+ * @param number channel number
+ * @param ow pointer to OneWire structure
+ */
+void simInitDs2482Channel(DS2482_Channel *channel, DS2482 *bridge, DS2482_Byte number, OneWire *ow);
+
+/**
+ * @brief Bridge status register as it would be read now, including 1WB
+ */
+DS2482_Byte simDs2482Status(void);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _h_test
+#define _h_test
+
+#include <stdio.h>
+
+// Definitions
+
+/** @def TEST_CHECK report a failed condition and carry on with the test */
+#define TEST_CHECK(cond) testCheck((cond) != 0, #cond, __FILE__, __LINE__)
+
+/** @def TEST_RUN run a test function and report its name */
+#define TEST_RUN(fn) testRun(fn, #fn)
+
+// Test state
+
+static int test_checks;
+static int test_failures;
+
+// Public functions
+
+static inline void testCheck(int passed, const char *cond, const char *file, int line)
+{
+	++test_checks;
+	if (!passed)
+	{
+		++test_failures;
+		printf("%s:%d: check failed: %s\n", file, line, cond);
+	}
+}
+
+static inline void testRun(void (*fn)(void), const char *name)
+{
+	int failures = test_failures;
+
+	fn();
+	printf("%-40s %s\n", name, test_failures == failures ? "ok" : "FAILED");
+}
+
+/**
+ * @brief Print summary and get process exit code
+ *
+ * @return 0 when every check passed, 1 otherwise
+ */
+static inline int testSummary(void)
+{
+	printf("%d checks, %d failed\n", test_checks, test_failures);
+	return test_failures != 0;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#include "onewire_batch.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def RECORDS largest number of records per check */
+#define RECORDS 70
+
+static const char *const onewireKernels[] = { "scalar", "ssse3", "avx2", "neon" };
+
+// Private functions
+
+/**
+ * @brief Fill records with random bytes, 3 of 4 records end with a valid CRC
+ */
+static void fillRecords(OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		OneWire_Byte *record = records + i * stride;
+		for (size_t b = 0; b < stride; ++b)
+			record[b] = rand() & 0xFF;
+		if (rand() % 4)
+			record[length - 1] = onewireCrc(record, length);
+	}
+}
+
+static int bitmapMatches(const OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count, const OneWire_Byte *bitmap)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		const OneWire_Byte *record = records + i * stride;
+		int valid = onewireCrc(record, length) == record[length - 1];
+		if (((bitmap[i >> 3] >> (i & 0x07)) & 0x01) != valid)
+			return 0;
+	}
+
+	// Bits past the last record are cleared
+	return !(count & 0x07) || !(bitmap[count >> 3] >> (count & 0x07));
+}
+
+// Tests
+
+static void testBatchCrc(void)
+{
+	srand(25);
+
+	for (int k = 0; k < 4; ++k)
+	{
+		if (!onewireBatchSelect(k))
+		{
+			printf("  onewire %s kernel not available\n", onewireKernels[k]);
+			continue;
+		}
+		TEST_CHECK(onewireBatchKernel() == (OneWire_BatchKernel)k);
+
+		for (OneWire_Size length = 1; length <= 20; ++length)
+		{
+			const size_t strides[] = { length, length + 3u, 16 };
+
+			for (int s = 0; s < 3; ++s)
+			{
+				size_t stride = strides[s] < length ? length : strides[s];
+
+				for (size_t count = 0; count <= RECORDS; ++count)
+				{
+					// Exact sizes, so that reads past the last record and writes past the bitmap are caught by sanitizers
+					size_t size = count ? (count - 1) * stride + length : 1;
+					OneWire_Byte *records = malloc(size);
+					OneWire_Byte *bitmap = malloc((count + 7) / 8 + 1);
+
+					for (size_t i = 0; i < count; ++i)
+					{
+						OneWire_Byte record[32];
+						fillRecords(record, length, length, 1);
+						memcpy(records + i * stride, record, length);
+					}
+					memset(bitmap, 0xA5, (count + 7) / 8 + 1);
+
+					onewireBatchCrc(records, stride, length, count, bitmap);
+					TEST_CHECK(bitmapMatches(records, stride, length, count, bitmap));
+					TEST_CHECK(bitmap[(count + 7) / 8] == 0xA5);
+
+					free(records);
+					free(bitmap);
+				}
+			}
+		}
+	}
+
+	onewireBatchSelect(OneWire_Batch_Scalar);
+}
+
+int main(void)
+{
+	TEST_RUN(testBatchCrc);
+
+	return testSummary();
+}
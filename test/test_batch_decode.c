@@ -0,0 +1,127 @@
+#include "ds18b20_batch.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def SCRATCHPADS scratchpads of the random dump */
+#define SCRATCHPADS 1000
+
+static const char *const ds18b20Kernels[] = { "scalar", "sse2", "avx2", "neon" };
+
+// Private functions
+
+/**
+ * @brief Fill records with random bytes, 3 of 4 records end with a valid CRC
+ */
+static void fillRecords(OneWire_Byte *records, size_t stride, OneWire_Size length, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		OneWire_Byte *record = records + i * stride;
+		for (size_t b = 0; b < stride; ++b)
+			record[b] = rand() & 0xFF;
+		if (rand() % 4)
+			record[length - 1] = onewireCrc(record, length);
+	}
+}
+
+// Tests
+
+static void testBatchDecode(void)
+{
+	static const DS18B20Resolution resolutions[] = { DS18B20_Resolution_9, DS18B20_Resolution_10, DS18B20_Resolution_11, DS18B20_Resolution_12 };
+	DS18B20_Byte *scratchpads = malloc(SCRATCHPADS * DS18B20_SCRATCHPAD_SIZE);
+	int32_t *milli = malloc(SCRATCHPADS * sizeof(int32_t));
+	DS18B20_Bool *crcValid = malloc(SCRATCHPADS);
+	DS18B20_Byte *resolution = malloc(SCRATCHPADS);
+	DS18B20_Byte *userByte1 = malloc(SCRATCHPADS);
+	DS18B20_Byte *userByte2 = malloc(SCRATCHPADS);
+
+	srand(24);
+	fillRecords(scratchpads, DS18B20_SCRATCHPAD_SIZE, DS18B20_SCRATCHPAD_SIZE, SCRATCHPADS);
+	for (size_t i = 0; i < SCRATCHPADS; ++i)
+	{
+		DS18B20_Byte *sp = scratchpads + i * DS18B20_SCRATCHPAD_SIZE;
+		sp[4] = resolutions[rand() & 0x03];
+		if (rand() % 4)
+			sp[8] = onewireCrc(sp, DS18B20_SCRATCHPAD_SIZE);
+	}
+
+	for (int k = 0; k < 4; ++k)
+	{
+		if (!ds18b20BatchSelect(k))
+		{
+			printf("  ds18b20 %s kernel not available\n", ds18b20Kernels[k]);
+			continue;
+		}
+		TEST_CHECK(ds18b20BatchKernel() == (DS18B20_BatchKernel)k);
+
+		// Odd counts and offsets exercise partial vector steps
+		for (size_t count = 0; count <= 70; ++count)
+		{
+			const DS18B20_Byte *base = scratchpads + (count % 5) * DS18B20_SCRATCHPAD_SIZE;
+			DS18B20_BatchOutput out = { milli, crcValid, resolution, userByte1, userByte2 };
+			int exact = 1;
+
+			ds18b20BatchDecode(base, DS18B20_SCRATCHPAD_SIZE, count, &out);
+			for (size_t i = 0; i < count; ++i)
+			{
+				const DS18B20_Byte *sp = base + i * DS18B20_SCRATCHPAD_SIZE;
+				int16_t raw = ds18b20MaskRaw((int16_t)(sp[0] | (sp[1] << 8)), sp[4]);
+
+				exact &= milli[i] == ds18b20RawToMilli(raw);
+				exact &= crcValid[i] == (onewireCrc(sp, DS18B20_SCRATCHPAD_SIZE) == sp[8]);
+				exact &= resolution[i] == 9 + ((sp[4] >> 5) & 0x03);
+				exact &= userByte1[i] == sp[2] && userByte2[i] == sp[3];
+			}
+			TEST_CHECK(exact);
+		}
+
+		// Whole dump, temperatures only
+		DS18B20_BatchOutput temperatures = { milli, 0, 0, 0, 0 };
+		int exact = 1;
+		ds18b20BatchDecode(scratchpads, DS18B20_SCRATCHPAD_SIZE, SCRATCHPADS, &temperatures);
+		for (size_t i = 0; i < SCRATCHPADS; ++i)
+		{
+			const DS18B20_Byte *sp = scratchpads + i * DS18B20_SCRATCHPAD_SIZE;
+			exact &= milli[i] == ds18b20RawToMilli(ds18b20MaskRaw((int16_t)(sp[0] | (sp[1] << 8)), sp[4]));
+		}
+		TEST_CHECK(exact);
+
+		// Buffers of a driver array
+		DS18B20 drivers[40];
+		memset(drivers, 0, sizeof(drivers));
+		for (int i = 0; i < 40; ++i)
+			memcpy(drivers[i].buffer, scratchpads + i * DS18B20_SCRATCHPAD_SIZE, DS18B20_SCRATCHPAD_SIZE);
+
+		DS18B20_BatchOutput strided = { milli, crcValid, 0, 0, 0 };
+		exact = 1;
+		ds18b20BatchDecode(drivers[0].buffer, sizeof(DS18B20), 40, &strided);
+		for (int i = 0; i < 40; ++i)
+		{
+			const DS18B20_Byte *sp = drivers[i].buffer;
+			exact &= milli[i] == ds18b20RawToMilli(ds18b20MaskRaw((int16_t)(sp[0] | (sp[1] << 8)), sp[4]));
+			exact &= crcValid[i] == (onewireCrc(sp, DS18B20_SCRATCHPAD_SIZE) == sp[8]);
+		}
+		TEST_CHECK(exact);
+	}
+
+	ds18b20BatchSelect(DS18B20_Batch_Scalar);
+
+	free(scratchpads);
+	free(milli);
+	free(crcValid);
+	free(resolution);
+	free(userByte1);
+	free(userByte2);
+}
+
+int main(void)
+{
+	TEST_RUN(testBatchDecode);
+
+	return testSummary();
+}
@@ -0,0 +1,208 @@
+#include "sim.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def DRIVERS number of DS18B20 drivers processed by the same main loop */
+#define DRIVERS 8
+
+/** @def TRANSACTION_TIME mock bus time of a reset followed by 10 bytes, longest transaction of the tests [us] */
+#define TRANSACTION_TIME (960 + 10 * 8 * 70)
+
+/** @def MARGIN time a delay may overrun - mock transport takes its bus time at once, so all drivers may transact first [us] */
+#define MARGIN ((DRIVERS + 1) * TRANSACTION_TIME)
+
+// Private variables
+
+static OneWire ows[DRIVERS];
+static DS18B20 dss[DRIVERS];
+static SimDevice *devs[DRIVERS];
+static OneWire_Bool pending[DRIVERS];
+static unsigned long startAt[DRIVERS];
+static unsigned long doneAt[DRIVERS];
+static unsigned long serviceAt[DRIVERS];
+
+static const DS18B20Resolution resolutions[] = {
+	DS18B20_Resolution_9, DS18B20_Resolution_10, DS18B20_Resolution_11, DS18B20_Resolution_12
+};
+
+// Private functions
+
+/**
+ * @brief Set up drivers, driver i uses bus i % buses and owns sensor i on that bus. Buses run the mock transport, whose
+ * operations take a few process calls each - bit-banged buses in lockstep would stretch each other's slots instead.
+ */
+static void setup(int buses)
+{
+	simReset();
+	for (int i = 0; i < buses; ++i)
+	{
+		simInitMock(&ows[i], i, OneWire_False);
+		simMocks[i].pollCalls = 2;
+	}
+
+	for (int i = 0; i < DRIVERS; ++i)
+	{
+		memset(&dss[i], 0, sizeof(DS18B20));
+		ds18b20Init(&dss[i], &ows[i % buses]);
+		dss[i].readMode = DS18b20_Read_CRC;
+		dss[i].resolution = resolutions[i % 4];
+		devs[i] = simAddDevice(i % buses, 0x0000AABBCCDD0028ULL | ((OneWire_Address)(i + 1) << 8), (int16_t)(0x0100 + i * 0x10));
+		pending[i] = OneWire_False;
+	}
+}
+
+static void begin(int i, DS18B20Result result)
+{
+	TEST_CHECK(result == DS18B20_Result_Ok);
+	pending[i] = OneWire_True;
+	startAt[i] = simTime;
+	serviceAt[i] = simTime;
+}
+
+/**
+ * @brief One main loop pass - the driver due first is processed, the loop sleeps until then the way
+ * ds18b20TimeToService allows, so bit-banged slots of the other buses are not stretched
+ */
+static void step(void)
+{
+	int next = -1;
+
+	for (int i = 0; i < DRIVERS; ++i)
+		if (pending[i] && (next < 0 || serviceAt[i] < serviceAt[next]))
+			next = i;
+	if (next < 0)
+		return;
+
+	if (serviceAt[next] > simTime)
+		simTime = serviceAt[next];
+
+	if (ds18b20Process(&dss[next]) == DS18b20_State_Finished)
+	{
+		pending[next] = OneWire_False;
+		doneAt[next] = simTime;
+		return;
+	}
+
+	DS18B20_Time wait = ds18b20TimeToService(&dss[next]);
+	serviceAt[next] = simTime + (wait > 1 && wait != DS18B20_SERVICE_NONE ? wait - 1 : 0);
+}
+
+static void runUntil(int i)
+{
+	while (pending[i])
+		step();
+}
+
+static void runAll(void)
+{
+	for (int i = 0; i < DRIVERS; ++i)
+		runUntil(i);
+}
+
+static void checkReading(int i)
+{
+	TEST_CHECK(dss[i].error == DS18b20_Success);
+	TEST_CHECK(ds18b20VerifyCrc(&dss[i]));
+	TEST_CHECK(ds18b20GetTemperatureRaw(&dss[i]) == (int16_t)(0x0100 + i * 0x10));
+}
+
+// Tests
+
+static void testSeparateBuses(void)
+{
+	unsigned long overrun = 0;
+
+	// Every driver waits for a conversion of different length while the others run their transactions
+	setup(DRIVERS);
+	for (int i = 0; i < DRIVERS; ++i)
+	{
+		dss[i].convertMode = DS18b20_ConvertMode_Wait;
+		begin(i, ds18b20BeginConversion(&dss[i], devs[i]->rom));
+	}
+	runAll();
+
+	for (int i = 0; i < DRIVERS; ++i)
+	{
+		DS18B20_Time expected = ds18b20GetConversionTime(dss[i].resolution);
+		unsigned long took = doneAt[i] - startAt[i];
+
+		TEST_CHECK(dss[i].error == DS18b20_Success);
+		TEST_CHECK(took >= expected && took < expected + MARGIN);
+		if (took - expected > overrun)
+			overrun = took - expected;
+	}
+	printf("  %d drivers on %d buses: conversion waits overrun by at most %lu us\n", DRIVERS, DRIVERS, overrun);
+
+	// Polled conversions of different length, read as soon as each one finishes
+	for (int i = 0; i < DRIVERS; ++i)
+	{
+		devs[i]->busyTime = ds18b20GetConversionTime(dss[i].resolution) / 2 + i * 5000;
+		dss[i].convertMode = DS18b20_ConvertMode_Poll;
+		begin(i, ds18b20BeginConversion(&dss[i], devs[i]->rom));
+	}
+	runAll();
+
+	for (int i = 0; i < DRIVERS; ++i)
+	{
+		unsigned long took = doneAt[i] - startAt[i];
+		TEST_CHECK(took >= devs[i]->busyTime && took < devs[i]->busyTime + dss[i].convertPollInterval + MARGIN);
+		begin(i, ds18b20ReadScratchpad(&dss[i], devs[i]->rom));
+	}
+	runAll();
+
+	for (int i = 0; i < DRIVERS; ++i)
+		checkReading(i);
+}
+
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+
+static void testSharedBus(void)
+{
+	// Driver 0 waits for the longest conversion, the others convert and read their sensors on the same bus meanwhile.
+	// Drivers share the interface, so only one of them may run a transaction at a time.
+	setup(1);
+	dss[0].resolution = DS18B20_Resolution_12;
+	dss[0].convertMode = DS18b20_ConvertMode_Wait;
+	begin(0, ds18b20BeginConversion(&dss[0], devs[0]->rom));
+	while (dss[0].convertState != DS18b20_Convert_Delay)
+		step();
+
+	for (int i = 1; i < DRIVERS; ++i)
+	{
+		dss[i].resolution = DS18B20_Resolution_9;
+		dss[i].convertMode = DS18b20_ConvertMode_Wait;
+		begin(i, ds18b20BeginConversion(&dss[i], devs[i]->rom));
+		runUntil(i);
+		TEST_CHECK(doneAt[i] - startAt[i] >= DS18B20_WAIT_RES9 && doneAt[i] - startAt[i] < DS18B20_WAIT_RES9 + MARGIN);
+
+		begin(i, ds18b20ReadScratchpad(&dss[i], devs[i]->rom));
+		runUntil(i);
+		checkReading(i);
+	}
+	TEST_CHECK(pending[0]);
+	runUntil(0);
+
+	unsigned long took = doneAt[0] - startAt[0];
+	TEST_CHECK(took >= DS18B20_WAIT_RES12 && took < DS18B20_WAIT_RES12 + MARGIN);
+
+	begin(0, ds18b20ReadScratchpad(&dss[0], devs[0]->rom));
+	runUntil(0);
+	checkReading(0);
+	TEST_CHECK(simBuses[0].timerStarts == 0);
+}
+
+#endif
+
+int main(void)
+{
+	TEST_RUN(testSeparateBuses);
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	TEST_RUN(testSharedBus);
+#endif
+
+	return testSummary();
+}
@@ -0,0 +1,131 @@
+#include "onewire.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+// Private definitions
+
+#if ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_FULL
+#define CRC_VARIANT "full table"
+#elif ONEWIRE_CRC_LOOKUP_TABLE == ONEWIRE_CRC_TABLE_NIBBLE
+#define CRC_VARIANT "nibble tables"
+#else
+#define CRC_VARIANT "bitwise"
+#endif
+
+// Private functions
+
+static OneWire_Byte referenceCrc(const OneWire_Byte *data, int length)
+{
+	OneWire_Byte crc = 0;
+
+	// Polynomial division written out as the shift register of the datasheet, x^8 + x^5 + x^4 + 1
+	for (int i = 0; i < length; ++i)
+	{
+		for (int b = 0; b < 8; ++b)
+		{
+			OneWire_Byte feedback = (crc ^ (data[i] >> b)) & 0x01;
+			crc >>= 1;
+			if (feedback)
+				crc ^= 0x80 | 0x08 | 0x04;
+		}
+	}
+
+	return crc;
+}
+
+// Tests
+
+static void testKnownCodes(void)
+{
+	// ROM and power-on scratchpad from the datasheets, last byte is CRC of the others
+	const OneWire_Byte rom[8] = { 0x02, 0x1C, 0xB8, 0x01, 0x00, 0x00, 0x00, 0xA2 };
+	const OneWire_Byte scratchpad[9] = { 0x50, 0x05, 0x4B, 0x46, 0x7F, 0xFF, 0x0C, 0x10, 0x1C };
+
+	TEST_CHECK(onewireCrc(rom, 8) == 0xA2);
+	TEST_CHECK(onewireCrc(scratchpad, 9) == 0x1C);
+
+	// Data followed by its CRC has zero CRC
+	TEST_CHECK(referenceCrc(rom, 8) == 0);
+	TEST_CHECK(referenceCrc(scratchpad, 9) == 0);
+}
+
+static void testAllBytes(void)
+{
+	OneWire_Byte data[2] = { 0, 0 };
+	int exact = 1;
+
+	// Every table entry is hit by a single byte
+	for (int b = 0; b < 256; ++b)
+	{
+		data[0] = b;
+		exact &= onewireCrc(data, 2) == referenceCrc(data, 1);
+	}
+	TEST_CHECK(exact);
+
+	// Every pair, covers each entry after every possible CRC state
+	OneWire_Byte pair[3] = { 0, 0, 0 };
+	exact = 1;
+	for (int a = 0; a < 256; ++a)
+	{
+		for (int b = 0; b < 256; ++b)
+		{
+			pair[0] = a;
+			pair[1] = b;
+			exact &= onewireCrc(pair, 3) == referenceCrc(pair, 2);
+		}
+	}
+	TEST_CHECK(exact);
+}
+
+static void testRandom(void)
+{
+	OneWire_Byte data[64];
+	int exact = 1;
+
+	srand(1);
+	for (int run = 0; run < 100000; ++run)
+	{
+		int length = 1 + rand() % 64;
+		for (int i = 0; i < length; ++i)
+			data[i] = rand() & 0xFF;
+
+		exact &= onewireCrc(data, length) == referenceCrc(data, length - 1);
+	}
+	TEST_CHECK(exact);
+}
+
+static void testCrcBit(void)
+{
+	OneWire_Byte data[9];
+	int exact = 1;
+
+	// Running CRC of the read path gives the same result as the byte-wise one
+	srand(2);
+	for (int run = 0; run < 10000; ++run)
+	{
+		OneWire_Byte crc = 0;
+		for (int i = 0; i < 9; ++i)
+		{
+			data[i] = rand() & 0xFF;
+			for (int b = 0; b < 8; ++b)
+				crc = onewireCrcBit(crc, (data[i] >> b) & 0x01);
+		}
+
+		exact &= crc == referenceCrc(data, 9);
+		exact &= onewireCrc(data, 9) == referenceCrc(data, 8);
+	}
+	TEST_CHECK(exact);
+}
+
+int main(void)
+{
+	printf("CRC variant: %s\n", CRC_VARIANT);
+
+	TEST_RUN(testKnownCodes);
+	TEST_RUN(testAllBytes);
+	TEST_RUN(testRandom);
+	TEST_RUN(testCrcBit);
+
+	return testSummary();
+}
@@ -0,0 +1,283 @@
+#include "sim.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+
+static DS18B20CallbackFlags lastFlags;
+
+// Private functions
+
+static void onFinished(DS18B20 *d, DS18b20State operation, DS18B20_Address address, DS18B20CallbackFlags flags)
+{
+	(void)d;
+	(void)operation;
+	(void)address;
+	lastFlags = flags;
+}
+
+static void setup(void)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+}
+
+static unsigned long convert(DS18b20ConvertMode mode)
+{
+	unsigned long start = simTime;
+
+	ds.convertMode = mode;
+	TEST_CHECK(ds18b20BeginConversion(&ds, DS18B20_ROM_NONE) == DS18B20_Result_Ok);
+	TEST_CHECK(ds18b20BeginConversion(&ds, DS18B20_ROM_NONE) == DS18B20_Result_Busy);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(ds18b20TimeToService(&ds) == DS18B20_SERVICE_NONE);
+	return simTime - start;
+}
+
+// Tests
+
+static void testReadScratchpad(void)
+{
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000AABBCCDDEE28ULL, (int16_t)0xFF5E);
+	simAddDevice(0, 0x0000112233445528ULL, 0x0191);
+
+	TEST_CHECK(ds18b20ReadScratchpad(&ds, dev->rom) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds18b20VerifyCrc(&ds));
+	TEST_CHECK(memcmp(ds.buffer, dev->scratchpad, 9) == 0);
+	TEST_CHECK(ds18b20GetTemperatureRaw(&ds) == (int16_t)0xFF5E);
+	TEST_CHECK(ds18b20GetTemperatureMilli(&ds) == -10125);
+
+	// Damaged byte is caught by CRC computed while reading
+	dev->scratchpad[4] ^= 0x10;
+	ds18b20ReadScratchpad(&ds, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(!ds18b20VerifyCrc(&ds));
+	TEST_CHECK(ds.error == DS18b20_Error_CRC);
+	dev->scratchpad[4] ^= 0x10;
+
+	// Temperature only, CRC is not read and not checked
+	ds.readMode = DS18b20_Read_Temperature;
+	ds18b20ReadScratchpad(&ds, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(ds18b20GetTemperatureRaw(&ds) == (int16_t)0xFF5E);
+	ds.readMode = DS18b20_Read_CRC;
+
+	// Nothing answers
+	simBuses[0].devices[1].present = OneWire_False;
+	dev->present = OneWire_False;
+	ds18b20ReadScratchpad(&ds, DS18B20_ROM_NONE);
+	simRunDs18b20(&ds);
+	TEST_CHECK(!ds18b20VerifyCrc(&ds));
+	TEST_CHECK(ds.error == DS18b20_Error);
+}
+
+static void testReadRom(void)
+{
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000000203040528ULL, 0);
+
+	ds18b20RequestReadRom(&ds);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	for (int i = 0; i < 8; ++i)
+		TEST_CHECK(ds.buffer[i] == ((dev->rom >> (i * 8)) & 0xFF));
+	TEST_CHECK(ds18b20CheckAuthentic(dev->rom));
+}
+
+static void testConvert(void)
+{
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000AABBCCDDEE28ULL, 0x0550);
+	dev->busyTime = 150000;
+
+	// Waiting takes worst-case time of configured resolution
+	unsigned long wait = convert(DS18b20_ConvertMode_Wait);
+	TEST_CHECK(wait >= DS18B20_WAIT_RES12 && wait < DS18B20_WAIT_RES12 + 5000);
+
+	// Polling ends with the first poll after the sensor has finished
+	unsigned long poll = convert(DS18b20_ConvertMode_Poll);
+	TEST_CHECK(poll >= 150000 && poll < 150000 + DS18B20_CONVERT_POLL_INTERVAL + 5000);
+
+	ds.resolution = DS18B20_Resolution_9;
+	wait = convert(DS18b20_ConvertMode_Wait);
+	TEST_CHECK(wait >= DS18B20_WAIT_RES9 && wait < DS18B20_WAIT_RES9 + 5000);
+
+	// Sensor which never finishes is given worst-case time
+	dev->busyTime = SIM_FOREVER;
+	poll = convert(DS18b20_ConvertMode_Poll);
+	TEST_CHECK(poll >= DS18B20_WAIT_RES9 && poll < DS18B20_WAIT_RES9 + DS18B20_CONVERT_POLL_INTERVAL + 5000);
+
+	ds18b20ReadScratchpad(&ds, DS18B20_ROM_NONE);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds18b20VerifyCrc(&ds));
+	TEST_CHECK(ds18b20GetTemperatureMilli(&ds) == 85000);
+}
+
+static void testConvertRandom(void)
+{
+	unsigned long worst = 0;
+
+	setup();
+	srand(14);
+	ds.convertPollInterval = 5000;
+
+	// Read slots return 1 only once every sensor converting after skip ROM has finished
+	for (int run = 0; run < 20; ++run)
+	{
+		unsigned long slowest = 0;
+
+		simBuses[0].count = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			SimDevice *dev = simAddDevice(0, 0x0000000000000028ULL | ((OneWire_Address)(run * 4 + i + 1) << 8), 0x0191);
+			dev->busyTime = 300000 + rand() % 450001;
+			if (dev->busyTime > slowest)
+				slowest = dev->busyTime;
+		}
+
+		unsigned long poll = convert(DS18b20_ConvertMode_Poll);
+		TEST_CHECK(poll >= slowest && poll < slowest + ds.convertPollInterval + 5000);
+		if (poll - slowest > worst)
+			worst = poll - slowest;
+	}
+	printf("  random 300-750 ms conversions: finished at most %lu us after the slowest sensor, %d us in wait mode\n",
+		worst, DS18B20_WAIT_RES12);
+}
+
+static void testSample(void)
+{
+	OneWire_Address roms[8];
+	OneWire_RomTable table;
+	DS18B20_Reading readings[8];
+
+	setup();
+	for (int i = 0; i < 6; ++i)
+		simAddDevice(0, 0x0000A00000000028ULL | (OneWire_Address)i << 12, (int16_t)(i * 100 - 200));
+
+	onewireRomTableInit(&table, roms, 8);
+	onewireSearchTable(&ow, &table, OneWire_False, DS18B20_FAMILY_CODE);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(table.count == 6);
+
+	// Device removed after enumeration reports an error
+	simBuses[0].devices[2].present = OneWire_False;
+
+	// One conversion time for the whole table, reads follow back to back
+	unsigned long start = simTime;
+	TEST_CHECK(ds18b20Sample(&ds, &table, readings) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(simTime - start < DS18B20_WAIT_RES12 + 6 * 12000);
+
+	for (int i = 0; i < table.count; ++i)
+	{
+		for (int d = 0; d < simBuses[0].count; ++d)
+		{
+			const SimDevice *dev = &simBuses[0].devices[d];
+			if (dev->rom != table.roms[i])
+				continue;
+
+			if (!dev->present)
+				TEST_CHECK(readings[i].error == DS18b20_Error_CRC);
+			else
+			{
+				TEST_CHECK(readings[i].error == DS18b20_Success);
+				TEST_CHECK(readings[i].raw == dev->temperature);
+			}
+		}
+	}
+
+	// Empty table finishes right away
+	table.count = 0;
+	TEST_CHECK(ds18b20Sample(&ds, &table, readings) == DS18B20_Result_Ok);
+	TEST_CHECK(ds.state == DS18b20_State_Finished);
+}
+
+static void testEeprom(void)
+{
+	DS18B20_Byte user[2] = { 0x12, 0x34 };
+
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000AABBCCDDEE28ULL, 0x0191);
+
+	ds18b20SetResolution(&ds, DS18B20_Resolution_10, user, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(dev->scratchpad[2] == 0x12 && dev->scratchpad[3] == 0x34 && dev->scratchpad[4] == DS18B20_Resolution_10);
+	TEST_CHECK(dev->eeprom[0] == 0x4B);
+
+	// Copy holds strong pullup while EEPROM is written
+	ds18b20CopyScratchpad(&ds, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(memcmp(dev->eeprom, dev->scratchpad + 2, 3) == 0);
+	TEST_CHECK(simBuses[0].pullupTime >= DS18B20_COPY_TIME);
+
+	dev->scratchpad[2] = 0;
+	dev->busyTime = 500;
+	ds18b20RecallEeprom(&ds, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(dev->scratchpad[2] == 0x12);
+
+	// Recall which never signals completion
+	dev->busyTime = SIM_FOREVER;
+	ds18b20RecallEeprom(&ds, dev->rom);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Error);
+}
+
+static void testPowerSupply(void)
+{
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000AABBCCDDEE28ULL, 0x0191);
+	ds.onOperationFinished = onFinished;
+
+	// Answer is a single read slot after reset, Skip ROM and the command
+	for (int i = 0; i < 2; ++i)
+	{
+		dev->parasitic = i;
+		simBuses[0].slots = 0;
+		TEST_CHECK(ds18b20ReadPowerSupply(&ds) == DS18B20_Result_Ok);
+		simRunDs18b20(&ds);
+		TEST_CHECK(ds.error == DS18b20_Success);
+		TEST_CHECK(simBuses[0].slots == 8 + 8 + 1);
+		TEST_CHECK(lastFlags == (i ? DS18B20_Callback_Parasitic : DS18B20_Callback_NoParasitic));
+	}
+
+	// Slots after the first one are not driven by the sensor any more
+	TEST_CHECK(dev->state == Sim_Device_Idle);
+
+	// No sensor answering reset
+	dev->present = OneWire_False;
+	lastFlags = DS18B20_Callback_Parasitic;
+	ds18b20ReadPowerSupply(&ds);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Error);
+	TEST_CHECK(lastFlags == DS18B20_Callback_Normal);
+}
+
+int main(void)
+{
+	TEST_RUN(testReadScratchpad);
+	TEST_RUN(testReadRom);
+	TEST_RUN(testConvert);
+	TEST_RUN(testConvertRandom);
+	TEST_RUN(testSample);
+	TEST_RUN(testEeprom);
+	TEST_RUN(testPowerSupply);
+
+	return testSummary();
+}
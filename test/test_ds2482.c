@@ -0,0 +1,256 @@
+#include "sim_ds2482.h"
+#include "test.h"
+
+#include <string.h>
+
+// Private variables
+
+static DS2482 bridge;
+static DS2482_Channel channels[DS2482_CHANNELS_800];
+static OneWire ows[DS2482_CHANNELS_800];
+
+// Private functions
+
+static void setup(DS2482_Byte count)
+{
+	simReset();
+	simInitDs2482(&bridge, count, 0);
+	for (DS2482_Byte i = 0; i < count; ++i)
+		simInitDs2482Channel(&channels[i], &bridge, i, &ows[i]);
+}
+
+static OneWire_Result readRom(OneWire *ow, OneWire_Byte *rom)
+{
+	OneWire_Byte command = DS18B20_READ_ROM;
+
+	onewireStart(ow);
+	if (simRun(ow) != OneWire_Success)
+		return OneWire_Failed;
+	onewireWrite(ow, &command, 1);
+	if (simRun(ow) != OneWire_Success)
+		return OneWire_Failed;
+	memset(rom, 0, 8);
+	onewireRead(ow, rom, 8);
+	return simRun(ow);
+}
+
+static OneWire_Result runTriplet(OneWire *ow)
+{
+	OneWire_Result res;
+
+	while ((res = ds2482Transport.triplet(ow)) == OneWire_Working)
+		;
+	return res;
+}
+
+// Tests
+
+static void testReset(void)
+{
+	setup(DS2482_CHANNELS_100);
+
+	// First reset resets and configures the bridge, 1-Wire reset then reports no presence
+	onewireStart(&ows[0]);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+	TEST_CHECK(!ows[0].presence);
+	TEST_CHECK(simDs2482.commands[DS2482_DEVICE_RESET] == 1);
+	TEST_CHECK(simDs2482.commands[DS2482_WRITE_CONFIG] == 1);
+	TEST_CHECK(simDs2482.config == DS2482_CONFIG_APU);
+	TEST_CHECK(!(simDs2482Status() & DS2482_STATUS_RST));
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_RESET] == 1);
+
+	// Later resets only reset the bus, status is polled until 1WB clears
+	simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+	long transfers = simDs2482.transfers;
+	onewireStart(&ows[0]);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+	TEST_CHECK(ows[0].presence);
+	TEST_CHECK(simDs2482.commands[DS2482_DEVICE_RESET] == 1);
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_RESET] == 2);
+	TEST_CHECK(simDs2482.transfers - transfers > 2);
+	TEST_CHECK(simBuses[0].resets == 2);
+
+	TEST_CHECK(simDs2482.invalid == 0 && simDs2482.busyCommands == 0);
+}
+
+static void testByte(void)
+{
+	OneWire_Byte rom[8];
+	OneWire_Byte bits = 0;
+
+	setup(DS2482_CHANNELS_100);
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	TEST_CHECK(readRom(&ows[0], rom) == OneWire_Success);
+	for (int i = 0; i < 8; ++i)
+		TEST_CHECK(rom[i] == ((dev->rom >> (i * 8)) & 0xFF));
+	TEST_CHECK(onewireGetCrc(&ows[0]) == 0);
+
+	// Whole bytes use byte commands, data register is read after each
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_WRITE_BYTE] == 1);
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_READ_BYTE] == 8);
+	TEST_CHECK(simDs2482.commands[DS2482_SET_READ_POINTER] == 8);
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_SINGLE_BIT] == 0);
+	TEST_CHECK(simBuses[0].slots == 8 + 64);
+
+	// Single bits use single bit command, idle bus reads 1
+	onewireReadBit(&ows[0], &bits);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+	TEST_CHECK(bits == 1);
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_SINGLE_BIT] == 1);
+
+	TEST_CHECK(simDs2482.invalid == 0 && simDs2482.busyCommands == 0);
+}
+
+static void testTriplet(void)
+{
+	OneWire_Byte command = DS18B20_SEARCH_ROM;
+	OneWire_Address found = 0;
+
+	setup(DS2482_CHANNELS_100);
+	// Addresses agree in the family code and first differ at bit 8
+	SimDevice *a = simAddDevice(0, 0x0000000000000128ULL, 0x0191);
+	SimDevice *b = simAddDevice(0, 0x0000000000000228ULL, 0x0191);
+
+	onewireStart(&ows[0]);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+	onewireWrite(&ows[0], &command, 1);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+
+	for (int i = 0; i < 64; ++i)
+	{
+		OneWire_Bool bit = (a->rom >> i) & 0x01;
+
+		// Take direction 1 at the discrepancy, which is the way to device a
+		ows[0].searchHelper = i == 8;
+		TEST_CHECK(runTriplet(&ows[0]) == OneWire_Success);
+
+		// SBR to bit 0, TSB to bit 1, DIR to bit 2
+		if (i == 8)
+			TEST_CHECK(ows[0].searchHelper == 0x04);
+		else if (i < 8)
+			TEST_CHECK(ows[0].searchHelper == (bit | (!bit << 1) | (bit << 2)));
+
+		found |= (OneWire_Address)((ows[0].searchHelper >> 2) & 0x01) << i;
+	}
+	TEST_CHECK(found == a->rom);
+	TEST_CHECK(b->state == Sim_Device_Idle);
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_TRIPLET] == 64);
+	TEST_CHECK(simBuses[0].slots == 8 + 64 * 3);
+
+	// Whole search takes a triplet per ROM bit
+	OneWire_Address roms[4];
+	OneWire_RomTable table = { roms, 4, 0, 0, OneWire_False };
+	onewireSearchTable(&ows[0], &table, OneWire_False, 0);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Success);
+	TEST_CHECK(table.count == 2 && table.rejected == 0);
+	TEST_CHECK((roms[0] == a->rom && roms[1] == b->rom) || (roms[0] == b->rom && roms[1] == a->rom));
+	TEST_CHECK(simDs2482.commands[DS2482_1WIRE_TRIPLET] == 64 + 2 * 64);
+
+	TEST_CHECK(simDs2482.invalid == 0 && simDs2482.busyCommands == 0);
+}
+
+static void testChannels(void)
+{
+	static const int order[] = { 5, 2, 2, 7, 0 };
+	OneWire_Byte rom[8];
+
+	setup(DS2482_CHANNELS_800);
+	for (int i = 0; i < DS2482_CHANNELS_800; ++i)
+		simAddDevice(i, 0x0000000000000028ULL | ((OneWire_Address)(i + 1) << 8), 0x0191);
+
+	// Device reset selects channel 0, any other channel is selected and its read code checked
+	long selects = 0;
+	for (unsigned i = 0; i < sizeof(order) / sizeof(order[0]); ++i)
+	{
+		int c = order[i];
+		long before = simDs2482.commands[DS2482_CHANNEL_SELECT];
+
+		TEST_CHECK(readRom(&ows[c], rom) == OneWire_Success);
+		TEST_CHECK(rom[0] == 0x28 && rom[1] == c + 1);
+		TEST_CHECK(simDs2482.channel == c);
+		TEST_CHECK(simBuses[c].resets == (c == 2 ? (long)i : 1));
+
+		selects += simDs2482.commands[DS2482_CHANNEL_SELECT] - before;
+		TEST_CHECK(simDs2482.commands[DS2482_CHANNEL_SELECT] - before == (i == 0 || order[i] != order[i - 1]));
+	}
+	TEST_CHECK(selects == 4);
+
+	// Wrong read code fails the reset, the next one starts over with device reset
+	simDs2482.channelReadCode = 0xFF;
+	onewireStart(&ows[3]);
+	TEST_CHECK(simRun(&ows[3]) == OneWire_Failed);
+	TEST_CHECK(!bridge.configured);
+	TEST_CHECK(simBuses[3].resets == 0);
+
+	simDs2482.channelReadCode = 0;
+	TEST_CHECK(readRom(&ows[3], rom) == OneWire_Success);
+	TEST_CHECK(rom[1] == 4);
+	TEST_CHECK(simDs2482.commands[DS2482_DEVICE_RESET] == 2);
+
+	TEST_CHECK(simDs2482.invalid == 0 && simDs2482.busyCommands == 0);
+}
+
+static void testPullup(void)
+{
+	DS18B20 ds;
+	OneWire_Byte bytes[3] = { 0x4B, 0x46, 0x3F };
+
+	setup(DS2482_CHANNELS_100);
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ows[0]);
+
+	TEST_CHECK(ds18b20WriteScratchpad(&ds, bytes, 3, dev->rom) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(simDs2482.pullups == 0);
+
+	// SPU is set right before the command byte, so the pullup follows it and lasts the whole copy
+	long configs = simDs2482.commands[DS2482_WRITE_CONFIG];
+	TEST_CHECK(ds18b20CopyScratchpad(&ds, dev->rom) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+	TEST_CHECK(memcmp(dev->eeprom, bytes, 3) == 0);
+	TEST_CHECK(simDs2482.pullups == 1);
+	TEST_CHECK(simBuses[0].pullupTime >= DS18B20_COPY_TIME);
+	TEST_CHECK(simBuses[0].pullupTime < DS18B20_COPY_TIME + 1000);
+
+	// And is cleared again
+	TEST_CHECK(simDs2482.commands[DS2482_WRITE_CONFIG] - configs == 2);
+	TEST_CHECK(simDs2482.config == DS2482_CONFIG_APU);
+	TEST_CHECK(!simDs2482.pullup);
+
+	TEST_CHECK(simDs2482.invalid == 0 && simDs2482.busyCommands == 0);
+}
+
+static void testI2cFailure(void)
+{
+	OneWire_Byte rom[8];
+
+	setup(DS2482_CHANNELS_100);
+	simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+	TEST_CHECK(readRom(&ows[0], rom) == OneWire_Success);
+
+	// Transfer which is not acknowledged fails the operation
+	simDs2482.failTransfer = simDs2482.transfers + 3;
+	TEST_CHECK(readRom(&ows[0], rom) == OneWire_Failed);
+	TEST_CHECK(readRom(&ows[0], rom) == OneWire_Success);
+	TEST_CHECK(onewireGetCrc(&ows[0]) == 0);
+
+	// Bridge at another address never answers
+	simDs2482.address = DS2482_ADDRESS + 1;
+	onewireStart(&ows[0]);
+	TEST_CHECK(simRun(&ows[0]) == OneWire_Failed);
+}
+
+int main(void)
+{
+	TEST_RUN(testReset);
+	TEST_RUN(testByte);
+	TEST_RUN(testTriplet);
+	TEST_RUN(testChannels);
+	TEST_RUN(testPullup);
+	TEST_RUN(testI2cFailure);
+
+	return testSummary();
+}
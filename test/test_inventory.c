@@ -0,0 +1,295 @@
+#include "ds18b20_inventory.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def SENSORS capacity of the tables */
+#define SENSORS 20
+
+/** @def RECORD_OFFSET(n) storage offset of record n */
+#define RECORD_OFFSET(n) (DS18B20_INVENTORY_HEADER_SIZE + (n) * DS18B20_INVENTORY_RECORD_SIZE)
+
+// Private variables
+
+static OneWire_Address roms[SENSORS];
+static OneWire_RomTable table;
+static DS18B20_InventoryEntry entries[SENSORS];
+static DS18B20_Inventory inv;
+
+static OneWire_Address loadedRoms[SENSORS];
+static OneWire_RomTable loadedTable;
+static DS18B20_InventoryEntry loadedEntries[SENSORS];
+static DS18B20_Inventory loaded;
+
+static FILE *storage;
+static int workingCalls;
+static int pending;
+static int transfers;
+static DS18B20_StorageOffset lastOffset;
+
+// Private functions
+
+/**
+ * @brief Storage hook on a file, each transfer reports OneWire_Working `workingCalls` times before it is done
+ */
+static OneWire_Result fileTransfer(DS18B20_Inventory *i, DS18B20_StorageOffset offset, DS18B20_Byte *data, DS18B20_Size length, OneWire_Bool write)
+{
+	FILE *file = i->storageData;
+
+	if (pending < 0)
+		pending = workingCalls;
+	if (pending > 0)
+	{
+		--pending;
+		return OneWire_Working;
+	}
+	pending = -1;
+
+	++transfers;
+	lastOffset = offset;
+	if (fseek(file, (long)offset, SEEK_SET) != 0)
+		return OneWire_Failed;
+
+	size_t done = write ? fwrite(data, 1, length, file) : fread(data, 1, length, file);
+	return done == length ? OneWire_Success : OneWire_Failed;
+}
+
+static OneWire_Result fileWrite(DS18B20_Inventory *i, DS18B20_StorageOffset offset, DS18B20_Byte *data, DS18B20_Size length)
+{
+	return fileTransfer(i, offset, data, length, OneWire_True);
+}
+
+static OneWire_Result fileRead(DS18B20_Inventory *i, DS18B20_StorageOffset offset, DS18B20_Byte *data, DS18B20_Size length)
+{
+	return fileTransfer(i, offset, data, length, OneWire_False);
+}
+
+static OneWire_Result failingWrite(DS18B20_Inventory *i, DS18B20_StorageOffset offset, DS18B20_Byte *data, DS18B20_Size length)
+{
+	(void)i;
+	(void)data;
+	(void)length;
+	return offset < RECORD_OFFSET(2) ? OneWire_Success : OneWire_Failed;
+}
+
+static OneWire_Address makeRom(unsigned serial)
+{
+	OneWire_Byte bytes[8] = { DS18B20_FAMILY_CODE, serial & 0xFF, (serial >> 8) & 0xFF, 0x5A, 0xA5, 0x3C, 0x00, 0 };
+	OneWire_Address rom = 0;
+
+	bytes[7] = onewireCrc(bytes, 8);
+	for (int i = 0; i < 8; ++i)
+		rom |= (OneWire_Address)bytes[i] << (i * 8);
+	return rom;
+}
+
+static void setup(int count)
+{
+	storage = tmpfile();
+	workingCalls = 0;
+	pending = -1;
+
+	onewireRomTableInit(&table, roms, SENSORS);
+	for (int i = 0; i < count; ++i)
+		onewireRomTableInsert(&table, makeRom(0x1234u * (unsigned)(i + 1)));
+	for (int i = 0; i < table.count; ++i)
+	{
+		entries[i].resolution = (DS18B20Resolution)(DS18B20_Resolution_9 + (i % 4) * 0x20);
+		entries[i].userBytes[0] = (DS18B20_Byte)i;
+		entries[i].userBytes[1] = (DS18B20_Byte)(0xF0 - i);
+	}
+	ds18b20InventoryInit(&inv, &table, entries, fileWrite, fileRead);
+	inv.storageData = storage;
+
+	onewireRomTableInit(&loadedTable, loadedRoms, SENSORS);
+	memset(loadedEntries, 0, sizeof(loadedEntries));
+	ds18b20InventoryInit(&loaded, &loadedTable, loadedEntries, fileWrite, fileRead);
+	loaded.storageData = storage;
+}
+
+static OneWire_Result run(DS18B20_Inventory *i, int *calls)
+{
+	OneWire_Result res;
+
+	*calls = 0;
+	transfers = 0;
+	do
+	{
+		res = ds18b20InventoryProcess(i);
+		++*calls;
+	} while (res == OneWire_Working);
+
+	return res;
+}
+
+static OneWire_Result save(void)
+{
+	int calls;
+
+	ds18b20InventorySave(&inv);
+	return run(&inv, &calls);
+}
+
+static OneWire_Result load(void)
+{
+	int calls;
+
+	ds18b20InventoryLoad(&loaded);
+	return run(&loaded, &calls);
+}
+
+static void poke(long offset, DS18B20_Byte value)
+{
+	fseek(storage, offset, SEEK_SET);
+	fputc(value, storage);
+}
+
+static DS18B20_Byte peek(long offset)
+{
+	fseek(storage, offset, SEEK_SET);
+	return (DS18B20_Byte)fgetc(storage);
+}
+
+/**
+ * @brief Check that loading fails while reading the part at given offset and leaves the table empty
+ */
+static void checkRejected(DS18B20_StorageOffset offset)
+{
+	TEST_CHECK(load() == OneWire_Failed);
+	TEST_CHECK(lastOffset == offset);
+	TEST_CHECK(loadedTable.count == 0);
+	TEST_CHECK(loaded.state == DS18B20_Inventory_Idle);
+}
+
+// Tests
+
+static void testRoundTrip(void)
+{
+	int calls;
+
+	setup(SENSORS);
+	TEST_CHECK(table.count == SENSORS);
+
+	// Hook is busy for 3 calls of every transfer - header, records and CRC
+	workingCalls = 3;
+	ds18b20InventorySave(&inv);
+	TEST_CHECK(run(&inv, &calls) == OneWire_Success);
+	TEST_CHECK(transfers == SENSORS + 2);
+	TEST_CHECK(calls == (SENSORS + 2) * 4);
+	fseek(storage, 0, SEEK_END);
+	TEST_CHECK(ftell(storage) == DS18B20_INVENTORY_SIZE(SENSORS));
+	TEST_CHECK(peek(0) == 'D' && peek(1) == 'S' && peek(2) == DS18B20_INVENTORY_VERSION);
+
+	ds18b20InventoryLoad(&loaded);
+	TEST_CHECK(run(&loaded, &calls) == OneWire_Success);
+	TEST_CHECK(calls == (SENSORS + 2) * 4);
+	TEST_CHECK(loadedTable.count == SENSORS);
+	TEST_CHECK(memcmp(loadedRoms, roms, sizeof(roms)) == 0);
+	for (int i = 0; i < SENSORS; ++i)
+	{
+		TEST_CHECK(loadedEntries[i].resolution == entries[i].resolution);
+		TEST_CHECK(loadedEntries[i].userBytes[0] == entries[i].userBytes[0]);
+		TEST_CHECK(loadedEntries[i].userBytes[1] == entries[i].userBytes[1]);
+	}
+
+	TEST_CHECK(ds18b20InventoryProcess(&loaded) == OneWire_NothingToDo);
+	fclose(storage);
+
+	// Empty inventory is a header and CRC
+	setup(0);
+	TEST_CHECK(save() == OneWire_Success);
+	fseek(storage, 0, SEEK_END);
+	TEST_CHECK(ftell(storage) == DS18B20_INVENTORY_SIZE(0));
+	loadedTable.count = 5;
+	TEST_CHECK(load() == OneWire_Success);
+	TEST_CHECK(loadedTable.count == 0);
+	fclose(storage);
+}
+
+static void testRejected(void)
+{
+	const DS18B20_StorageOffset crcOffset = RECORD_OFFSET(SENSORS);
+
+	setup(SENSORS);
+	TEST_CHECK(save() == OneWire_Success);
+	TEST_CHECK(load() == OneWire_Success);
+
+	// Bad magic
+	poke(0, 'X');
+	checkRejected(0);
+	poke(0, 'D');
+
+	// Other version
+	poke(2, DS18B20_INVENTORY_VERSION + 1);
+	checkRejected(0);
+	poke(2, DS18B20_INVENTORY_VERSION);
+
+	// ROM of record 5 fails its CRC8
+	DS18B20_Byte b = peek(RECORD_OFFSET(5) + 3);
+	poke(RECORD_OFFSET(5) + 3, b ^ 0x01);
+	checkRejected(RECORD_OFFSET(5));
+	poke(RECORD_OFFSET(5) + 3, b);
+
+	// Settings byte changed, only CRC16 catches it
+	b = peek(RECORD_OFFSET(7) + 9);
+	poke(RECORD_OFFSET(7) + 9, b ^ 0x80);
+	checkRejected(crcOffset);
+	poke(RECORD_OFFSET(7) + 9, b);
+
+	// Stored CRC16 damaged
+	b = peek(crcOffset + 1);
+	poke(crcOffset + 1, b ^ 0x01);
+	checkRejected(crcOffset);
+	poke(crcOffset + 1, b);
+
+	TEST_CHECK(load() == OneWire_Success);
+
+	// Records 3 and 4 swapped, record 4 is found out of order
+	DS18B20_Byte r3[DS18B20_INVENTORY_RECORD_SIZE], r4[DS18B20_INVENTORY_RECORD_SIZE];
+	fseek(storage, RECORD_OFFSET(3), SEEK_SET);
+	TEST_CHECK(fread(r3, 1, sizeof(r3), storage) == sizeof(r3));
+	TEST_CHECK(fread(r4, 1, sizeof(r4), storage) == sizeof(r4));
+	fseek(storage, RECORD_OFFSET(3), SEEK_SET);
+	fwrite(r4, 1, sizeof(r4), storage);
+	fwrite(r3, 1, sizeof(r3), storage);
+	checkRejected(RECORD_OFFSET(4));
+	fseek(storage, RECORD_OFFSET(3), SEEK_SET);
+	fwrite(r3, 1, sizeof(r3), storage);
+	fwrite(r4, 1, sizeof(r4), storage);
+
+	// Duplicate record
+	fseek(storage, RECORD_OFFSET(4), SEEK_SET);
+	fwrite(r3, 1, sizeof(r3), storage);
+	checkRejected(RECORD_OFFSET(4));
+	fseek(storage, RECORD_OFFSET(4), SEEK_SET);
+	fwrite(r4, 1, sizeof(r4), storage);
+
+	// More records than the table holds
+	loadedTable.capacity = SENSORS - 1;
+	checkRejected(0);
+	loadedTable.capacity = SENSORS;
+
+	// Storage shorter than the inventory
+	TEST_CHECK(load() == OneWire_Success);
+	fclose(storage);
+	storage = tmpfile();
+	loaded.storageData = storage;
+	checkRejected(0);
+
+	// Failed write ends saving
+	ds18b20InventoryInit(&inv, &table, entries, failingWrite, fileRead);
+	TEST_CHECK(save() == OneWire_Failed);
+	TEST_CHECK(inv.state == DS18B20_Inventory_Idle);
+	fclose(storage);
+}
+
+int main(void)
+{
+	TEST_RUN(testRoundTrip);
+	TEST_RUN(testRejected);
+
+	return testSummary();
+}
@@ -0,0 +1,175 @@
+#include "sim.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def BUS_MASK 25 of 32 buses are driven */
+#define BUS_MASK 0x3FEFBDF6u
+
+/** @def EMPTY_MASK driven buses without a device */
+#define EMPTY_MASK 0x00020020u
+
+// Private variables
+
+static OneWireMulti owm;
+
+// Private functions
+
+static void setup(OneWireMulti_Port busMask)
+{
+	simReset();
+	srand(11);
+
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (!(busMask & (1u << i)) || (EMPTY_MASK & (1u << i)))
+			continue;
+
+		simAddDevice(i, (OneWire_Address)rand() << 20 | (OneWire_Address)i << 8 | DS18B20_FAMILY_CODE, (int16_t)(rand() & 0x07FF));
+	}
+
+	simInitMulti(&owm, busMask);
+}
+
+static unsigned long readScratchpads(OneWire_Byte *scratchpads)
+{
+	OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+
+	onewireMultiStart(&owm);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+	onewireMultiWrite(&owm, command, 2, 0);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+
+	unsigned long start = simTime;
+	onewireMultiRead(&owm, scratchpads, 9, 9);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+	return simTime - start;
+}
+
+// Tests
+
+static void testReset(void)
+{
+	setup(BUS_MASK);
+
+	onewireMultiStart(&owm);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+	TEST_CHECK(owm.presence == (BUS_MASK & ~EMPTY_MASK));
+
+	for (int i = 0; i < SIM_BUSES; ++i)
+		TEST_CHECK(simBuses[i].resets == ((BUS_MASK >> i) & 0x01));
+}
+
+static void testRead(void)
+{
+	OneWire_Byte scratchpads[SIM_BUSES * 9];
+
+	setup(BUS_MASK);
+	memset(scratchpads, 0, sizeof(scratchpads));
+	unsigned long readTime = readScratchpads(scratchpads);
+
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (!(BUS_MASK & (1u << i)))
+			continue;
+
+		if (EMPTY_MASK & (1u << i))
+		{
+			for (int b = 0; b < 9; ++b)
+				TEST_CHECK(scratchpads[i * 9 + b] == 0xFF);
+		}
+		else
+			TEST_CHECK(memcmp(&scratchpads[i * 9], simBuses[i].devices[0].scratchpad, 9) == 0);
+	}
+
+	TEST_CHECK(onewireMultiCrcValid(&owm) == (BUS_MASK & ~EMPTY_MASK));
+
+	// Damaged scratchpad fails CRC on its own bus only
+	simBuses[7].devices[0].scratchpad[3] ^= 0x01;
+	readScratchpads(scratchpads);
+	TEST_CHECK(onewireMultiCrcValid(&owm) == (BUS_MASK & ~EMPTY_MASK & ~(1u << 7)));
+
+	// Slots of all buses run in lockstep, a single bus takes the same time
+	setup(1u << 4);
+	unsigned long singleTime = readScratchpads(scratchpads);
+	TEST_CHECK(readTime == singleTime);
+
+	// While per-bus engines take it once per bus
+	OneWire ow;
+	OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+	unsigned long sequentialTime = 0;
+	setup(BUS_MASK);
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (!(BUS_MASK & (1u << i)))
+			continue;
+
+		simInitOneWire(&ow, i);
+		onewireStart(&ow);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+		onewireWrite(&ow, command, 2);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+		unsigned long start = simTime;
+		onewireRead(&ow, &scratchpads[i * 9], 9);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+		sequentialTime += simTime - start;
+	}
+	TEST_CHECK(sequentialTime > 20 * readTime);
+	printf("  9-byte read: 25 buses %lu us, 1 bus %lu us, 25 buses one by one %lu us\n", readTime, singleTime, sequentialTime);
+
+	// Nothing read yet
+	simInitMulti(&owm, BUS_MASK);
+	TEST_CHECK(onewireMultiCrcValid(&owm) == 0);
+}
+
+static void testWriteStride(void)
+{
+	OneWire_Byte commands[SIM_BUSES * 5];
+	OneWire_Byte scratchpads[SIM_BUSES * 9];
+
+	setup(BUS_MASK);
+
+	// Different user bytes on every bus
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		OneWire_Byte *command = &commands[i * 5];
+		command[0] = DS18B20_SKIP_ROM;
+		command[1] = DS18B20_WRITE_SCRATCHPAD;
+		command[2] = i;
+		command[3] = ~i;
+		command[4] = DS18B20_Resolution_11;
+	}
+
+	onewireMultiStart(&owm);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+	onewireMultiWrite(&owm, commands, 5, 5);
+	TEST_CHECK(simRunMulti(&owm) == OneWire_Success);
+	simSettle();
+
+	readScratchpads(scratchpads);
+	TEST_CHECK(onewireMultiCrcValid(&owm) == (BUS_MASK & ~EMPTY_MASK));
+
+	for (int i = 0; i < SIM_BUSES; ++i)
+	{
+		if (!(owm.presence & (1u << i)))
+			continue;
+
+		TEST_CHECK(scratchpads[i * 9 + 2] == i);
+		TEST_CHECK(scratchpads[i * 9 + 3] == (OneWire_Byte)~i);
+		TEST_CHECK(scratchpads[i * 9 + 4] == DS18B20_Resolution_11);
+	}
+}
+
+int main(void)
+{
+	TEST_RUN(testReset);
+	TEST_RUN(testRead);
+	TEST_RUN(testWriteStride);
+
+	return testSummary();
+}
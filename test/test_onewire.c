@@ -0,0 +1,506 @@
+#include "sim.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Private variables
+
+static OneWire_Address found[SIM_BUS_DEVICES];
+static int foundCount;
+
+// Private functions
+
+static void onFound(const OneWire *ow)
+{
+	if (foundCount < SIM_BUS_DEVICES)
+		found[foundCount] = ow->searchedAddress;
+	++foundCount;
+}
+
+static OneWire_Address randomRom(OneWire_Byte family)
+{
+	return (((OneWire_Address)rand() << 24 ^ (OneWire_Address)rand() << 8) & 0x00FFFFFFFFFFFF00ULL) | family;
+}
+
+static void addDevices(int count, OneWire_Byte family)
+{
+	for (int i = 0; i < count; ++i)
+		simAddDevice(0, randomRom(family), 0x0191);
+}
+
+static int romBefore(OneWire_Address a, OneWire_Address b)
+{
+	// Search order - the lowest differing bit decides
+	OneWire_Address diff = a ^ b;
+	return diff && !(a & diff & -diff);
+}
+
+/**
+ * @brief Check that the table holds exactly the present devices matching given family, in search order
+ */
+static int tableMatchesBus(const OneWire_RomTable *table, OneWire_Byte family)
+{
+	int expected = 0;
+
+	for (int i = 0; i < simBuses[0].count; ++i)
+	{
+		const SimDevice *dev = &simBuses[0].devices[i];
+		if (!dev->present || (family != ONEWIRE_FAMILY_ANY && (dev->rom & 0xFF) != family))
+			continue;
+
+		if (onewireRomTableFind(table, dev->rom) == ONEWIRE_ROM_NOT_FOUND)
+			return 0;
+		++expected;
+	}
+
+	for (int i = 1; i < table->count; ++i)
+	{
+		if (!romBefore(table->roms[i - 1], table->roms[i]))
+			return 0;
+	}
+
+	return table->count == expected;
+}
+
+// Tests
+
+static void testResetReadWrite(void)
+{
+	OneWire ow;
+	OneWire_Byte command = DS18B20_READ_ROM;
+	OneWire_Byte rom[8] = { 0 };
+	OneWire_Byte bit = 0;
+
+	simReset();
+	simInitOneWire(&ow, 0);
+
+	// Empty bus
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(!ow.presence);
+
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(ow.presence);
+	TEST_CHECK(simBuses[0].resets == 2);
+
+	onewireWrite(&ow, &command, 1);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	onewireRead(&ow, rom, 8);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	for (int i = 0; i < 8; ++i)
+		TEST_CHECK(rom[i] == ((dev->rom >> (i * 8)) & 0xFF));
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+	TEST_CHECK(onewireCrc(rom, 8) == rom[7]);
+
+	// Device sends nothing more, the line stays high
+	onewireReadBit(&ow, &bit);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(bit == 1);
+
+	TEST_CHECK(onewireProcess(&ow) == OneWire_NothingToDo);
+	TEST_CHECK(onewireTimeToService(&ow) == ONEWIRE_SERVICE_NONE);
+}
+
+static void testReadCrc(void)
+{
+	OneWire ow;
+	OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+	OneWire_Byte scratchpad[9];
+
+	simReset();
+	simInitOneWire(&ow, 0);
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, (int16_t)0xFC90);
+
+	for (int damaged = 0; damaged < 2; ++damaged)
+	{
+		onewireStart(&ow);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+		onewireWrite(&ow, command, 2);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+		// Buffer is not cleared by the read, bits are ORed in
+		for (int i = 0; i < 9; ++i)
+			scratchpad[i] = 0;
+		onewireRead(&ow, scratchpad, 9);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+		// Running CRC over data and CRC byte is zero only for intact data
+		TEST_CHECK((onewireGetCrc(&ow) == 0) == !damaged);
+		TEST_CHECK((onewireCrc(scratchpad, 9) == scratchpad[8]) == !damaged);
+		TEST_CHECK(scratchpad[0] == 0x90 && scratchpad[1] == 0xFC);
+
+		dev->scratchpad[6] ^= 0x20;
+	}
+
+	// Writes leave the CRC of the last read alone
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	onewireWrite(&ow, command, 2);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(onewireGetCrc(&ow) != 0);
+}
+
+static void testSearchTarget(void)
+{
+	OneWire ow;
+
+	simReset();
+	srand(2);
+	addDevices(20, DS18B20_FAMILY_CODE);
+	addDevices(5, 0x10);
+	addDevices(5, 0x22);
+	simInitOneWire(&ow, 0);
+	ow.onSearchDone = onFound;
+
+	// Full enumeration of the mixed bus
+	foundCount = 0;
+	onewireSearch(&ow, OneWire_False);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 30);
+	long fullSlots = simBuses[0].slots;
+
+	// Family code seeds the low 8 bits, other families are never walked
+	foundCount = 0;
+	simBuses[0].slots = 0;
+	onewireSearchTarget(&ow, OneWire_False, 0x10);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 5);
+	for (int i = 0; i < foundCount; ++i)
+		TEST_CHECK((found[i] & 0xFF) == 0x10);
+	TEST_CHECK(simBuses[0].slots < fullSlots / 4);
+	printf("  5 of 30 devices: %ld slots targeted, %ld slots full search\n", simBuses[0].slots, fullSlots);
+
+	foundCount = 0;
+	simBuses[0].slots = 0;
+	onewireSearchTarget(&ow, OneWire_False, DS18B20_FAMILY_CODE);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 20);
+	TEST_CHECK(simBuses[0].slots < fullSlots);
+	printf("  20 of 30 devices: %ld slots targeted, %ld slots full search\n", simBuses[0].slots, fullSlots);
+
+	// Missing family ends after the family code bits
+	foundCount = 0;
+	simBuses[0].slots = 0;
+	onewireSearchTarget(&ow, OneWire_False, 0x3B);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 0);
+	TEST_CHECK(simBuses[0].slots <= 8 + 8 * 3);
+
+	// Alarm flag is honoured, not forced
+	simBuses[0].devices[21].alarm = OneWire_True;
+	simBuses[0].devices[2].alarm = OneWire_True;
+	foundCount = 0;
+	onewireSearchTarget(&ow, OneWire_True, 0x10);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 1 && found[0] == simBuses[0].devices[21].rom);
+}
+
+static void testSearchOrder(void)
+{
+	OneWire ow;
+	OneWire_Address roms[64];
+	OneWire_RomTable table;
+
+	simReset();
+	srand(1);
+	addDevices(40, DS18B20_FAMILY_CODE);
+	simInitOneWire(&ow, 0);
+	ow.onSearchDone = onFound;
+
+	// Plain search reports every device once, in search order
+	foundCount = 0;
+	onewireSearch(&ow, OneWire_False);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(foundCount == 40);
+	for (int i = 1; i < foundCount && i < SIM_BUS_DEVICES; ++i)
+		TEST_CHECK(romBefore(found[i - 1], found[i]));
+
+	// Table search fills the same sequence, which is the order lookups search
+	foundCount = 0;
+	onewireRomTableInit(&table, roms, 64);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+	TEST_CHECK(!table.overflow && !table.rejected);
+	for (int i = 0; i < table.count && i < foundCount; ++i)
+	{
+		TEST_CHECK(table.roms[i] == found[i]);
+		TEST_CHECK(onewireRomTableFind(&table, found[i]) == i);
+	}
+	TEST_CHECK(onewireRomTableFind(&table, found[0] ^ 0x0000100000000000ULL) == ONEWIRE_ROM_NOT_FOUND);
+
+	// Duplicates are not inserted, other ROMs land in search order
+	OneWire_Count count = table.count;
+	TEST_CHECK(!onewireRomTableInsert(&table, found[5]));
+	TEST_CHECK(onewireRomTableInsert(&table, 0x0000000000000028ULL));
+	TEST_CHECK(table.count == count + 1);
+	for (int i = 1; i < table.count; ++i)
+		TEST_CHECK(romBefore(table.roms[i - 1], table.roms[i]));
+
+	// Full table keeps the first ROMs found and reports overflow
+	onewireRomTableInit(&table, roms, 10);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(table.count == 10 && table.overflow);
+	for (int i = 0; i < table.count; ++i)
+		TEST_CHECK(table.roms[i] == found[i]);
+	TEST_CHECK(!onewireRomTableInsert(&table, 0x0000000000000028ULL));
+
+	// ROM with damaged CRC byte is found, but rejected
+	simBuses[0].devices[7].rom ^= 0x0100000000000000ULL;
+	onewireRomTableInit(&table, roms, 64);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(table.count == 39 && table.rejected == 1 && !table.overflow);
+	TEST_CHECK(onewireRomTableFind(&table, simBuses[0].devices[7].rom) == ONEWIRE_ROM_NOT_FOUND);
+	simBuses[0].devices[7].rom ^= 0x0100000000000000ULL;
+
+	// Alarm search finds flagged devices only
+	simBuses[0].devices[3].alarm = OneWire_True;
+	simBuses[0].devices[17].alarm = OneWire_True;
+	onewireRomTableInit(&table, roms, 64);
+	onewireSearchTable(&ow, &table, OneWire_True, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(table.count == 2);
+	TEST_CHECK(onewireRomTableFind(&table, simBuses[0].devices[3].rom) != ONEWIRE_ROM_NOT_FOUND);
+	TEST_CHECK(onewireRomTableFind(&table, simBuses[0].devices[17].rom) != ONEWIRE_ROM_NOT_FOUND);
+}
+
+static void testVerify(void)
+{
+	OneWire ow;
+	OneWire_Address roms[32];
+	OneWire_RomTable table;
+	OneWire_Byte bitmap[4] = { 0 };
+
+	simReset();
+	srand(3);
+	addDevices(20, DS18B20_FAMILY_CODE);
+	simInitOneWire(&ow, 0);
+	onewireRomTableInit(&table, roms, 32);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	// Present device costs a single search pass instead of a full enumeration
+	simBuses[0].slots = 0;
+	onewireVerify(&ow, table.roms[7]);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simBuses[0].slots == ONEWIRE_SEARCH_PASS_SLOTS);
+
+	// Missing device is rejected at first divergence
+	simBuses[0].slots = 0;
+	onewireVerify(&ow, table.roms[7] ^ 0x0000010000000000ULL);
+	TEST_CHECK(simRun(&ow) == OneWire_Failed);
+	TEST_CHECK(simBuses[0].slots < ONEWIRE_SEARCH_PASS_SLOTS);
+
+	simBuses[0].devices[3].present = OneWire_False;
+	simBuses[0].devices[11].present = OneWire_False;
+	simBuses[0].slots = 0;
+	onewireVerifyTable(&ow, &table, bitmap);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	for (int i = 0; i < table.count; ++i)
+	{
+		OneWire_Bool present = OneWire_False;
+		for (int d = 0; d < simBuses[0].count; ++d)
+		{
+			if (simBuses[0].devices[d].rom == table.roms[i])
+				present = simBuses[0].devices[d].present;
+		}
+		TEST_CHECK(((bitmap[i >> 3] >> (i & 0x07)) & 0x01) == present);
+	}
+	TEST_CHECK(simBuses[0].slots < table.count * ONEWIRE_SEARCH_PASS_SLOTS);
+	printf("  20 devices, 2 missing: %ld slots verified, %d slots full search\n",
+		simBuses[0].slots, table.count * ONEWIRE_SEARCH_PASS_SLOTS);
+
+	// Empty table finishes without bus activity
+	simBuses[0].slots = 0;
+	simBuses[0].resets = 0;
+	table.count = 0;
+	onewireVerifyTable(&ow, &table, bitmap);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simBuses[0].slots == 0 && simBuses[0].resets == 0);
+}
+
+static void testSearchUpdate(void)
+{
+	OneWire ow;
+	OneWire_Address roms[80];
+	OneWire_RomTable table;
+
+	simReset();
+	srand(7);
+	addDevices(50, DS18B20_FAMILY_CODE);
+	addDevices(10, 0x10);
+	simInitOneWire(&ow, 0);
+	onewireRomTableInit(&table, roms, 80);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+	OneWire_SlotCount fullSlots = ow.searchSlots;
+
+	// Device went missing, only its subtree is walked again
+	SimDevice *dev = &simBuses[0].devices[17];
+	OneWire_Count index = onewireRomTableFind(&table, dev->rom);
+	OneWire_Size depth = onewireRomTableSubtree(&table, index);
+	TEST_CHECK(depth > 0);
+
+	dev->present = OneWire_False;
+	onewireSearchUpdate(&ow, &table, dev->rom, depth);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+	TEST_CHECK(table.count == 59);
+	TEST_CHECK(ow.searchSlots < fullSlots / 10);
+	printf("  60 devices: %lu slots full scan, %lu slots rescanning subtree of depth %u\n",
+		(unsigned long)fullSlots, (unsigned long)ow.searchSlots, (unsigned)depth);
+
+	dev->present = OneWire_True;
+	onewireSearchUpdate(&ow, &table, dev->rom, depth);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+	TEST_CHECK(table.count == 60);
+
+	// Whole family rescanned
+	simBuses[0].devices[55].present = OneWire_False;
+	onewireSearchUpdate(&ow, &table, 0x10, 8);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+	TEST_CHECK(table.count == 59);
+
+	onewireSearchUpdate(&ow, &table, 0, 0);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+}
+
+static void testSearchSliced(void)
+{
+	OneWire ow;
+	OneWire_Address roms[64];
+	OneWire_RomTable table;
+	OneWire_Search search;
+	const OneWire_SlotCount budgets[] = { 0, 1000 };
+
+	simReset();
+	srand(5);
+	addDevices(64, DS18B20_FAMILY_CODE);
+	simInitOneWire(&ow, 0);
+
+	// Search owning the bus until done delays a read by the whole enumeration
+	unsigned long start = simTime;
+	onewireRomTableInit(&table, roms, 64);
+	onewireSearchTable(&ow, &table, OneWire_False, ONEWIRE_FAMILY_ANY);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(table.count == 64);
+	unsigned long whole = simTime - start;
+
+	for (int b = 0; b < 2; ++b)
+	{
+		int slices = 0;
+		unsigned long worst = 0;
+		OneWire_Byte scratchpad[9];
+		OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+
+		onewireRomTableInit(&table, roms, 64);
+		onewireSearchInit(&search, &table, OneWire_False, ONEWIRE_FAMILY_ANY, budgets[b]);
+
+		while (!search.done && slices < 200)
+		{
+			long slots = simBuses[0].slots;
+			long resets = simBuses[0].resets;
+			start = simTime;
+
+			onewireSearchContinue(&ow, &search);
+			TEST_CHECK(simRun(&ow) == OneWire_Success);
+			++slices;
+
+			// Periodic read due during the slice waits only for the slots the budget allows
+			unsigned long latency = simTime - start;
+			slots = simBuses[0].slots - slots;
+			resets = simBuses[0].resets - resets;
+			TEST_CHECK(slots <= (long)budgets[b] + ONEWIRE_SEARCH_PASS_SLOTS);
+			TEST_CHECK(latency <= (unsigned long)slots * 75 + (unsigned long)resets * 1000);
+			if (latency > worst)
+				worst = latency;
+
+			// Interface is free between slices
+			onewireStart(&ow);
+			TEST_CHECK(simRun(&ow) == OneWire_Success);
+			onewireWrite(&ow, command, 2);
+			TEST_CHECK(simRun(&ow) == OneWire_Success);
+			onewireRead(&ow, scratchpad, 1);
+			TEST_CHECK(simRun(&ow) == OneWire_Success);
+			TEST_CHECK(scratchpad[0] == 0x91);
+		}
+
+		TEST_CHECK(search.done);
+		TEST_CHECK(tableMatchesBus(&table, ONEWIRE_FAMILY_ANY));
+		TEST_CHECK(budgets[b] ? slices < 64 : slices >= 64);
+		TEST_CHECK(worst < whole / 4);
+		printf("  64 devices, budget %4u slots: %3d slices, read waits at most %6lu us, %7lu us for unsliced search\n",
+			(unsigned)budgets[b], slices, worst, whole);
+
+		onewireSearchContinue(&ow, &search);
+		TEST_CHECK(ow.state == OneWire_Idle);
+	}
+}
+
+static void testTransaction(void)
+{
+	OneWire ow;
+	OneWire_Byte tx[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+	OneWire_Byte rx[9];
+	OneWire_Transaction read = { OneWire_True, tx, 2, rx, 9, 0, ONEWIRE_STOP_NO_PRESENCE };
+
+	simReset();
+	simInitOneWire(&ow, 0);
+
+	// No presence pulse stops the transaction after reset
+	onewireTransact(&ow, &read);
+	TEST_CHECK(simRun(&ow) == OneWire_Failed);
+	TEST_CHECK(simBuses[0].slots == 0);
+
+	SimDevice *dev = simAddDevice(0, 0x0000000000ABCD28ULL, 0x0191);
+
+	onewireTransact(&ow, &read);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	for (int i = 0; i < 9; ++i)
+		TEST_CHECK(rx[i] == dev->scratchpad[i]);
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+
+	// Leading strong pullup keeps its full delay
+	OneWire_Transaction hold = { OneWire_False, 0, 0, 0, 0, 5000, 0 };
+	onewireTransact(&ow, &hold);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simBuses[0].pullupTime >= 5000 && simBuses[0].pullupTime < 5100);
+
+	// Read slots are repeated while the device reports busy, one which never finishes fails
+	OneWire_Byte recall[2] = { DS18B20_SKIP_ROM, DS18B20_RECALL_EEPROM };
+	OneWire_Byte status[16];
+	OneWire_Transaction poll = { OneWire_True, recall, 2, status, 16, 0, ONEWIRE_STOP_NO_PRESENCE | ONEWIRE_STOP_NONZERO };
+
+	dev->busyTime = 300;
+	onewireTransact(&ow, &poll);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	dev->busyTime = SIM_FOREVER;
+	onewireTransact(&ow, &poll);
+	TEST_CHECK(simRun(&ow) == OneWire_Failed);
+}
+
+int main(void)
+{
+	TEST_RUN(testResetReadWrite);
+	TEST_RUN(testReadCrc);
+	TEST_RUN(testSearchTarget);
+	TEST_RUN(testSearchOrder);
+	TEST_RUN(testVerify);
+	TEST_RUN(testSearchUpdate);
+	TEST_RUN(testSearchSliced);
+	TEST_RUN(testTransaction);
+
+	return testSummary();
+}
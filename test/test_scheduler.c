@@ -0,0 +1,230 @@
+#include "sim.h"
+#include "test.h"
+#include "ds18b20_scheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private definitions
+
+/** @def SENSORS largest number of scheduled sensors */
+#define SENSORS 8
+
+/** @def CLOCK_OFFSET millisecond clock value at simulated time 0, the clock wraps 5s into every test [ms] */
+#define CLOCK_OFFSET ((DS18B20_Time)(0xFFFFFFFFUL - 5000))
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+static DS18B20_Scheduler sched;
+static DS18B20_Sensor sensors[SENSORS];
+
+static int readings[SENSORS];
+static DS18B20_Time lastReading[SENSORS];
+static DS18B20_Time longestGap[SENSORS];
+static OneWire_Bool valuesOk;
+
+static int readsWhileConverting;
+static unsigned long busyTime;
+
+// Private functions
+
+static DS18B20_Time clockMs(void)
+{
+	return CLOCK_OFFSET + (DS18B20_Time)(simTime / 1000);
+}
+
+static void onReading(DS18B20_Scheduler *s, DS18B20_Sensor *sensor)
+{
+	int i = (int)(sensor - s->sensors);
+	DS18B20_Time now = clockMs();
+
+	if (readings[i] && now - lastReading[i] > longestGap[i])
+		longestGap[i] = now - lastReading[i];
+	lastReading[i] = now;
+
+	++readings[i];
+
+	if (sensor->reading.error != DS18b20_Success || sensor->reading.raw != simBuses[0].devices[i].temperature)
+		valuesOk = OneWire_False;
+}
+
+static void setup(int count)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+
+	memset(sensors, 0, sizeof(sensors));
+	for (int i = 0; i < count; ++i)
+	{
+		sensors[i].address = simAddDevice(0, 0x0000D00000000028ULL | (OneWire_Address)(i + 1) << 20, (int16_t)(0x0100 + i * 8))->rom;
+		sensors[i].period = 1000;
+		sensors[i].resolution = DS18B20_Resolution_12;
+	}
+
+	memset(readings, 0, sizeof(readings));
+	memset(longestGap, 0, sizeof(longestGap));
+	valuesOk = OneWire_True;
+	readsWhileConverting = 0;
+	busyTime = 0;
+}
+
+static void start(int count)
+{
+	ds18b20SchedulerInit(&sched, &ds, sensors, count);
+	sched.onReading = onReading;
+}
+
+/**
+ * @brief Main loop for given time - sleeps the time reported by the driver while a job runs, otherwise until next millisecond
+ */
+static void run(unsigned long duration)
+{
+	unsigned long end = simTime + duration;
+
+	while (simTime < end)
+	{
+		unsigned long before = simTime;
+		DS18B20_SchedulerJob job = sched.job;
+
+		ds18b20SchedulerProcess(&sched, clockMs());
+
+		if (sched.job == DS18B20_Job_Read && job != DS18B20_Job_Read)
+		{
+			for (OneWire_Count i = 0; i < sched.count; ++i)
+				if (i != sched.current && sched.sensors[i].converting)
+				{
+					++readsWhileConverting;
+					break;
+				}
+		}
+
+		if (sched.job == DS18B20_Job_None)
+		{
+			simTime += 1000 - simTime % 1000;
+			continue;
+		}
+
+		DS18B20_Time wait = ds18b20TimeToService(&ds);
+		if (wait > 1 && wait != DS18B20_SERVICE_NONE)
+			simTime += wait - 1;
+		busyTime += simTime - before;
+	}
+}
+
+// Tests
+
+static void testMixedPeriods(void)
+{
+	// Fast sensors at 9 and 12 bits next to a slow one
+	setup(3);
+	sensors[1].period = 60000;
+	sensors[2].resolution = DS18B20_Resolution_9;
+	start(3);
+
+	run(185000000UL);
+
+	TEST_CHECK(valuesOk);
+	TEST_CHECK(readings[0] >= 183 && readings[0] <= 185);
+	TEST_CHECK(readings[1] == 4);
+	TEST_CHECK(readings[2] >= 183 && readings[2] <= 185);
+	TEST_CHECK(longestGap[0] <= 1000 + DS18B20_SCHEDULER_MARGIN);
+	TEST_CHECK(longestGap[1] >= 60000 - DS18B20_SCHEDULER_MARGIN && longestGap[1] <= 60000 + DS18B20_SCHEDULER_MARGIN);
+	TEST_CHECK(longestGap[2] <= 1000 + DS18B20_SCHEDULER_MARGIN);
+	for (int i = 0; i < 3; ++i)
+		TEST_CHECK(sensors[i].missed == 0);
+}
+
+static void testPipelining(void)
+{
+	// 8 sensors converting 800ms each every second only fit the bus when read while the others convert
+	setup(SENSORS);
+	start(SENSORS);
+
+	run(30000000UL);
+
+	TEST_CHECK(valuesOk);
+	for (int i = 0; i < SENSORS; ++i)
+	{
+		TEST_CHECK(readings[i] >= 28 && readings[i] <= 30);
+		TEST_CHECK(sensors[i].missed == 0);
+	}
+	TEST_CHECK(readsWhileConverting > 0);
+	printf("  %d of %d reads done while another sensor converted\n", readsWhileConverting,
+		readings[0] + readings[1] + readings[2] + readings[3] + readings[4] + readings[5] + readings[6] + readings[7]);
+}
+
+static void testMissedDeadlines(void)
+{
+	setup(2);
+	start(2);
+	run(10000000UL);
+	TEST_CHECK(sensors[0].missed == 0 && sensors[1].missed == 0);
+
+	// Main loop stalls for 5.5s, the readings come late and every deadline up to them is counted as missed
+	while (sched.job != DS18B20_Job_None || sensors[0].converting)
+		run(1000);
+	DS18B20_Time deadline = sensors[0].deadline;
+	int before = readings[0];
+	simTime += 5500000UL;
+
+	while (readings[0] == before)
+		run(1000);
+
+	DS18B20_Time late = lastReading[0];
+	TEST_CHECK((int32_t)(late - deadline) > 0);
+	TEST_CHECK(sensors[0].missed == (late - deadline) / 1000 + 1);
+	TEST_CHECK((int32_t)(sensors[0].deadline - late) > 0 && sensors[0].deadline - late <= 1000);
+	TEST_CHECK(sensors[1].missed >= 5 && sensors[1].missed <= 6);
+
+	// Deadline right after the late reading is too close to convert for, the schedule is back on time after it
+	run(2000000UL);
+	OneWire_Count missed0 = sensors[0].missed, missed1 = sensors[1].missed;
+	run(10000000UL);
+	TEST_CHECK(sensors[0].missed == missed0 && sensors[1].missed == missed1);
+	TEST_CHECK(valuesOk);
+}
+
+static void testUtilisation(void)
+{
+	// Share of time with a job running matches the time measured by the main loop
+	setup(4);
+	start(4);
+	TEST_CHECK(ds18b20SchedulerUtilisation(&sched) == 0);
+	unsigned long begin = simTime;
+	run(20000000UL);
+
+	DS18B20_Time measured = (DS18B20_Time)(busyTime * 1000 / (simTime - begin));
+	DS18B20_Time reported = ds18b20SchedulerUtilisation(&sched);
+	// Scheduler counts whole milliseconds of every job, 8 jobs per second
+	TEST_CHECK(reported > 0 && reported + 10 >= measured && reported <= measured + 10);
+	printf("  4 sensors every 1s: %u per mille reported, %u per mille measured\n", (unsigned)reported, (unsigned)measured);
+
+	// Totals are halved once the total crosses 2^31 ms, their ratio stays
+	setup(0);
+	start(0);
+	ds18b20SchedulerProcess(&sched, 0);
+	sched.totalTime = 0x80000000UL - 10;
+	sched.busyTime = 0x40000000UL;
+
+	ds18b20SchedulerProcess(&sched, 20);
+	TEST_CHECK(sched.totalTime == 0x8000000AUL && sched.busyTime == 0x40000000UL);
+	TEST_CHECK(ds18b20SchedulerUtilisation(&sched) == 499);
+
+	ds18b20SchedulerProcess(&sched, 21);
+	TEST_CHECK(sched.totalTime == 0x40000006UL && sched.busyTime == 0x20000000UL);
+	TEST_CHECK(ds18b20SchedulerUtilisation(&sched) == 499);
+}
+
+int main(void)
+{
+	TEST_RUN(testMixedPeriods);
+	TEST_RUN(testPipelining);
+	TEST_RUN(testMissedDeadlines);
+	TEST_RUN(testUtilisation);
+
+	return testSummary();
+}
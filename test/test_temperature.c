@@ -0,0 +1,123 @@
+#include "ds18b20.h"
+#include "test.h"
+
+#include <math.h>
+#include <string.h>
+
+// Private variables
+
+static const DS18B20Resolution resolutions[] = {
+	DS18B20_Resolution_9, DS18B20_Resolution_10, DS18B20_Resolution_11, DS18B20_Resolution_12
+};
+
+// Private functions
+
+/**
+ * @brief Reference for masking - raw code rounded down to a multiple of the resolution step by floor division
+ */
+static int referenceMasked(int raw, int bits)
+{
+	double step = ldexp(1.0, 12 - bits);
+
+	return (int)(floor(raw / step) * step);
+}
+
+/**
+ * @brief Reference for conversion - 62.5 per LSB truncated toward zero, exact in double
+ */
+static int32_t referenceMilli(int masked)
+{
+	return (int32_t)trunc(masked * 62.5);
+}
+
+static void setScratchpad(DS18B20 *ds, int raw, DS18B20Resolution resolution)
+{
+	ds->buffer[0] = (DS18B20_Byte)(raw & 0xFF);
+	ds->buffer[1] = (DS18B20_Byte)((raw >> 8) & 0xFF);
+	ds->resolution = resolution;
+}
+
+// Tests
+
+static void testSweep(void)
+{
+	DS18B20 ds;
+
+	memset(&ds, 0, sizeof(ds));
+
+	// Every 16-bit code at every resolution, including codes the sensor never reports
+	for (int r = 0; r < 4; ++r)
+	{
+		long mismatches = 0;
+
+		for (int raw = -32768; raw <= 32767; ++raw)
+		{
+			int masked = referenceMasked(raw, 9 + r);
+
+			setScratchpad(&ds, raw, resolutions[r]);
+			if (ds18b20GetTemperatureRaw(&ds) != masked || ds18b20MaskRaw((int16_t)raw, resolutions[r]) != masked)
+				++mismatches;
+			if (ds18b20GetTemperatureMilli(&ds) != referenceMilli(masked) || ds18b20RawToMilli((int16_t)raw) != referenceMilli(raw))
+				++mismatches;
+		}
+
+		TEST_CHECK(mismatches == 0);
+	}
+
+	// Data sheet examples
+	const struct { int raw; int32_t milli; } points[] = {
+		{ 0x07D0, 125000 }, { 0x0550, 85000 }, { 0x0191, 25062 }, { 0x00A2, 10125 }, { 0x0008, 500 },
+		{ 0x0000, 0 }, { 0xFFF8, -500 }, { 0xFF5E, -10125 }, { 0xFE6F, -25062 }, { 0xFC90, -55000 }
+	};
+	for (size_t i = 0; i < sizeof(points) / sizeof(points[0]); ++i)
+	{
+		setScratchpad(&ds, points[i].raw, DS18B20_Resolution_12);
+		TEST_CHECK(ds18b20GetTemperatureMilli(&ds) == points[i].milli);
+	}
+
+	// Undefined bits of a 9-bit reading round toward minus infinity before the conversion
+	setScratchpad(&ds, 0xFF5F, DS18B20_Resolution_9);
+	TEST_CHECK(ds18b20GetTemperatureRaw(&ds) == (int16_t)0xFF58);
+	TEST_CHECK(ds18b20GetTemperatureMilli(&ds) == -10500);
+}
+
+#if DS18B20_FLOAT_ENABLED
+
+static void testFloat(void)
+{
+	DS18B20 ds;
+	long mismatches = 0;
+
+	memset(&ds, 0, sizeof(ds));
+
+	// Float path agrees exactly - masked codes need at most 16 significant bits and 1000x them at most 22
+	for (int r = 0; r < 4; ++r)
+	{
+		for (int raw = -32768; raw <= 32767; ++raw)
+		{
+			setScratchpad(&ds, raw, resolutions[r]);
+
+			float celsius = ds18b20GetTemperatureFloat(&ds);
+			if (celsius != ds18b20GetTemperatureRaw(&ds) / 16.0f)
+				++mismatches;
+			if ((int32_t)(celsius * 1000.0f) != ds18b20GetTemperatureMilli(&ds))
+				++mismatches;
+		}
+	}
+	TEST_CHECK(mismatches == 0);
+
+	setScratchpad(&ds, 0xFC90, DS18B20_Resolution_12);
+	TEST_CHECK(ds18b20GetTemperatureFloat(&ds) == -55.0f);
+}
+
+#endif
+
+int main(void)
+{
+	TEST_RUN(testSweep);
+#if DS18B20_FLOAT_ENABLED
+	TEST_RUN(testFloat);
+#endif
+
+	return testSummary();
+}
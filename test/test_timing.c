@@ -0,0 +1,235 @@
+#include "sim.h"
+#include "test.h"
+
+#include <string.h>
+
+// Private definitions
+
+/** @def LOOP_PERIOD time between two main loop calls of onewireProcess, far longer than a time slot [us] */
+#define LOOP_PERIOD 5000
+
+/** @def WRAP_SPAN counter values before the wrap the transfers start at, longer than a whole transfer [us] */
+#define WRAP_SPAN 7500
+
+/** @def WRAP_STEP step of the start value, so the wrap lands in every phase of every kind of slot [us] */
+#define WRAP_STEP 7
+
+// Private variables
+
+static OneWire ow;
+#if defined(ONEWIRE_FREE_RUNNING_TIMER) && !defined(ONEWIRE_TIMER_INTERRUPT)
+static OneWire ow2;
+#endif
+
+// Private functions
+
+static void setup(void)
+{
+	simReset();
+	simInitOneWire(&ow, 0);
+}
+
+/**
+ * @brief Check that every pulse on a bus since setup was within the limits of the datasheet
+ */
+static void checkBusPulses(int index)
+{
+	const SimBus *bus = &simBuses[index];
+
+	TEST_CHECK(bus->resetMin >= 480);
+	TEST_CHECK(bus->zeroMin >= 60 && bus->zeroMax <= 120);
+	TEST_CHECK(bus->oneMax >= 1 && bus->oneMax < 15);
+	TEST_CHECK(bus->sampleMax < 15);
+}
+
+static void checkPulses(void)
+{
+	checkBusPulses(0);
+}
+
+static void transfer(OneWire_Result (*run)(OneWire *ow))
+{
+	OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+	OneWire_Byte scratchpad[9];
+
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, (int16_t)0xFC90);
+
+	onewireStart(&ow);
+	TEST_CHECK(run(&ow) == OneWire_Success);
+	TEST_CHECK(ow.presence);
+
+	onewireWrite(&ow, command, 2);
+	TEST_CHECK(run(&ow) == OneWire_Success);
+
+	memset(scratchpad, 0, sizeof(scratchpad));
+	onewireRead(&ow, scratchpad, 9);
+	TEST_CHECK(run(&ow) == OneWire_Success);
+	TEST_CHECK(memcmp(scratchpad, dev->scratchpad, 9) == 0);
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+}
+
+#if defined(ONEWIRE_FREE_RUNNING_TIMER) && !defined(ONEWIRE_TIMER_INTERRUPT)
+/**
+ * @brief Run two interfaces sharing the free-running counter, calling them in turns the way a main loop would
+ */
+static void runBoth(OneWire_Result *res, OneWire_Result *res2)
+{
+	do
+	{
+		if (*res == OneWire_Working)
+			*res = onewireProcess(&ow);
+		if (*res2 == OneWire_Working)
+			*res2 = onewireProcess(&ow2);
+	} while (*res == OneWire_Working || *res2 == OneWire_Working);
+}
+#endif
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+/**
+ * @brief Main loop busy with other work, it only looks at the bus every LOOP_PERIOD while interrupts keep coming
+ */
+static OneWire_Result runBusyLoop(OneWire *ow)
+{
+	unsigned long next = simTime + LOOP_PERIOD;
+	int calls = 0;
+
+	for (;;)
+	{
+		if (simInterrupt(ow, next))
+			continue;
+
+		next += LOOP_PERIOD;
+		++calls;
+
+		OneWire_Result res = onewireProcess(ow);
+		if (res != OneWire_Working)
+		{
+			// Completion is reported once, afterwards there is nothing to pick up
+			TEST_CHECK(onewireProcess(ow) == OneWire_NothingToDo);
+			TEST_CHECK(onewireTimeToService(ow) == ONEWIRE_SERVICE_NONE);
+
+			// Whole reset or 9-byte read fits into a single loop period, the loop only picks up the result
+			TEST_CHECK(calls == 1);
+			return res;
+		}
+
+		// Main loop has nothing to do while the interrupt drives the bus
+		TEST_CHECK(onewireTimeToService(ow) == ONEWIRE_SERVICE_NONE);
+	}
+}
+#endif
+
+// Tests
+
+static void testSlotTiming(void)
+{
+	setup();
+	transfer(simRun);
+	checkPulses();
+}
+
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+
+static void testWrap(void)
+{
+	// Counter wraps somewhere within the transfer - in reset, presence detection, write 0, write 1 or read slots
+	for (unsigned long before = WRAP_SPAN; before >= WRAP_STEP; before -= WRAP_STEP)
+	{
+		setup();
+		simTime = 0x30000 - before;
+		transfer(simRun);
+		checkPulses();
+
+		// The counter is shared, nothing restarts it
+		TEST_CHECK(simBuses[0].timerStarts == 0);
+	}
+}
+
+#ifndef ONEWIRE_TIMER_INTERRUPT
+
+static void testSharedTimer(void)
+{
+	OneWire_Byte command[2] = { DS18B20_SKIP_ROM, DS18B20_READ_SCRATCHPAD };
+	OneWire_Byte scratchpad[9];
+	OneWire_Byte scratchpad2[9];
+
+	// Two buses share the free-running counter and run interleaved across its wrap
+	for (unsigned long before = 1000; before > 0; before -= 50)
+	{
+		setup();
+		simInitOneWire(&ow2, 1);
+		SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, (int16_t)0xFC90);
+		SimDevice *dev2 = simAddDevice(1, 0x0000AABBCCDDEE28ULL, 0x0191);
+		simTime = 0x30000 - before;
+
+		OneWire_Result res = OneWire_Working, res2 = OneWire_Working;
+		onewireStart(&ow);
+		onewireStart(&ow2);
+		runBoth(&res, &res2);
+		TEST_CHECK(res == OneWire_Success && res2 == OneWire_Success);
+		TEST_CHECK(ow.presence && ow2.presence);
+
+		res = res2 = OneWire_Working;
+		onewireWrite(&ow, command, 2);
+		onewireWrite(&ow2, command, 2);
+		runBoth(&res, &res2);
+
+		memset(scratchpad, 0, sizeof(scratchpad));
+		memset(scratchpad2, 0, sizeof(scratchpad2));
+		res = res2 = OneWire_Working;
+		onewireRead(&ow, scratchpad, 9);
+		onewireRead(&ow2, scratchpad2, 9);
+		runBoth(&res, &res2);
+
+		TEST_CHECK(memcmp(scratchpad, dev->scratchpad, 9) == 0);
+		TEST_CHECK(memcmp(scratchpad2, dev2->scratchpad, 9) == 0);
+		checkBusPulses(0);
+		checkBusPulses(1);
+		TEST_CHECK(simBuses[0].timerStarts == 0 && simBuses[1].timerStarts == 0);
+	}
+}
+
+#endif
+
+#endif
+
+#ifdef ONEWIRE_TIMER_INTERRUPT
+
+static void testBusyMainLoop(void)
+{
+	setup();
+	transfer(runBusyLoop);
+	checkPulses();
+}
+
+static void testLateInterrupt(void)
+{
+	// Latency longer than the shortest delays, those edges are processed right away. Write 1 pulses are stretched
+	// by the latency, 4us would already bring them to the 15us limit once the counter reads are added.
+	for (unsigned long latency = 1; latency <= 3; ++latency)
+	{
+		setup();
+		simLatency = latency;
+		transfer(simRun);
+		checkPulses();
+	}
+}
+
+#endif
+
+int main(void)
+{
+	TEST_RUN(testSlotTiming);
+#ifdef ONEWIRE_FREE_RUNNING_TIMER
+	TEST_RUN(testWrap);
+#ifndef ONEWIRE_TIMER_INTERRUPT
+	TEST_RUN(testSharedTimer);
+#endif
+#endif
+#ifdef ONEWIRE_TIMER_INTERRUPT
+	TEST_RUN(testBusyMainLoop);
+	TEST_RUN(testLateInterrupt);
+#endif
+
+	return testSummary();
+}
@@ -0,0 +1,129 @@
+#include "sim.h"
+#include "test.h"
+
+#include <string.h>
+
+// Private variables
+
+static OneWire ow;
+static DS18B20 ds;
+
+// Private functions
+
+static void setup(OneWire_Bool triplet, int pollCalls)
+{
+	simReset();
+	simInitMock(&ow, 0, triplet);
+	simMocks[0].pollCalls = pollCalls;
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+}
+
+// Tests
+
+static void testBlocks(void)
+{
+	OneWire_Byte command = DS18B20_READ_ROM;
+	OneWire_Byte rom[8];
+
+	setup(OneWire_False, 0);
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(ow.presence);
+
+	// Whole blocks move in a single transport call
+	onewireWrite(&ow, &command, 1);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	memset(rom, 0, sizeof(rom));
+	onewireRead(&ow, rom, 8);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	for (int i = 0; i < 8; ++i)
+		TEST_CHECK(rom[i] == ((dev->rom >> (i * 8)) & 0xFF));
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+	TEST_CHECK(simMocks[0].resets == 1 && simMocks[0].writes == 1 && simMocks[0].reads == 1);
+	TEST_CHECK(simMocks[0].calls == 3);
+	TEST_CHECK(simBuses[0].slots == 8 + 64);
+}
+
+static void testDs18b20(void)
+{
+	// Same driver calls work on a transport completing at once and on one which has to be polled
+	for (int pollCalls = 0; pollCalls <= 3; pollCalls += 3)
+	{
+		setup(OneWire_False, pollCalls);
+		SimDevice *dev = simAddDevice(0, 0x0000AABBCCDDEE28ULL, 0x0191);
+		simAddDevice(0, 0x0000112233445528ULL, (int16_t)0xFF5E);
+		dev->temperature = (int16_t)0xFC90;
+
+		TEST_CHECK(ds18b20BeginConversion(&ds, dev->rom) == DS18B20_Result_Ok);
+		simRunDs18b20(&ds);
+		TEST_CHECK(ds.error == DS18b20_Success);
+
+		TEST_CHECK(ds18b20ReadScratchpad(&ds, dev->rom) == DS18B20_Result_Ok);
+		simRunDs18b20(&ds);
+		TEST_CHECK(ds18b20VerifyCrc(&ds));
+		TEST_CHECK(memcmp(ds.buffer, dev->scratchpad, 9) == 0);
+		TEST_CHECK(ds18b20GetTemperatureRaw(&ds) == (int16_t)0xFC90);
+
+		// Every completed operation took pollCalls extra calls
+		long ops = simMocks[0].resets + simMocks[0].writes + simMocks[0].reads;
+		TEST_CHECK(simMocks[0].calls == ops * (pollCalls + 1));
+
+		// Damaged byte is caught by CRC computed by the transport
+		dev->scratchpad[2] ^= 0x01;
+		ds18b20ReadScratchpad(&ds, dev->rom);
+		simRunDs18b20(&ds);
+		TEST_CHECK(ds.error == DS18b20_Error_CRC);
+	}
+}
+
+static void testSearch(void)
+{
+	static const OneWire_Address roms[] = {
+		0x0000000000000128ULL, 0x00000000000002A8ULL, 0x0000123456789A28ULL, 0x0000FFFFFFFFFF28ULL
+	};
+	OneWire_Address found[8];
+	OneWire_RomTable table;
+
+	// Search with and without triplet operation finds the same devices
+	for (int triplet = 0; triplet < 2; ++triplet)
+	{
+		setup(triplet, 0);
+		for (unsigned i = 0; i < sizeof(roms) / sizeof(roms[0]); ++i)
+			simAddDevice(0, roms[i], 0x0191);
+
+		memset(&table, 0, sizeof(table));
+		table.roms = found;
+		table.capacity = 8;
+		onewireSearchTable(&ow, &table, OneWire_False, 0);
+		TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+		TEST_CHECK(table.count == 4 && table.rejected == 0);
+		for (unsigned i = 0; i < 4; ++i)
+		{
+			OneWire_Bool listed = OneWire_False;
+			for (unsigned j = 0; j < table.count; ++j)
+				listed |= found[j] == simBuses[0].devices[i].rom;
+			TEST_CHECK(listed);
+		}
+
+		// Every ROM bit of a pass is a single triplet instead of a two-bit read and a direction write
+		if (triplet)
+			TEST_CHECK(simMocks[0].triplets == 4 * 64 && simMocks[0].reads == 0 && simMocks[0].writes == 4);
+		else
+			TEST_CHECK(simMocks[0].triplets == 0 && simMocks[0].reads == 4 * 64 && simMocks[0].writes == 4 * 65);
+	}
+}
+
+int main(void)
+{
+	TEST_RUN(testBlocks);
+	TEST_RUN(testDs18b20);
+	TEST_RUN(testSearch);
+
+	return testSummary();
+}
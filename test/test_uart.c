@@ -0,0 +1,152 @@
+#include "sim.h"
+#include "test.h"
+
+#include <string.h>
+
+// Private variables
+
+static OneWire ow;
+
+// Private functions
+
+static void setup(void)
+{
+	simReset();
+	simInitUart(&ow, 0);
+}
+
+// Tests
+
+static void testReset(void)
+{
+	setup();
+
+	// Empty bus echoes the reset character unchanged
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(!ow.presence);
+
+	simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(ow.presence);
+
+	// Each reset is a single character at 9600 baud, time slots follow at 115200 baud
+	TEST_CHECK(simBuses[0].resets == 2);
+	TEST_CHECK(simUarts[0].resetChars == 2 && simUarts[0].slotChars == 0);
+	TEST_CHECK(simUarts[0].transfers == 2 && simUarts[0].invalid == 0);
+	TEST_CHECK(simUarts[0].baud == OneWire_Baud_115200);
+}
+
+static void testByte(void)
+{
+	OneWire_Byte command = DS18B20_READ_ROM;
+	OneWire_Byte rom[8];
+	OneWire_Byte bit = 0;
+
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	// Byte is sent as 8 characters of a single transfer
+	onewireWrite(&ow, &command, 1);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simUarts[0].transfers == 2 && simUarts[0].longestFrame == 8);
+
+	memset(rom, 0, sizeof(rom));
+	onewireRead(&ow, rom, 8);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	for (int i = 0; i < 8; ++i)
+		TEST_CHECK(rom[i] == ((dev->rom >> (i * 8)) & 0xFF));
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+
+	// Nothing more is sent, the line stays high
+	onewireReadBit(&ow, &bit);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(bit == 1);
+
+	TEST_CHECK(simUarts[0].slotChars == 8 + 64 + 1);
+	TEST_CHECK(simBuses[0].slots == 8 + 64 + 1);
+	TEST_CHECK(simUarts[0].invalid == 0);
+}
+
+static void testFrame(void)
+{
+	OneWire_Byte command[11] = { DS18B20_MATCH_ROM };
+	OneWire_Byte scratchpad[9];
+
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, (int16_t)0xFC90);
+	simAddDevice(0, 0x0000AABBCCDDEE28ULL, 0x0191);
+
+	for (int i = 0; i < 8; ++i)
+		command[1 + i] = (dev->rom >> (i * 8)) & 0xFF;
+	command[9] = DS18B20_READ_SCRATCHPAD;
+
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+
+	// Whole 10-byte command frame fits into a single transfer
+	long transfers = simUarts[0].transfers;
+	unsigned long start = simTime;
+	onewireWrite(&ow, command, 10);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simUarts[0].transfers == transfers + 1);
+	TEST_CHECK(simUarts[0].longestFrame == ONEWIRE_UART_FRAME_SIZE);
+
+	// 80 characters of 10 bits at 115200 baud
+	TEST_CHECK(simTime - start >= 6944 && simTime - start < 6944 + 10);
+
+	// Scratchpad comes back as a single 72 character transfer
+	memset(scratchpad, 0, sizeof(scratchpad));
+	onewireRead(&ow, scratchpad, 9);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simUarts[0].transfers == transfers + 2);
+	TEST_CHECK(memcmp(scratchpad, dev->scratchpad, 9) == 0);
+	TEST_CHECK(onewireGetCrc(&ow) == 0);
+
+	// Longer block is split into full frames
+	onewireStart(&ow);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	command[0] = DS18B20_SKIP_ROM;
+	transfers = simUarts[0].transfers;
+	onewireWrite(&ow, command, 11);
+	TEST_CHECK(simRun(&ow) == OneWire_Success);
+	TEST_CHECK(simUarts[0].transfers == transfers + 2);
+	TEST_CHECK(simUarts[0].invalid == 0);
+}
+
+static void testDs18b20(void)
+{
+	DS18B20 ds;
+
+	setup();
+	SimDevice *dev = simAddDevice(0, 0x0000123456789A28ULL, 0x0191);
+	dev->temperature = (int16_t)0xFE6F;
+
+	memset(&ds, 0, sizeof(DS18B20));
+	ds18b20Init(&ds, &ow);
+	ds.readMode = DS18b20_Read_CRC;
+
+	TEST_CHECK(ds18b20BeginConversion(&ds, dev->rom) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds.error == DS18b20_Success);
+
+	TEST_CHECK(ds18b20ReadScratchpad(&ds, dev->rom) == DS18B20_Result_Ok);
+	simRunDs18b20(&ds);
+	TEST_CHECK(ds18b20VerifyCrc(&ds));
+	TEST_CHECK(ds18b20GetTemperatureRaw(&ds) == (int16_t)0xFE6F);
+	TEST_CHECK(simUarts[0].invalid == 0);
+}
+
+int main(void)
+{
+	TEST_RUN(testReset);
+	TEST_RUN(testByte);
+	TEST_RUN(testFrame);
+	TEST_RUN(testDs18b20);
+
+	return testSummary();
+}